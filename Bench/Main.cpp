@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Parser/BatchParser.hpp"
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+#include "Parser/Impl/LR.hpp"
+#include "Parser/Profiler.hpp"
+
+#include "Regex/Matcher.hpp"
+
+#include "Tests/Common.hpp"
+
+// Measures how many tiny calculator messages per second a single reused session can parse, which is
+// dominated by per-parse overhead rather than by the size of the input, and how that scales when a
+// batch of them is spread across all cores.  A mode runs one of the other benchmarks instead.
+//
+// Usage: parsebench [def file] [count] [mode]
+//
+//     (none)     LALR, batched LALR and LL messages/sec
+//     actions    LALR messages/sec with reducers as std::functions and as a compile-time Actions struct
+//     profile    as above, then the LALR messages once more with profiler counters written as JSON
+//     construct  DFA construction time for keyword sets of doubling size
+//     scan       unanchored Matcher::find speed over a synthetic log
+//     tokenize   bytes/sec through a hand-written DFA table walk, Matcher::match and a tokenizer stream
+//     states     LR::computeStates time for expression grammars with a doubling number of levels
+
+static const std::vector<std::string_view> kMessages{
+    "1+2*3",
+    "(4-5)*6",
+    "7/8+9",
+    "12*(3+4)-5",
+    "42"
+};
+
+template<typename Parse> void runParse(const char *name, const Parser::Tokenizer &tokenizer, unsigned int count, Parse parse)
+{
+    long long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned int i=0; i<count; i++) {
+        Parser::Tokenizer::Stream stream(tokenizer, kMessages[i % kMessages.size()]);
+        checksum += parse(stream);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << name << ": " << (unsigned long long)(count / elapsed.count()) << " messages/sec (checksum " << checksum << ")" << std::endl;
+}
+
+template<typename Session> void run(const char *name, Session &session, const Parser::Tokenizer &tokenizer, unsigned int count)
+{
+    runParse(name, tokenizer, count, [&](Parser::Tokenizer::Stream &stream) {
+        return session.parse(stream);
+    });
+}
+
+// The calculator's reducers resolved at compile time, for LRSingle::ParseSession::parse(stream,
+// actions).  The arithmetic is the same as Tests::addCalcReducers, so the checksums must match.
+class CalcActions
+{
+public:
+    CalcActions(const Parser::Grammar &grammar)
+    : mRoot(grammar.ruleIndex("root")), mE(grammar.ruleIndex("E")), mT(grammar.ruleIndex("T")), mF(grammar.ruleIndex("F")),
+      mNumber(grammar.terminalIndex("NUMBER")), mMinus(grammar.terminalIndex("-")), mDivide(grammar.terminalIndex("/")), mLparen(grammar.terminalIndex("("))
+    {
+    }
+
+    bool hasReducer(unsigned int rule) const
+    {
+        return rule == mRoot || rule == mE || rule == mT || rule == mF;
+    }
+
+    template<typename Iterator> int reduce(unsigned int rule, Iterator begin, Iterator end)
+    {
+        if(rule == mE) {
+            unsigned int result = (unsigned int)begin->data;
+            for(auto it = begin + 1; it != end; it += 2) {
+                result = (it->index == mMinus) ? result - (unsigned int)(it + 1)->data : result + (unsigned int)(it + 1)->data;
+            }
+            return (int)result;
+        } else if(rule == mT) {
+            int result = begin->data;
+            for(auto it = begin + 1; it != end; it += 2) {
+                result = (it->index == mDivide) ? Tests::calcDivide(result, (it + 1)->data) : (int)((unsigned int)result * (unsigned int)(it + 1)->data);
+            }
+            return result;
+        } else if(rule == mF && begin->index == mLparen) {
+            return (begin + 1)->data;
+        }
+
+        return begin->data;
+    }
+
+    int decorate(unsigned int terminal, const Parser::Tokenizer::Token &token)
+    {
+        unsigned int number = 0;
+        if(terminal == mNumber) {
+            for(char c : token.text) {
+                number = number * 10 + (unsigned int)(c - '0');
+            }
+        }
+        return (int)number;
+    }
+
+private:
+    unsigned int mRoot;
+    unsigned int mE;
+    unsigned int mT;
+    unsigned int mF;
+    unsigned int mNumber;
+    unsigned int mMinus;
+    unsigned int mDivide;
+    unsigned int mLparen;
+};
+
+template<typename Session> void runBatch(const char *name, Parser::BatchParser<Session> &batchParser, unsigned int count, unsigned int threads)
+{
+    std::vector<std::string_view> inputs;
+    for(unsigned int i=0; i<count; i++) {
+        inputs.push_back(kMessages[i % kMessages.size()]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> results = batchParser.parseBatch(inputs, threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    long long checksum = 0;
+    for(int result : results) {
+        checksum += result;
+    }
+
+    std::cout << name << " batch, " << threads << " threads: " << (unsigned long long)(count / elapsed.count()) << " messages/sec (checksum " << checksum << ")" << std::endl;
+}
+
+void runConstruction()
+{
+    // Random lowercase keywords from a fixed seed, so every run builds the same automata.
+    std::vector<std::string> keywords;
+    unsigned int seed = 1;
+    auto next = [&]() {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    for(unsigned int size = 100; size <= 1600; size *= 2) {
+        while(keywords.size() < size) {
+            std::string keyword;
+            unsigned int length = 3 + next() % 6;
+            for(unsigned int i=0; i<length; i++) {
+                keyword.push_back((char)('a' + next() % 26));
+            }
+            keywords.push_back(keyword);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Regex::Matcher matcher(keywords, UINT_MAX);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Matcher, " << size << " keywords: " << matcher.dfa().numStates() << " states in " << elapsed.count() * 1000 << " ms" << std::endl;
+    }
+}
+
+void runScan()
+{
+    static const std::vector<std::string_view> kWords{"info", "request", "served", "user", "id", "ok", "latency", "ms", "path", "/api/v1"};
+
+    std::string text;
+    unsigned int seed = 1;
+    while(text.size() < (64u << 20)) {
+        text.append("2024-01-01 12:00:00 INFO");
+        for(unsigned int i=0; i<8; i++) {
+            seed = seed * 1103515245 + 12345;
+            text.push_back(' ');
+            text.append(kWords[(seed >> 16) % kWords.size()]);
+        }
+        text.push_back('\n');
+    }
+    text.append("2024-01-01 12:00:00 FATAL disk full\n");
+
+    // A shared literal prefix, a small set of first bytes, and a set too broad to skip much.
+    for(const char *pattern : {"FATAL [a-z ]+", "[#@]+[a-z]+", "[A-Z][A-Z][A-Z][A-Z][A-Z]+"}) {
+        Regex::Matcher matcher({pattern});
+        unsigned int length = 0;
+        unsigned int index = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned int found = matcher.find(text, 0, length, index);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        size_t scanned = (found == UINT_MAX) ? text.size() : found;
+        std::cout << "Find " << pattern << ": " << (unsigned long long)(scanned / elapsed.count() / (1 << 20)) << " MB/sec" << std::endl;
+    }
+}
+
+void runTokenizer(const Parser::Tokenizer &tokenizer)
+{
+    std::string text;
+    for(unsigned int i=0; text.size() < (32u << 20); i++) {
+        text.append(kMessages[i % kMessages.size()]);
+        text.push_back((i % 8 == 7) ? '\n' : ' ');
+    }
+
+    auto report = [&](const char *name, auto f) {
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long checksum = f();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << (unsigned long long)(text.size() / elapsed.count() / (1 << 20)) << " MB/sec (checksum " << checksum << ")" << std::endl;
+    };
+
+    const Regex::Matcher &matcher = tokenizer.matcher(0);
+    if(matcher.hasDFA()) {
+        report("Match, DFA table", [&]() {
+            const Regex::DFA &dfa = matcher.dfa();
+            const Regex::Encoding &encoding = matcher.encoding();
+            unsigned long long checksum = 0;
+            for(unsigned int pos=0; pos<text.size();) {
+                unsigned int state = dfa.startState();
+                unsigned int matched = 0;
+                unsigned int pattern = 0;
+                for(unsigned int i=pos; i<text.size(); i++) {
+                    Regex::Encoding::CodePoint codePoint = encoding.codePoint(text[i]);
+                    if(codePoint == Regex::Encoding::kInvalidCodePoint) {
+                        break;
+                    }
+                    state = dfa.transition(state, codePoint);
+                    if(state == dfa.rejectState()) {
+                        break;
+                    }
+                    if(dfa.accept(state, pattern)) {
+                        matched = i - pos + 1;
+                    }
+                }
+                checksum += pattern;
+                pos += std::max(matched, 1u);
+            }
+            return checksum;
+        });
+    }
+
+    report("Match, Matcher::match", [&]() {
+        unsigned long long checksum = 0;
+        for(unsigned int pos=0; pos<text.size();) {
+            unsigned int pattern = 0;
+            unsigned int matched = matcher.match(text, pos, pattern);
+            checksum += pattern;
+            pos += std::max(matched, 1u);
+        }
+        return checksum;
+    });
+
+    report("Tokenizer stream", [&]() {
+        unsigned long long checksum = 0;
+        Parser::Tokenizer::Stream stream(tokenizer, text);
+        while(stream.nextToken().value != tokenizer.endValue()) {
+            checksum += stream.nextToken().value;
+            stream.consumeToken();
+        }
+        return checksum;
+    });
+}
+
+// Exposes the LR(0) state construction shared by all of the LR parsers.
+class StateCounter : public Parser::Impl::LR
+{
+public:
+    StateCounter(const Parser::Grammar &grammar) : LR(grammar) {}
+
+    size_t numStates() const { return computeStates().size(); }
+};
+
+void runStates()
+{
+    typedef Parser::Grammar::Symbol Symbol;
+
+    for(unsigned int levels = 25; levels <= 400; levels *= 2) {
+        // <root>: <L0>, <Li>: <Li> opi <Li+1> | <Li+1>, and <Ln>: NUMBER | '(' <L0> ')'.
+        std::vector<std::string> terminals{"NUMBER", "(", ")"};
+        std::vector<Parser::Grammar::Rule> rules;
+        rules.push_back(Parser::Grammar::Rule{"root", {{Symbol{Symbol::Type::Nonterminal, 1}}}});
+        for(unsigned int i=0; i<levels; i++) {
+            unsigned int op = (unsigned int)terminals.size();
+            terminals.push_back("op" + std::to_string(i));
+            Symbol self{Symbol::Type::Nonterminal, i + 1};
+            Symbol next{Symbol::Type::Nonterminal, i + 2};
+            rules.push_back(Parser::Grammar::Rule{"L" + std::to_string(i), {{self, Symbol{Symbol::Type::Terminal, op}, next}, {next}}});
+        }
+        rules.push_back(Parser::Grammar::Rule{"L" + std::to_string(levels), {
+            {Symbol{Symbol::Type::Terminal, 0}},
+            {Symbol{Symbol::Type::Terminal, 1}, Symbol{Symbol::Type::Nonterminal, 1}, Symbol{Symbol::Type::Terminal, 2}}
+        }});
+
+        Parser::Grammar grammar(std::move(terminals), std::move(rules), 0);
+        StateCounter counter(grammar);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t numStates = counter.numStates();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "LR states, " << levels << " levels: " << numStates << " states in " << elapsed.count() * 1000 << " ms" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filename = (argc > 1) ? argv[1] : "Bench/calc.def";
+    unsigned int count = (argc > 2) ? (unsigned int)std::stoul(argv[2]) : 1000000;
+    std::string mode = (argc > 3) ? argv[3] : "";
+    bool profile = mode == "profile";
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    Parser::DefReader reader(filename);
+    if(!reader.valid()) {
+        std::cout << "Error in def file, line " << reader.parseError().line << ": " << reader.parseError().message << std::endl;
+        return 1;
+    }
+
+    if(mode == "construct") {
+        runConstruction();
+        return 0;
+    } else if(mode == "scan") {
+        runScan();
+        return 0;
+    } else if(mode == "tokenize") {
+        runTokenizer(reader.tokenizer());
+        return 0;
+    } else if(mode == "states") {
+        runStates();
+        return 0;
+    }
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    if(lalr.valid()) {
+        Parser::Impl::LALR::ParseSession<int, int> session(lalr);
+        Tests::addCalcReducers(session, reader.grammar(), [](int value) { return value; });
+        run("LALR", session, reader.tokenizer(), count);
+
+        if(mode == "actions") {
+            CalcActions actions(reader.grammar());
+            runParse("LALR actions", reader.tokenizer(), count, [&](Parser::Tokenizer::Stream &stream) {
+                return session.parse(stream, actions);
+            });
+            return 0;
+        }
+
+        Parser::BatchParser<Parser::Impl::LALR::ParseSession<int, int>> batchParser(lalr, reader.tokenizer(), [&](auto &batchSession) {
+            Tests::addCalcReducers(batchSession, reader.grammar(), [](int value) { return value; });
+        });
+        runBatch("LALR", batchParser, count, threads);
+
+        if(profile) {
+            Parser::Impl::LALR::ParseSession<int, int, Parser::Profiler> profiledSession(lalr);
+            Tests::addCalcReducers(profiledSession, reader.grammar(), [](int value) { return value; });
+            run("LALR profiled", profiledSession, reader.tokenizer(), count);
+            profiledSession.profiler().counters().writeJson(std::cout, reader.grammar());
+        }
+    }
+
+    Parser::Impl::LL ll(reader.grammar());
+    if(ll.valid()) {
+        Parser::Impl::LL::ParseSession<int, int> session(ll);
+        Tests::addCalcReducers(session, reader.grammar(), [](int value) { return value; });
+        run("LL", session, reader.tokenizer(), count);
+    }
+
+    return 0;
+}
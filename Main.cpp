@@ -1,7 +1,8 @@
 #include <iostream>
-#include <sstream>
+#include <string>
 
 #include "Parser/DefReader.hpp"
+#include "Parser/TableFile.hpp"
 #include "Parser/Impl/GLR.hpp"
 
 struct AstNode
@@ -14,14 +15,10 @@ struct AstNode
         Divide
     };
 
-    template<typename ...Children> AstNode(Type t, Children... c) : type(t)
-    {
-        children.reserve(sizeof...(c));
-        (children.push_back(std::move(c)), ...);
-    }
+    AstNode(Type t, AstNode *left = nullptr, AstNode *right = nullptr) : type(t), children{left, right} {}
 
     Type type;
-    std::vector<std::shared_ptr<AstNode>> children;
+    AstNode *children[2];
 };
 
 struct AstNodeNumber : public AstNode
@@ -50,27 +47,55 @@ int evaluate(const AstNode &node)
 
 int main(int argc, char *argv[])
 {
-    Parser::DefReader reader("grammar.def");
-    if(!reader.valid()) {
-        std::cout << "Error in def file, line " << reader.parseError().line << ": " << reader.parseError().message << std::endl;
-        return 1;
+    uint64_t defHash = Parser::TableFile::hashFile("grammar.def");
+
+    std::unique_ptr<Parser::DefReader> defReader;
+    std::unique_ptr<Parser::Impl::GLR> glr;
+    bool loaded = false;
+    {
+        // Everything is copied out of the table file, so it is closed again before it is rewritten.
+        Parser::TableFile tableFile("grammar.tables", defHash);
+        if(tableFile.valid()) {
+            defReader = std::make_unique<Parser::DefReader>(tableFile.reader());
+            glr = std::make_unique<Parser::Impl::GLR>(defReader->grammar(), tableFile.reader());
+            loaded = tableFile.reader().valid();
+        }
     }
 
-    Parser::Impl::GLR parser(reader.grammar());
-    
-    Parser::Impl::GLR::ParseSession<AstNode> session(parser);
+    if(!loaded) {
+        defReader = std::make_unique<Parser::DefReader>("grammar.def");
+        if(!defReader->valid()) {
+            std::cout << "Error in def file, line " << defReader->parseError().line << ": " << defReader->parseError().message << std::endl;
+            return 1;
+        }
+
+        glr = std::make_unique<Parser::Impl::GLR>(defReader->grammar());
 
-    session.addTerminalDecorator("NUMBER", [](const Parser::Tokenizer::Token &token) {
-        return std::make_unique<AstNodeNumber>(std::atoi(token.text.c_str()));
+        Util::BinaryWriter writer;
+        defReader->save(writer);
+        glr->save(writer);
+        if(!Parser::TableFile::write("grammar.tables", defHash, writer)) {
+            std::cout << "Warning: could not write grammar.tables" << std::endl;
+        }
+    }
+
+    const Parser::DefReader &reader = *defReader;
+    Parser::Impl::GLR &parser = *glr;
+
+    Parser::Impl::GLR::ParseSession<AstNode, AstNode*> session(parser);
+    Util::Arena &arena = session.arena();
+
+    session.addTerminalDecorator("NUMBER", [&](const Parser::Tokenizer::Token &token) -> AstNode* {
+        return arena.make<AstNodeNumber>(std::atoi(std::string(token.text).c_str()));
     });
 
     session.addReducer("root", [](auto begin, auto end) {
-        return std::move(begin->data);
+        return begin->data;
     });
     unsigned int minus = reader.grammar().terminalIndex("-");
     session.addReducer("E", [&](auto begin, auto end) {
         auto it = begin;
-        std::shared_ptr<AstNode> node = it->data;
+        AstNode *node = it->data;
         ++it;
         while(it != end) {
             AstNode::Type type = AstNode::Type::Add;
@@ -78,7 +103,7 @@ int main(int argc, char *argv[])
                 type = AstNode::Type::Subtract;
             }
             ++it;
-            node = std::make_unique<AstNode>(type, node, it->data);
+            node = arena.make<AstNode>(type, node, it->data);
             ++it;
         }
         return node;
@@ -86,7 +111,7 @@ int main(int argc, char *argv[])
     unsigned int divide = reader.grammar().terminalIndex("/");
     session.addReducer("T", [&](auto begin, auto end) {
         auto it = begin;
-        std::shared_ptr<AstNode> node = it->data;
+        AstNode *node = it->data;
         ++it;
         while(it != end) {
             AstNode::Type type = AstNode::Type::Multiply;
@@ -94,7 +119,7 @@ int main(int argc, char *argv[])
                 type = AstNode::Type::Divide;
             }
             ++it;
-            node = std::make_unique<AstNode>(type, node, it->data);
+            node = arena.make<AstNode>(type, node, it->data);
             ++it;
         }
         return node;
@@ -116,10 +141,9 @@ int main(int argc, char *argv[])
             break;
         }
 
-        std::stringstream ss(input);
-        Parser::Tokenizer::Stream stream(reader.tokenizer(), ss);
+        Parser::Tokenizer::Stream stream(reader.tokenizer(), input);
 
-        std::vector<std::shared_ptr<AstNode>> ast = session.parse(stream);
+        std::vector<AstNode*> ast = session.parse(stream);
         if(ast.size() > 0) {
             for(const auto &tree : ast) {
                 int result = evaluate(*tree);
@@ -128,6 +152,8 @@ int main(int argc, char *argv[])
         } else {
             std::cout << "Error: Unexpected symbol " << stream.nextToken().text << std::endl;
         }
+
+        arena.reset();
     }
 
     return 0;
@@ -5,6 +5,8 @@
 
 namespace Parser
 {
+    // Parsers are not modified after construction, so any number of sessions on different threads
+    // can share one parser, along with its grammar and tokenizer.
     class Base
     {
     public:
@@ -0,0 +1,104 @@
+#ifndef PARSER_BATCHPARSER_HPP
+#define PARSER_BATCHPARSER_HPP
+
+#include "Parser/Tokenizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Parser
+{
+    // Parses many independent inputs across a pool of threads.  Grammars, tokenizers and parsers are not
+    // modified once constructed, so every worker shares them; each worker parses with a session and
+    // streams of its own.  Sessions are created on first use, handed to the configure function to
+    // register their reducers and decorators, and kept between batches, so anything allocated from a
+    // session's arena stays valid until that arena is reset.
+    template<typename Session> class BatchParser
+    {
+    public:
+        typedef decltype(std::declval<Session&>().parse(std::declval<Tokenizer::Stream&>())) Result;
+        typedef std::function<void(Session&)> Configure;
+
+        template<typename ParserType> BatchParser(const ParserType &parser, const Tokenizer &tokenizer, Configure configure);
+
+        // Returns the result for each input in input order.  Inputs are handed out one at a time, so
+        // a few long inputs do not hold up the rest of the batch.
+        std::vector<Result> parseBatch(const std::vector<std::string_view> &inputs, unsigned int threads);
+
+        unsigned int numSessions() const;
+        Session &session(unsigned int index);
+
+    private:
+        const Tokenizer &mTokenizer;
+        std::function<std::unique_ptr<Session>()> mCreateSession;
+        std::vector<std::unique_ptr<Session>> mSessions;
+    };
+
+    template<typename Session> template<typename ParserType> BatchParser<Session>::BatchParser(const ParserType &parser, const Tokenizer &tokenizer, Configure configure)
+    : mTokenizer(tokenizer)
+    {
+        mCreateSession = [&parser, configure = std::move(configure)]() {
+            std::unique_ptr<Session> session = std::make_unique<Session>(parser);
+            if(configure) {
+                configure(*session);
+            }
+            return session;
+        };
+    }
+
+    template<typename Session> std::vector<typename BatchParser<Session>::Result> BatchParser<Session>::parseBatch(const std::vector<std::string_view> &inputs, unsigned int threads)
+    {
+        std::vector<Result> results(inputs.size());
+        if(inputs.size() == 0) {
+            return results;
+        }
+
+        threads = std::max(1u, std::min(threads, (unsigned int)inputs.size()));
+        while(mSessions.size() < threads) {
+            mSessions.push_back(mCreateSession());
+        }
+
+        // Each result slot is written by exactly one worker, and the join publishes them all.
+        std::atomic<size_t> next(0);
+        auto parseInputs = [&](unsigned int worker) {
+            Session &session = *mSessions[worker];
+            while(true) {
+                size_t index = next.fetch_add(1, std::memory_order_relaxed);
+                if(index >= inputs.size()) {
+                    break;
+                }
+
+                Tokenizer::Stream stream(mTokenizer, inputs[index]);
+                results[index] = session.parse(stream);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned int i=1; i<threads; i++) {
+            workers.push_back(std::thread(parseInputs, i));
+        }
+        parseInputs(0);
+        for(auto &worker : workers) {
+            worker.join();
+        }
+
+        return results;
+    }
+
+    template<typename Session> unsigned int BatchParser<Session>::numSessions() const
+    {
+        return (unsigned int)mSessions.size();
+    }
+
+    template<typename Session> Session &BatchParser<Session>::session(unsigned int index)
+    {
+        return *mSessions[index];
+    }
+}
+#endif
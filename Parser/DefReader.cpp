@@ -1,8 +1,8 @@
 #include "Parser/DefReader.hpp"
 #include "Parser/Impl/LL.hpp"
 #include "Parser/ExtendedGrammar.hpp"
+#include "Util/MappedFile.hpp"
 
-#include <fstream>
 #include <vector>
 #include <iostream>
 
@@ -80,6 +80,26 @@ namespace Parser
         }
     }
 
+    DefReader::DefReader(Util::BinaryReader &reader)
+    {
+        std::unique_ptr<Tokenizer> tokenizer = std::make_unique<Tokenizer>(reader);
+        std::unique_ptr<Parser::Grammar> grammar = std::make_unique<Parser::Grammar>(reader);
+        if(!reader.valid()) {
+            mParseError.line = 0;
+            mParseError.message = "Invalid table data";
+            return;
+        }
+
+        mTokenizer = std::move(tokenizer);
+        mGrammar = std::move(grammar);
+    }
+
+    void DefReader::save(Util::BinaryWriter &writer) const
+    {
+        mTokenizer->save(writer);
+        mGrammar->save(writer);
+    }
+
     bool DefReader::valid() const
     {
         return mTokenizer && mGrammar;
@@ -246,8 +266,8 @@ namespace Parser
         createDefGrammar();
         Parser::Impl::LL parser(*mDefGrammar);
         
-        std::ifstream file(filename);
-        Tokenizer::Stream stream(*mDefTokenizer, file);
+        Util::MappedFile file(filename);
+        Tokenizer::Stream stream(*mDefTokenizer, file.data());
 
         Parser::Impl::LL::ParseSession<DefNode> session(parser);
         session.addMatchListener("pattern", [&](unsigned int symbol) {
@@ -256,16 +276,16 @@ namespace Parser
         });
 
         session.addTerminalDecorator("terminal", [](const Tokenizer::Token &token) {
-            return std::make_unique<DefNode>(DefNode::Type::Terminal, token.text, token.line);
+            return std::make_unique<DefNode>(DefNode::Type::Terminal, std::string(token.text), token.line);
         });
         session.addTerminalDecorator("nonterminal", [](const Tokenizer::Token &token) {
-            return std::make_unique<DefNode>(DefNode::Type::Nonterminal, token.text.substr(1, token.text.size() - 2), token.line);
+            return std::make_unique<DefNode>(DefNode::Type::Nonterminal, std::string(token.text.substr(1, token.text.size() - 2)), token.line);
         });
         session.addTerminalDecorator("literal", [](const Tokenizer::Token &token) {
-            return std::make_unique<DefNode>(DefNode::Type::Literal, token.text.substr(1, token.text.size() - 2), token.line);
+            return std::make_unique<DefNode>(DefNode::Type::Literal, std::string(token.text.substr(1, token.text.size() - 2)), token.line);
         });
         session.addTerminalDecorator("regex", [](const Tokenizer::Token &token) {
-            return std::make_unique<DefNode>(DefNode::Type::Regex, token.text, token.line);
+            return std::make_unique<DefNode>(DefNode::Type::Regex, std::string(token.text), token.line);
         });
 
         session.addReducer("root", [](auto begin, auto end) {
@@ -358,7 +378,7 @@ namespace Parser
         std::unique_ptr<DefNode> node = session.parse(stream);
         if(!node) {
             mParseError.line = stream.nextToken().line;
-            mParseError.message =  "Unexpected symbol " + stream.nextToken().text;
+            mParseError.message =  "Unexpected symbol " + std::string(stream.nextToken().text);
         }
         return node;
     }
@@ -391,7 +411,13 @@ namespace Parser
             {
                 unsigned int index = UINT_MAX;
                 auto it = mTerminalMap.find(defNode.string);
-                if(it == mTerminalMap.end()) {
+                if(it == mTerminalMap.end() && defNode.string == "error") {
+                    // The error pseudo-terminal is never produced by the tokenizer; sessions with
+                    // recovery enabled shift it in place of input they had to discard.
+                    mTerminals.push_back("");
+                    mTerminalNames.push_back("error");
+                    index = mTerminalMap["error"] = (unsigned int)(mTerminals.size() - 1);
+                } else if(it == mTerminalMap.end()) {
                     mParseError.line = defNode.line;
                     mParseError.message = "Unknown terminal " + defNode.string;
                     return nullptr;
@@ -16,6 +16,9 @@ namespace Parser
     class DefReader {
     public:
         DefReader(const std::string &filename);
+        DefReader(Util::BinaryReader &reader);
+
+        void save(Util::BinaryWriter &writer) const;
 
         bool valid() const;
 
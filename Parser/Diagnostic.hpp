@@ -0,0 +1,15 @@
+#ifndef PARSER_DIAGNOSTIC_HPP
+#define PARSER_DIAGNOSTIC_HPP
+
+#include <string>
+
+namespace Parser
+{
+    // A syntax error which a session recovered from, at the token where it was found.
+    struct Diagnostic {
+        unsigned int line;
+        unsigned int start;
+        std::string message;
+    };
+}
+#endif
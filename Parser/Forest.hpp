@@ -0,0 +1,307 @@
+#ifndef PARSER_FOREST_HPP
+#define PARSER_FOREST_HPP
+
+#include <climits>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace Parser
+{
+    // Shared packed parse forest.  Each symbol node covers a span of tokens and holds one packed
+    // alternative per distinct way of deriving it; alternatives refer to their children by node index,
+    // so subtrees common to several derivations are stored once.  Reducers are not run while the
+    // forest is built: evaluate() runs them along a single chosen derivation, and evaluateAll() runs
+    // them over every derivation.
+    template<typename ParseData, typename DataPointer = std::shared_ptr<ParseData>> class Forest
+    {
+    public:
+        static constexpr unsigned int kNone = UINT_MAX;
+
+        struct Item {
+            enum class Type {
+                Terminal,
+                Nonterminal
+            };
+            Type type;
+            unsigned int index;
+            DataPointer data{};
+
+            typedef Item* iterator;
+        };
+
+        typedef std::function<DataPointer(typename Item::iterator, typename Item::iterator)> Reducer;
+        typedef std::function<unsigned int(const Forest &forest, unsigned int node)> Chooser;
+
+        struct Packed {
+            unsigned int rule;
+            unsigned int rhs;
+            std::vector<unsigned int> children;
+        };
+
+        struct Node {
+            typename Item::Type type;
+            unsigned int index;
+            unsigned int start;
+            unsigned int end;
+            std::vector<Packed> packed;
+        };
+
+        Forest();
+
+        unsigned int addTerminal(unsigned int terminal, unsigned int position, DataPointer data);
+        unsigned int addNonterminal(unsigned int rule, unsigned int start, unsigned int end);
+        unsigned int findNonterminal(unsigned int rule, unsigned int start, unsigned int end) const;
+        bool addPacked(unsigned int node, unsigned int rule, unsigned int rhs, std::vector<unsigned int> children);
+
+        void setRoot(unsigned int node);
+        unsigned int root() const;
+        bool valid() const;
+
+        unsigned int numNodes() const;
+        const Node &node(unsigned int node) const;
+        bool ambiguous(unsigned int node) const;
+
+        // reducers is indexed by rule; rules without a reducer pass their children through.
+        DataPointer evaluate(const std::vector<Reducer> &reducers, Chooser chooser = Chooser()) const;
+        std::vector<DataPointer> evaluateAll(const std::vector<Reducer> &reducers) const;
+
+    private:
+        const std::vector<Item> &evaluateNode(unsigned int node, const std::vector<Reducer> &reducers, Chooser &chooser, std::vector<std::unique_ptr<std::vector<Item>>> &values) const;
+        const std::vector<std::vector<Item>> &evaluateNodeAll(unsigned int node, const std::vector<Reducer> &reducers, std::vector<std::unique_ptr<std::vector<std::vector<Item>>>> &values) const;
+        void reduce(const Packed &packed, const std::vector<Reducer> &reducers, std::vector<Item> &items, std::vector<Item> &result) const;
+
+        struct NodeKeyHash {
+            size_t operator()(const std::tuple<unsigned int, unsigned int, unsigned int> &key) const;
+        };
+
+        static size_t packedHash(unsigned int rhs, const std::vector<unsigned int> &children);
+
+        std::vector<Node> mNodes;
+        std::vector<DataPointer> mTerminalData;
+        std::vector<unsigned int> mTerminalNodes;
+        std::unordered_map<std::tuple<unsigned int, unsigned int, unsigned int>, unsigned int, NodeKeyHash> mNonterminalNodes;
+
+        // Each node's packed alternatives, as indices into its packed list keyed by packedHash().  A
+        // node can gain a packed alternative per split of its span, so looking for a duplicate among
+        // them one by one would cost time linear in the span for every reduction path.
+        std::vector<std::unordered_multimap<size_t, unsigned int>> mPackedIndices;
+        unsigned int mRoot;
+    };
+
+    template<typename ParseData, typename DataPointer> Forest<ParseData, DataPointer>::Forest()
+    : mRoot(kNone)
+    {
+    }
+
+    template<typename ParseData, typename DataPointer> unsigned int Forest<ParseData, DataPointer>::addTerminal(unsigned int terminal, unsigned int position, DataPointer data)
+    {
+        if(position >= mTerminalNodes.size()) {
+            mTerminalNodes.resize(position + 1, kNone);
+            mTerminalData.resize(position + 1);
+        }
+
+        if(mTerminalNodes[position] == kNone) {
+            mTerminalNodes[position] = (unsigned int)mNodes.size();
+            mNodes.push_back(Node{Item::Type::Terminal, terminal, position, position + 1});
+            mTerminalData[position] = std::move(data);
+        }
+
+        return mTerminalNodes[position];
+    }
+
+    template<typename ParseData, typename DataPointer> unsigned int Forest<ParseData, DataPointer>::addNonterminal(unsigned int rule, unsigned int start, unsigned int end)
+    {
+        auto it = mNonterminalNodes.find(std::make_tuple(rule, start, end));
+        if(it != mNonterminalNodes.end()) {
+            return it->second;
+        }
+
+        unsigned int node = (unsigned int)mNodes.size();
+        mNodes.push_back(Node{Item::Type::Nonterminal, rule, start, end});
+        mNonterminalNodes[std::make_tuple(rule, start, end)] = node;
+        return node;
+    }
+
+    template<typename ParseData, typename DataPointer> unsigned int Forest<ParseData, DataPointer>::findNonterminal(unsigned int rule, unsigned int start, unsigned int end) const
+    {
+        auto it = mNonterminalNodes.find(std::make_tuple(rule, start, end));
+        if(it != mNonterminalNodes.end()) {
+            return it->second;
+        }
+
+        return kNone;
+    }
+
+    template<typename ParseData, typename DataPointer> bool Forest<ParseData, DataPointer>::addPacked(unsigned int node, unsigned int rule, unsigned int rhs, std::vector<unsigned int> children)
+    {
+        if(node >= mPackedIndices.size()) {
+            mPackedIndices.resize(mNodes.size());
+        }
+
+        size_t hash = packedHash(rhs, children);
+        auto range = mPackedIndices[node].equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it) {
+            const Packed &packed = mNodes[node].packed[it->second];
+            if(packed.rhs == rhs && packed.children == children) {
+                return false;
+            }
+        }
+
+        mPackedIndices[node].emplace(hash, (unsigned int)mNodes[node].packed.size());
+        mNodes[node].packed.push_back(Packed{rule, rhs, std::move(children)});
+        return true;
+    }
+
+    template<typename ParseData, typename DataPointer> size_t Forest<ParseData, DataPointer>::NodeKeyHash::operator()(const std::tuple<unsigned int, unsigned int, unsigned int> &key) const
+    {
+        size_t hash = std::get<0>(key);
+        hash = hash * 31 + std::get<1>(key);
+        hash = hash * 31 + std::get<2>(key);
+        return hash;
+    }
+
+    template<typename ParseData, typename DataPointer> size_t Forest<ParseData, DataPointer>::packedHash(unsigned int rhs, const std::vector<unsigned int> &children)
+    {
+        size_t hash = rhs;
+        for(unsigned int child : children) {
+            hash = hash * 31 + child;
+        }
+        return hash;
+    }
+
+    template<typename ParseData, typename DataPointer> void Forest<ParseData, DataPointer>::setRoot(unsigned int node)
+    {
+        mRoot = node;
+    }
+
+    template<typename ParseData, typename DataPointer> unsigned int Forest<ParseData, DataPointer>::root() const
+    {
+        return mRoot;
+    }
+
+    template<typename ParseData, typename DataPointer> bool Forest<ParseData, DataPointer>::valid() const
+    {
+        return mRoot != kNone;
+    }
+
+    template<typename ParseData, typename DataPointer> unsigned int Forest<ParseData, DataPointer>::numNodes() const
+    {
+        return (unsigned int)mNodes.size();
+    }
+
+    template<typename ParseData, typename DataPointer> const typename Forest<ParseData, DataPointer>::Node &Forest<ParseData, DataPointer>::node(unsigned int node) const
+    {
+        return mNodes[node];
+    }
+
+    template<typename ParseData, typename DataPointer> bool Forest<ParseData, DataPointer>::ambiguous(unsigned int node) const
+    {
+        return mNodes[node].packed.size() > 1;
+    }
+
+    template<typename ParseData, typename DataPointer> DataPointer Forest<ParseData, DataPointer>::evaluate(const std::vector<Reducer> &reducers, Chooser chooser) const
+    {
+        if(!valid()) {
+            return DataPointer();
+        }
+
+        std::vector<std::unique_ptr<std::vector<Item>>> values(mNodes.size());
+        const std::vector<Item> &items = evaluateNode(mRoot, reducers, chooser, values);
+        return items.size() > 0 ? items[0].data : DataPointer();
+    }
+
+    template<typename ParseData, typename DataPointer> std::vector<DataPointer> Forest<ParseData, DataPointer>::evaluateAll(const std::vector<Reducer> &reducers) const
+    {
+        std::vector<DataPointer> results;
+        if(!valid()) {
+            return results;
+        }
+
+        std::vector<std::unique_ptr<std::vector<std::vector<Item>>>> values(mNodes.size());
+        for(const auto &items : evaluateNodeAll(mRoot, reducers, values)) {
+            results.push_back(items.size() > 0 ? items[0].data : DataPointer());
+        }
+
+        return results;
+    }
+
+    template<typename ParseData, typename DataPointer> const std::vector<typename Forest<ParseData, DataPointer>::Item> &Forest<ParseData, DataPointer>::evaluateNode(unsigned int node, const std::vector<Reducer> &reducers, Chooser &chooser, std::vector<std::unique_ptr<std::vector<Item>>> &values) const
+    {
+        if(values[node]) {
+            return *values[node];
+        }
+
+        values[node] = std::make_unique<std::vector<Item>>();
+        std::vector<Item> &result = *values[node];
+        const Node &n = mNodes[node];
+        if(n.type == Item::Type::Terminal) {
+            result.push_back(Item{Item::Type::Terminal, n.index, mTerminalData[n.start]});
+            return result;
+        }
+
+        unsigned int choice = (chooser && n.packed.size() > 1) ? chooser(*this, node) : 0;
+        const Packed &packed = n.packed[choice];
+        std::vector<Item> items;
+        for(unsigned int child : packed.children) {
+            const std::vector<Item> &childItems = evaluateNode(child, reducers, chooser, values);
+            items.insert(items.end(), childItems.begin(), childItems.end());
+        }
+        reduce(packed, reducers, items, result);
+
+        return result;
+    }
+
+    template<typename ParseData, typename DataPointer> const std::vector<std::vector<typename Forest<ParseData, DataPointer>::Item>> &Forest<ParseData, DataPointer>::evaluateNodeAll(unsigned int node, const std::vector<Reducer> &reducers, std::vector<std::unique_ptr<std::vector<std::vector<Item>>>> &values) const
+    {
+        if(values[node]) {
+            return *values[node];
+        }
+
+        values[node] = std::make_unique<std::vector<std::vector<Item>>>();
+        std::vector<std::vector<Item>> &results = *values[node];
+        const Node &n = mNodes[node];
+        if(n.type == Item::Type::Terminal) {
+            results.push_back(std::vector<Item>{Item{Item::Type::Terminal, n.index, mTerminalData[n.start]}});
+            return results;
+        }
+
+        // Every derivation of the node is the cross product of its children's derivations, taken over
+        // each packed alternative in turn.
+        for(const auto &packed : n.packed) {
+            std::vector<std::vector<Item>> partials(1);
+            for(unsigned int child : packed.children) {
+                const std::vector<std::vector<Item>> &childResults = evaluateNodeAll(child, reducers, values);
+                std::vector<std::vector<Item>> newPartials;
+                for(const auto &partial : partials) {
+                    for(const auto &childItems : childResults) {
+                        newPartials.push_back(partial);
+                        newPartials.back().insert(newPartials.back().end(), childItems.begin(), childItems.end());
+                    }
+                }
+                partials = std::move(newPartials);
+            }
+
+            for(auto &partial : partials) {
+                results.emplace_back();
+                reduce(packed, reducers, partial, results.back());
+            }
+        }
+
+        return results;
+    }
+
+    template<typename ParseData, typename DataPointer> void Forest<ParseData, DataPointer>::reduce(const Packed &packed, const std::vector<Reducer> &reducers, std::vector<Item> &items, std::vector<Item> &result) const
+    {
+        const Reducer &reducer = reducers[packed.rule];
+        if(!reducer) {
+            result.insert(result.end(), items.begin(), items.end());
+        } else {
+            DataPointer data = reducer(items.data(), items.data() + items.size());
+            result.push_back(Item{Item::Type::Nonterminal, packed.rule, std::move(data)});
+        }
+    }
+}
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Grammar.hpp"
 
+#include "Util/Digraph.hpp"
+
 #include <iostream>
 
 namespace Parser {
@@ -9,6 +11,59 @@ namespace Parser {
     {
     }
 
+    Grammar::Grammar(Util::BinaryReader &reader)
+    {
+        reader.expect(Util::binaryTag("GRAM"));
+        reader.read(mStartRule);
+
+        uint32_t numTerminals = 0;
+        reader.read(numTerminals);
+        for(uint32_t i=0; i<numTerminals && reader.valid(); i++) {
+            std::string terminal;
+            reader.read(terminal);
+            mTerminals.push_back(std::move(terminal));
+        }
+
+        uint32_t numRules = 0;
+        reader.read(numRules);
+        for(uint32_t i=0; i<numRules && reader.valid(); i++) {
+            Rule rule;
+            reader.read(rule.lhs);
+            uint32_t numRhs = 0;
+            reader.read(numRhs);
+            for(uint32_t j=0; j<numRhs && reader.valid(); j++) {
+                RHS rhs;
+                reader.read(rhs);
+                rule.rhs.push_back(std::move(rhs));
+            }
+            mRules.push_back(std::move(rule));
+        }
+
+        if(mStartRule >= mRules.size()) {
+            reader.invalidate();
+        }
+    }
+
+    void Grammar::save(Util::BinaryWriter &writer) const
+    {
+        writer.write(Util::binaryTag("GRAM"));
+        writer.write(mStartRule);
+
+        writer.write((uint32_t)mTerminals.size());
+        for(const auto &terminal : mTerminals) {
+            writer.write(terminal);
+        }
+
+        writer.write((uint32_t)mRules.size());
+        for(const auto &rule : mRules) {
+            writer.write(rule.lhs);
+            writer.write((uint32_t)rule.rhs.size());
+            for(const auto &rhs : rule.rhs) {
+                writer.write(rhs);
+            }
+        }
+    }
+
     const std::vector<Grammar::Rule> &Grammar::rules() const
     {
         return mRules;
@@ -46,94 +101,135 @@ namespace Parser {
         return UINT_MAX;
     }
 
-    bool isNullable(const Grammar::Symbol &symbol, const std::set<unsigned int> &nullableNonterminals) {
-        switch(symbol.type) {
-            case Grammar::Symbol::Type::Terminal:
-                return false;
-            case Grammar::Symbol::Type::Epsilon:
-                return true;
-            case Grammar::Symbol::Type::Nonterminal:
-                return nullableNonterminals.count(symbol.index) > 0;
-        }
-        return false;
-    }
-
-    void addSymbol(std::set<unsigned int> &set, unsigned int symbol, bool &changed)
+    void Grammar::computeSets(std::vector<std::set<unsigned int>> &firstSets, std::vector<std::set<unsigned int>> &followSets, std::set<unsigned int> &nullableNonterminals) const
     {
-        if(set.count(symbol) == 0) {
-            set.insert(symbol);
-            changed = true;
-        }
-    }
+        std::vector<Util::BitSet> firstBits;
+        std::vector<Util::BitSet> followBits;
+        Util::BitSet nullableBits;
+        computeSets(firstBits, followBits, nullableBits);
 
-    void addSet(std::set<unsigned int> &set, const std::set<unsigned int> &source, bool &changed)
-    {
-        for(unsigned int s : source) {
-            addSymbol(set, s, changed);
+        firstSets.resize(mRules.size());
+        followSets.resize(mRules.size());
+        for(unsigned int i=0; i<mRules.size(); i++) {
+            firstBits[i].forEach([&](unsigned int terminal) { firstSets[i].insert(terminal); });
+            followBits[i].forEach([&](unsigned int terminal) { followSets[i].insert(terminal); });
         }
+        nullableBits.forEach([&](unsigned int rule) { nullableNonterminals.insert(rule); });
     }
 
-    void addFirstSet(std::set<unsigned int> &set, const Grammar::Symbol &symbol, const std::vector<std::set<unsigned int>> &firstSets, bool &changed)
+    Util::BitSet Grammar::computeNullable() const
     {
-        switch(symbol.type) {
-            case Grammar::Symbol::Type::Terminal:
-                addSymbol(set, symbol.index, changed);
-                break;
-            
-            case Grammar::Symbol::Type::Nonterminal:
-                addSet(set, firstSets[symbol.index], changed);
-                break;
+        struct Occurrence {
+            unsigned int rule;
+            unsigned int rhs;
+        };
+
+        std::vector<std::vector<Occurrence>> occurrences(mRules.size());
+        std::vector<std::vector<unsigned int>> remaining(mRules.size());
+        std::vector<unsigned int> queue;
+
+        Util::BitSet nullableNonterminals(mRules.size());
+        for(unsigned int i=0; i<mRules.size(); i++) {
+            for(unsigned int j=0; j<mRules[i].rhs.size(); j++) {
+                unsigned int count = 0;
+                for(const Symbol &symbol : mRules[i].rhs[j]) {
+                    switch(symbol.type) {
+                        case Symbol::Type::Terminal:
+                            count = UINT_MAX;
+                            break;
+
+                        case Symbol::Type::Nonterminal:
+                            if(count != UINT_MAX) {
+                                occurrences[symbol.index].push_back(Occurrence{i, j});
+                                count++;
+                            }
+                            break;
+
+                        case Symbol::Type::Epsilon:
+                            break;
+                    }
+                }
+                remaining[i].push_back(count);
+
+                if(count == 0 && nullableNonterminals.set(i)) {
+                    queue.push_back(i);
+                }
+            }
         }
-    }
 
-    void addFirstSet(std::set<unsigned int> &set, 
-                    std::vector<Grammar::Symbol>::const_iterator begin,
-                    std::vector<Grammar::Symbol>::const_iterator end,
-                    const std::vector<std::set<unsigned int>> &firstSets,
-                    const std::set<unsigned int> &nullableNonterminals,
-                    bool &nullable,
-                    bool &changed)
-    {
-        nullable = true;
-        for(auto it = begin; it != end; it++) {
-            const Grammar::Symbol &symbol = *it;
-            addFirstSet(set, symbol, firstSets, changed);
-            if(!isNullable(symbol, nullableNonterminals)) {
-                nullable = false;
-                break;
+        for(size_t i=0; i<queue.size(); i++) {
+            for(const Occurrence &occurrence : occurrences[queue[i]]) {
+                unsigned int &count = remaining[occurrence.rule][occurrence.rhs];
+                count--;
+                if(count == 0 && nullableNonterminals.set(occurrence.rule)) {
+                    queue.push_back(occurrence.rule);
+                }
             }
         }
+
+        return nullableNonterminals;
     }
 
-    void Grammar::computeSets(std::vector<std::set<unsigned int>> &firstSets, std::vector<std::set<unsigned int>> &followSets, std::set<unsigned int> &nullableNonterminals) const
+    void Grammar::computeSets(std::vector<Util::BitSet> &firstSets, std::vector<Util::BitSet> &followSets, Util::BitSet &nullableNonterminals) const
     {
-        firstSets.resize(mRules.size());
-        followSets.resize(mRules.size());
+        nullableNonterminals = computeNullable();
 
-        bool changed = true;
-        while(changed) {
-            changed = false;
-            for(unsigned int i=0; i<mRules.size(); i++) {
-                for(const RHS &rhs : mRules[i].rhs) {
-                    bool nullable;
-                    addFirstSet(firstSets[i], rhs.cbegin(), rhs.cend(), firstSets, nullableNonterminals, nullable, changed);
-                    if(nullable) {
-                        addSymbol(nullableNonterminals, i, changed);
+        std::vector<std::vector<unsigned int>> firstEdges(mRules.size());
+        firstSets.assign(mRules.size(), Util::BitSet(mTerminals.size()));
+        for(unsigned int i=0; i<mRules.size(); i++) {
+            for(const RHS &rhs : mRules[i].rhs) {
+                for(const Symbol &symbol : rhs) {
+                    if(symbol.type == Symbol::Type::Terminal) {
+                        firstSets[i].set(symbol.index);
+                        break;
                     }
 
-                    for(unsigned int j=0; j<rhs.size(); j++) {
-                        const Symbol &symbol = rhs[j];
-                        if(symbol.type == Symbol::Type::Nonterminal) {
-                            bool nullable;
-                            addFirstSet(followSets[symbol.index], rhs.cbegin() + j + 1, rhs.cend(), firstSets, nullableNonterminals, nullable, changed);
-                            if(nullable) {
-                                addSet(followSets[symbol.index], followSets[i], changed);
-                            }
+                    if(symbol.type == Symbol::Type::Nonterminal) {
+                        firstEdges[i].push_back(symbol.index);
+                        if(!nullableNonterminals.test(symbol.index)) {
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        Util::propagateSets(firstEdges, firstSets);
+
+        std::vector<std::vector<unsigned int>> followEdges(mRules.size());
+        followSets.assign(mRules.size(), Util::BitSet(mTerminals.size()));
+        for(unsigned int i=0; i<mRules.size(); i++) {
+            for(const RHS &rhs : mRules[i].rhs) {
+                for(unsigned int j=0; j<rhs.size(); j++) {
+                    if(rhs[j].type != Symbol::Type::Nonterminal) {
+                        continue;
+                    }
+
+                    Util::BitSet &followSet = followSets[rhs[j].index];
+                    bool nullable = true;
+                    for(unsigned int k=j+1; k<rhs.size() && nullable; k++) {
+                        switch(rhs[k].type) {
+                            case Symbol::Type::Terminal:
+                                followSet.set(rhs[k].index);
+                                nullable = false;
+                                break;
+
+                            case Symbol::Type::Nonterminal:
+                                followSet.add(firstSets[rhs[k].index]);
+                                nullable = nullableNonterminals.test(rhs[k].index);
+                                break;
+
+                            case Symbol::Type::Epsilon:
+                                break;
                         }
                     }
+
+                    if(nullable && rhs[j].index != i) {
+                        followEdges[rhs[j].index].push_back(i);
+                    }
                 }
-            }       
+            }
         }
+        Util::propagateSets(followEdges, followSets);
     }
 
     void Grammar::print() const
@@ -1,6 +1,9 @@
 #ifndef PARSER_GRAMMAR_HPP
 #define PARSER_GRAMMAR_HPP
 
+#include "Util/Binary.hpp"
+#include "Util/BitSet.hpp"
+
 #include <string>
 #include <vector>
 #include <set>
@@ -31,6 +34,9 @@ namespace Parser {
         };
 
         Grammar(std::vector<std::string> terminals, std::vector<Rule> rules, unsigned int startRule);
+        Grammar(Util::BinaryReader &reader);
+
+        void save(Util::BinaryWriter &writer) const;
 
         const std::vector<Rule> &rules() const;
         unsigned int startRule() const;
@@ -39,7 +45,10 @@ namespace Parser {
         unsigned int terminalIndex(const std::string &name) const;
         unsigned int ruleIndex(const std::string &name) const;
 
+        // The nonterminals which can derive the empty string, indexed by rule.
+        Util::BitSet computeNullable() const;
         void computeSets(std::vector<std::set<unsigned int>> &firstSets, std::vector<std::set<unsigned int>> &followSets, std::set<unsigned int> &nullableNonterminals) const;
+        void computeSets(std::vector<Util::BitSet> &firstSets, std::vector<Util::BitSet> &followSets, Util::BitSet &nullableNonterminals) const;
 
         void print() const;
 
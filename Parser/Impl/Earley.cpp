@@ -101,6 +101,17 @@ namespace Parser
                     if(symbol.type == Grammar::Symbol::Type::Nonterminal) {
                         newItems = predict(symbol.index, pos);
                         items.insert(items.end(), newItems.begin(), newItems.end());
+
+                        // A nullable nonterminal may already have been completed here by an earlier
+                        // prediction, in which case its completion will not be processed again, so
+                        // step over it now.
+                        newItems.clear();
+                        for(auto it = completed[pos].lower_bound(Item{symbol.index, 0, 0, 0}); it != completed[pos].end() && it->rule == symbol.index; it++) {
+                            if(it->start == pos) {
+                                newItems.push_back(Item{item.rule, item.rhs, item.pos + 1, item.start});
+                                break;
+                            }
+                        }
                     }
                 }
                 items.insert(items.end(), newItems.begin(), newItems.end());
@@ -4,7 +4,10 @@
 #include "Parser/Base.hpp"
 #include "Parser/Tokenizer.hpp"
 
-#include "Util/MultiStack.hpp"
+#include "Parser/Forest.hpp"
+#include "Parser/Profiler.hpp"
+
+#include "Util/Arena.hpp"
 
 #include <set>
 #include <vector>
@@ -29,37 +32,33 @@ namespace Parser
                 bool operator<(const Item &other) const;
             };
 
-            template<typename ParseData> class ParseSession
+            template<typename ParseData, typename DataPointer = std::shared_ptr<ParseData>, typename ProfilerType = NullProfiler> class ParseSession
             {
             public:
-                struct ParseItem {
-                    enum class Type {
-                        Terminal,
-                        Nonterminal,
-                    };
-                    Type type;
-                    unsigned int index;
-                    std::shared_ptr<ParseData> data;
-
-                    typedef ParseItem* iterator;
-                };
-
-                typedef std::function<std::shared_ptr<ParseData>(const Tokenizer::Token&)> TerminalDecorator;
-                typedef std::function<std::shared_ptr<ParseData>(typename Util::MultiStack<ParseItem>::iterator, typename Util::MultiStack<ParseItem>::Locator)> Reducer;
+                typedef typename Forest<ParseData, DataPointer>::Item ParseItem;
+                typedef std::function<DataPointer(const Tokenizer::Token&)> TerminalDecorator;
+                typedef typename Forest<ParseData, DataPointer>::Reducer Reducer;
+                typedef typename Forest<ParseData, DataPointer>::Chooser Chooser;
                 
                 ParseSession(const Earley &parser);
 
                 void addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator);
                 void addReducer(const std::string &rule, Reducer reducer);
+                Util::Arena &arena();
+                ProfilerType &profiler();
 
-                std::vector<std::shared_ptr<ParseData>> parse(Tokenizer::Stream &stream) const;
+                std::vector<DataPointer> parse(Tokenizer::Stream &stream) const;
+                Forest<ParseData, DataPointer> parseForest(Tokenizer::Stream &stream) const;
+                DataPointer evaluate(const Forest<ParseData, DataPointer> &forest, Chooser chooser = Chooser()) const;
             
             private:
-                void parseRule(const std::vector<std::set<Earley::Item>> &completedSets, const std::vector<unsigned int> &terminalIndices, unsigned int rule, unsigned int start, unsigned int end, Util::MultiStack<ParseItem> &parseStacks, std::vector<std::shared_ptr<ParseData>> &terminalData) const;
+                unsigned int parseRule(const std::vector<std::set<Earley::Item>> &completedSets, const std::vector<unsigned int> &terminalIndices, unsigned int rule, unsigned int start, unsigned int end, Forest<ParseData, DataPointer> &forest, std::vector<DataPointer> &terminalData) const;
 
                 const Earley &mParser;
-                std::map<unsigned int, TerminalDecorator> mTerminalDecorators;
-                std::map<unsigned int, Reducer> mReducers;        
+                std::vector<TerminalDecorator> mTerminalDecorators;
+                std::vector<Reducer> mReducers;
+                Util::Arena mArena;
+                mutable ProfilerType mProfiler;
             };
 
         private:
@@ -78,9 +77,9 @@ namespace Parser
             std::vector<std::set<Item>> computeSets(Tokenizer::Stream &stream, TokenListener tokenListener) const;
         };
 
-        template<typename ParseData> Earley::ParseSession<ParseData>::ParseSession(const Earley &parser) : mParser(parser) {}
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Earley::ParseSession<ParseData, DataPointer, ProfilerType>::ParseSession(const Earley &parser) : mParser(parser), mTerminalDecorators(parser.grammar().terminals().size()), mReducers(parser.grammar().rules().size()) {}
 
-        template<typename ParseData> void Earley::ParseSession<ParseData>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void Earley::ParseSession<ParseData, DataPointer, ProfilerType>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
         {
             unsigned int terminalIndex = mParser.mGrammar.terminalIndex(terminal);
             if(terminalIndex != UINT_MAX) {
@@ -88,7 +87,7 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> void Earley::ParseSession<ParseData>::addReducer(const std::string &rule, Reducer reducer)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void Earley::ParseSession<ParseData, DataPointer, ProfilerType>::addReducer(const std::string &rule, Reducer reducer)
         {
             unsigned int ruleIndex = mParser.mGrammar.ruleIndex(rule);
             if(ruleIndex != UINT_MAX) {
@@ -96,38 +95,75 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> std::vector<std::shared_ptr<ParseData>> Earley::ParseSession<ParseData>::parse(Tokenizer::Stream &stream) const
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Util::Arena &Earley::ParseSession<ParseData, DataPointer, ProfilerType>::arena()
         {
-            std::vector<std::shared_ptr<ParseData>> terminalData;
-            std::vector<unsigned int> terminalIndices;
-
-            auto tokenListener = [&](const Tokenizer::Token &token) {
-                auto it = mTerminalDecorators.find(token.value);
-                std::shared_ptr<ParseData> parseData;
-                if(it != mTerminalDecorators.end()) {
-                    parseData = it->second(token);
-                }
-                terminalData.push_back(parseData);
-                terminalIndices.push_back(token.value);
-            };
+            return mArena;
+        }
 
-            std::vector<std::set<Earley::Item>> completedSets = mParser.computeSets(stream, tokenListener);
-            
-            Util::MultiStack<ParseItem> parseStacks;
-            parseRule(completedSets, terminalIndices, mParser.mGrammar.startRule(), 0, (unsigned int)(completedSets.size() - 1), parseStacks, terminalData);
+        template<typename ParseData, typename DataPointer, typename ProfilerType> ProfilerType &Earley::ParseSession<ParseData, DataPointer, ProfilerType>::profiler()
+        {
+            return mProfiler;
+        }
 
-            std::vector<std::shared_ptr<ParseData>> results;
-            for(size_t i=0; i<parseStacks.size(); i++) {
-                results.push_back(parseStacks.back(i).data);
-            }
+        template<typename ParseData, typename DataPointer, typename ProfilerType> std::vector<DataPointer> Earley::ParseSession<ParseData, DataPointer, ProfilerType>::parse(Tokenizer::Stream &stream) const
+        {
+            Forest<ParseData, DataPointer> forest = parseForest(stream);
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                    return forest.evaluateAll(mReducers);
+                });
+            });
+        }
 
-            return results;
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer Earley::ParseSession<ParseData, DataPointer, ProfilerType>::evaluate(const Forest<ParseData, DataPointer> &forest, Chooser chooser) const
+        {
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                    return forest.evaluate(mReducers, chooser);
+                });
+            });
         }
 
-        template<typename ParseData> void Earley::ParseSession<ParseData>::parseRule(const std::vector<std::set<Earley::Item>> &completedSets, const std::vector<unsigned int> &terminalIndices, unsigned int rule, unsigned int start, unsigned int end, Util::MultiStack<ParseItem> &parseStacks, std::vector<std::shared_ptr<ParseData>> &terminalData) const
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Forest<ParseData, DataPointer> Earley::ParseSession<ParseData, DataPointer, ProfilerType>::parseForest(Tokenizer::Stream &stream) const
         {
-            Util::MultiStack<ParseItem>::Locator stackBegin = parseStacks.end(parseStacks.size() - 1);
-            bool first = true;
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                std::vector<DataPointer> terminalData;
+                std::vector<unsigned int> terminalIndices;
+
+                auto tokenListener = [&](const Tokenizer::Token &token) {
+                    mProfiler.countToken();
+                    DataPointer parseData{};
+                    if(token.value < mTerminalDecorators.size() && mTerminalDecorators[token.value]) {
+                        parseData = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                            return mTerminalDecorators[token.value](token);
+                        });
+                    }
+                    terminalData.push_back(parseData);
+                    terminalIndices.push_back(token.value);
+                };
+
+                std::vector<std::set<Earley::Item>> completedSets = mParser.computeSets(stream, tokenListener);
+                for(const auto &completedSet : completedSets) {
+                    mProfiler.countEarleySet(completedSet.size());
+                }
+
+                Forest<ParseData, DataPointer> forest;
+                unsigned int root = parseRule(completedSets, terminalIndices, mParser.mGrammar.startRule(), 0, (unsigned int)(completedSets.size() - 1), forest, terminalData);
+                if(forest.node(root).packed.size() > 0) {
+                    forest.setRoot(root);
+                }
+
+                return forest;
+            });
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> unsigned int Earley::ParseSession<ParseData, DataPointer, ProfilerType>::parseRule(const std::vector<std::set<Earley::Item>> &completedSets, const std::vector<unsigned int> &terminalIndices, unsigned int rule, unsigned int start, unsigned int end, Forest<ParseData, DataPointer> &forest, std::vector<DataPointer> &terminalData) const
+        {
+            unsigned int node = forest.findNonterminal(rule, start, end);
+            if(node != Forest<ParseData, DataPointer>::kNone) {
+                return node;
+            }
+            node = forest.addNonterminal(rule, start, end);
 
             for(const auto &item : completedSets[end]) {
                 if(item.rule != rule || item.start != start) {
@@ -138,14 +174,7 @@ namespace Parser
                 const Grammar::RHS &rhsSymbols = mParser.mGrammar.rules()[item.rule].rhs[item.rhs];
         
                 for(const auto &partition : partitions) {
-                    size_t stack;
-                    if(first) {
-                        stack = parseStacks.size() - 1;
-                        first = false;
-                    } else {
-                        stack = parseStacks.add(stackBegin);
-                    }
-
+                    std::vector<unsigned int> children;
                     for(unsigned int j = 0; j<partition.size(); j++) {
                         unsigned int ji = (unsigned int)(partition.size() - 1 - j);
                         unsigned int pstart = partition[ji];
@@ -153,49 +182,24 @@ namespace Parser
 
                         switch(rhsSymbols[j].type) {
                             case Grammar::Symbol::Type::Terminal:
-                            {
-                                ParseItem newItem;
-                                newItem.type = ParseItem::Type::Terminal;
-                                newItem.index = rhsSymbols[j].index;
-                                newItem.data = terminalData[pstart];
-                                parseStacks.push_back(stack, std::move(newItem));
+                                children.push_back(forest.addTerminal(rhsSymbols[j].index, pstart, terminalData[pstart]));
                                 break;
-                            }
+
                             case Grammar::Symbol::Type::Nonterminal:
-                            {
-                                parseRule(completedSets, terminalIndices, rhsSymbols[j].index, pstart, pend, parseStacks, terminalData);
-                                while(parseStacks.size() > stack + 1) {
-                                    parseStacks.join(parseStacks.size() - 1, parseStacks.end(stack));
-                                }
+                                children.push_back(parseRule(completedSets, terminalIndices, rhsSymbols[j].index, pstart, pend, forest, terminalData));
                                 break;
-                            }
+
                             case Grammar::Symbol::Type::Epsilon:
                                 break;
                         }
                     }
 
-                    auto it = mReducers.find(rule);
-                    if(it != mReducers.end()) {
-                        size_t stack = parseStacks.size() - 1;
-                        MultiStack<ParseItem>::Locator end = parseStacks.end(stack);
-                        std::vector<MultiStack<ParseItem>::iterator> begins = parseStacks.connect(stackBegin, end);
-                        for(unsigned int i=0; i<begins.size(); i++) {
-                            std::shared_ptr<ParseData> data = it->second(begins[i], end);
-                            ParseItem newItem;
-                            newItem.type = ParseItem::Type::Nonterminal;
-                            newItem.index = rule;
-                            newItem.data = data;
-                            if(i < begins.size() - 1) {
-                                size_t newStack = parseStacks.add(stackBegin);
-                                parseStacks.push_back(newStack, std::move(newItem));
-                            } else {
-                                parseStacks.relocate(stack, stackBegin);
-                                parseStacks.push_back(stack, std::move(newItem));
-                            }
-                        }
-                    }
+                    mProfiler.countReduction(item.rule);
+                    forest.addPacked(node, item.rule, item.rhs, std::move(children));
                 }
             }
+
+            return node;
         }
     }
 }
@@ -20,5 +20,10 @@ namespace Parser
 
             computeParseTable(states, getReduceSet);
         }
+
+        GLR::GLR(const Grammar &grammar, Util::BinaryReader &reader)
+        : LRMulti(grammar, reader)
+        {
+        }
     }
 }
\ No newline at end of file
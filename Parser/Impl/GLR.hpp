@@ -2,7 +2,10 @@
 #define PARSER_IMPL_GLR_HPP
 
 #include "Parser/Impl/LRMulti.hpp"
-#include "Util/MultiStack.hpp"
+#include "Parser/Forest.hpp"
+#include "Parser/Profiler.hpp"
+#include "Util/Arena.hpp"
+#include "Util/GraphStack.hpp"
 
 namespace Parser
 {
@@ -12,52 +15,45 @@ namespace Parser
         {
         public:
             GLR(const Grammar &grammar);
+            GLR(const Grammar &grammar, Util::BinaryReader &reader);
 
-            template<typename ParseData> class ParseSession
+            template<typename ParseData, typename DataPointer = std::shared_ptr<ParseData>, typename ProfilerType = NullProfiler> class ParseSession
             {
             public:
-                struct ParseItem {
-                    enum class Type {
-                        Terminal,
-                        Nonterminal
-                    };
-                    Type type;
-                    unsigned int index;
-                    std::shared_ptr<ParseData> data;
-
-                    typedef ParseItem* iterator;
-                };
-
-                typedef std::function<std::shared_ptr<ParseData>(const Tokenizer::Token&)> TerminalDecorator;
-                typedef std::function<std::shared_ptr<ParseData>(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
+                typedef typename Forest<ParseData, DataPointer>::Item ParseItem;
+                typedef std::function<DataPointer(const Tokenizer::Token&)> TerminalDecorator;
+                typedef typename Forest<ParseData, DataPointer>::Reducer Reducer;
+                typedef typename Forest<ParseData, DataPointer>::Chooser Chooser;
                 
                 ParseSession(const GLR &parser);
             
                 void addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator);
                 void addReducer(const std::string &rule, Reducer reducer);
+                Util::Arena &arena();
+                ProfilerType &profiler();
 
-                std::vector<std::shared_ptr<ParseData>> parse(Tokenizer::Stream &stream);
+                std::vector<DataPointer> parse(Tokenizer::Stream &stream);
+                Forest<ParseData, DataPointer> parseForest(Tokenizer::Stream &stream);
+                DataPointer evaluate(const Forest<ParseData, DataPointer> &forest, Chooser chooser = Chooser()) const;
 
             private:
-                struct StackItem {
-                    unsigned int state;
-                    std::vector<ParseItem> parseItems;
-                };
-
-                void reduce(Util::MultiStack<StackItem> &stacks, size_t stack, unsigned int rule, unsigned int rhs, bool allowRelocate);
+                Forest<ParseData, DataPointer> buildForest(Tokenizer::Stream &stream);
+                size_t reductionSize(const Reduction &reduction) const;
 
                 const GLR &mParser;
-                std::map<unsigned int, TerminalDecorator> mTerminalDecorators;
-                std::map<unsigned int, Reducer> mReducers;
+                std::vector<TerminalDecorator> mTerminalDecorators;
+                std::vector<Reducer> mReducers;
+                Util::Arena mArena;
+                mutable ProfilerType mProfiler;
             };
         };
 
-        template<typename ParseData> GLR::ParseSession<ParseData>::ParseSession(const GLR &parser)
-        : mParser(parser)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> GLR::ParseSession<ParseData, DataPointer, ProfilerType>::ParseSession(const GLR &parser)
+        : mParser(parser), mTerminalDecorators(parser.grammar().terminals().size()), mReducers(parser.grammar().rules().size())
         {
         }
 
-        template<typename ParseData> void GLR::ParseSession<ParseData>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void GLR::ParseSession<ParseData, DataPointer, ProfilerType>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
         {
             unsigned int terminalIndex = mParser.grammar().terminalIndex(terminal);
             if(terminalIndex != UINT_MAX) {
@@ -65,7 +61,7 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> void GLR::ParseSession<ParseData>::addReducer(const std::string &rule, Reducer reducer)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void GLR::ParseSession<ParseData, DataPointer, ProfilerType>::addReducer(const std::string &rule, Reducer reducer)
         {
             unsigned int ruleIndex = mParser.grammar().ruleIndex(rule);
             if(ruleIndex != UINT_MAX) {
@@ -73,180 +69,235 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> std::vector<std::shared_ptr<ParseData>> GLR::ParseSession<ParseData>::parse(Tokenizer::Stream &stream)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Util::Arena &GLR::ParseSession<ParseData, DataPointer, ProfilerType>::arena()
         {
-            Util::MultiStack<StackItem> stacks;
-            stacks.push_back(0, StackItem{0});    
+            return mArena;
+        }
 
-            while(true) {
-                std::shared_ptr<ParseData> terminal;
-                auto it = mTerminalDecorators.find(stream.nextToken().value);
-                if(it != mTerminalDecorators.end()) {
-                    terminal = it->second(stream.nextToken());
-                }
+        template<typename ParseData, typename DataPointer, typename ProfilerType> ProfilerType &GLR::ParseSession<ParseData, DataPointer, ProfilerType>::profiler()
+        {
+            return mProfiler;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> std::vector<DataPointer> GLR::ParseSession<ParseData, DataPointer, ProfilerType>::parse(Tokenizer::Stream &stream)
+        {
+            Forest<ParseData, DataPointer> forest = parseForest(stream);
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                    return forest.evaluateAll(mReducers);
+                });
+            });
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer GLR::ParseSession<ParseData, DataPointer, ProfilerType>::evaluate(const Forest<ParseData, DataPointer> &forest, Chooser chooser) const
+        {
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                    return forest.evaluate(mReducers, chooser);
+                });
+            });
+        }
 
-                bool repeat = false;
-                for(size_t i=0; i<stacks.size() || repeat; i++) {
-                    if(repeat) {
-                        i--;
-                        repeat = false;
-                        if(i >= stacks.size()) {
-                            break;
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Forest<ParseData, DataPointer> GLR::ParseSession<ParseData, DataPointer, ProfilerType>::parseForest(Tokenizer::Stream &stream)
+        {
+            return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return buildForest(stream);
+            });
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Forest<ParseData, DataPointer> GLR::ParseSession<ParseData, DataPointer, ProfilerType>::buildForest(Tokenizer::Stream &stream)
+        {
+            Forest<ParseData, DataPointer> forest;
+            Util::GraphStack<unsigned int> stack;
+            std::vector<unsigned int> frontier;
+            std::vector<unsigned int> stateNodes(mParser.mParseTable.width(), Util::GraphStack<unsigned int>::kNone);
+            std::vector<bool> processed;
+            std::vector<std::pair<unsigned int, unsigned int>> shifts;
+            unsigned int level = 0;
+
+            frontier.push_back(stack.addNode(0, level));
+            stateNodes[0] = frontier[0];
+            processed.push_back(false);
+
+            auto forEachReduction = [&](unsigned int node, unsigned int terminal, auto f) {
+                const ParseTableEntry &entry = mParser.mParseTable.at(stack.state(node), terminal);
+                if(entry.type == ParseTableEntry::Type::Reduce) {
+                    f(mParser.mReductions[entry.index]);
+                } else if(entry.type == ParseTableEntry::Type::Multi) {
+                    for(const auto &multiEntry : mParser.mMultiEntries[entry.index]) {
+                        if(multiEntry.type == ParseTableEntry::Type::Reduce) {
+                            f(mParser.mReductions[multiEntry.index]);
                         }
                     }
+                }
+            };
 
-                    unsigned int state = stacks.back(i).state;
-                    if(mParser.mAcceptStates.count(state) > 0) {
+            auto addPacked = [&](unsigned int node, const Reduction &reduction, const unsigned int *edges, size_t size) {
+                unsigned int forestNode = forest.addNonterminal(reduction.rule, stack.level(node), level);
+                std::vector<unsigned int> children(size);
+                for(size_t i=0; i<size; i++) {
+                    children[i] = stack.edgeData(edges[size - 1 - i]);
+                }
+                forest.addPacked(forestNode, reduction.rule, reduction.rhs, std::move(children));
+                return forestNode;
+            };
+
+            std::function<void(unsigned int, const Reduction &, const unsigned int *, size_t, unsigned int)> reducePath;
+            reducePath = [&](unsigned int node, const Reduction &reduction, const unsigned int *edges, size_t size, unsigned int terminal) {
+                mProfiler.countReduction(reduction.rule);
+                unsigned int forestNode = addPacked(node, reduction, edges, size);
+
+                unsigned int state = mParser.mParseTable.at(stack.state(node), mParser.ruleIndex(reduction.rule)).index;
+                unsigned int target = stateNodes[state];
+                if(target == Util::GraphStack<unsigned int>::kNone) {
+                    target = stack.addNode(state, level);
+                    stateNodes[state] = target;
+                    frontier.push_back(target);
+                    processed.push_back(false);
+                    stack.addEdge(target, node, forestNode);
+                    return;
+                }
+
+                // Every edge between the same two nodes carries the same forest node, so a second
+                // derivation only adds a packed alternative and leaves the stack alone.
+                mProfiler.countMerge();
+                if(stack.findEdge(target, node) != Util::GraphStack<unsigned int>::kNone) {
+                    return;
+                }
+
+                // An edge added to a node whose reductions have already run opens up new paths through
+                // every processed node on this level.  Enumerate exactly those paths that use it.
+                unsigned int edge = stack.addEdge(target, node, forestNode);
+                for(size_t i=0; i<frontier.size(); i++) {
+                    if(!processed[frontier[i]]) {
                         continue;
                     }
 
-                    const ParseTableEntry &entry = mParser.mParseTable.at(state, stream.nextToken().value);
-                    switch(entry.type) {
-                        case ParseTableEntry::Type::Shift:
-                        {
-                            ParseItem parseItem{ParseItem::Type::Terminal, stream.nextToken().value, terminal};
-                            StackItem stackItem;
-                            stackItem.state = entry.index;
-                            stackItem.parseItems.push_back(std::move(parseItem));
-                            stacks.push_back(i, std::move(stackItem));
-                            break;
-                        }
+                    forEachReduction(frontier[i], terminal, [&](const Reduction &limitedReduction) {
+                        size_t length = reductionSize(limitedReduction);
+                        stack.forEachPathThrough(frontier[i], length, edge, [&](unsigned int end, const unsigned int *limitedEdges) {
+                            reducePath(end, limitedReduction, limitedEdges, length, terminal);
+                        });
+                    });
+                }
+            };
 
-                        case ParseTableEntry::Type::Reduce:
-                        {
-                            const Reduction &reduction = mParser.mReductions[entry.index];
-                            reduce(stacks, i, reduction.rule, reduction.rhs, true);
-                            repeat = true;
-                            break;
-                        }
+            while(true) {
+                unsigned int terminal = mProfiler.time(ProfileCounters::Phase::Tokenizer, [&]() {
+                    return stream.nextToken().value;
+                });
 
-                        case ParseTableEntry::Type::Multi:
-                        {
-                            const auto &entries = mParser.mMultiEntries[entry.index];
-                            for(size_t j=0; j<entries.size(); j++) {
-                                const auto &entry = entries[j];
-                                switch(entry.type) {
-                                    case ParseTableEntry::Type::Reduce:
-                                    {
-                                        const Reduction &reduction = mParser.mReductions[entry.index];
-                                        bool allowRelocate = false;
-                                        if(j == entries.size() - 1) {
-                                            allowRelocate = true;
-                                            repeat = true;
-                                        }
-                                        reduce(stacks, i, reduction.rule, reduction.rhs, allowRelocate);
-                                        break;
-                                    }
-
-                                    case ParseTableEntry::Type::Shift:
-                                    {
-                                        ParseItem parseItem{ParseItem::Type::Terminal, stream.nextToken().value, terminal};
-                                        StackItem stackItem;
-                                        stackItem.state = entry.index;
-                                        stackItem.parseItems.push_back(std::move(parseItem));
-                                        stacks.push_back(i, std::move(stackItem));
-                                        break;
-                                    }
-
-                                    default:
-                                        break;
-                                }
+                // An unrecognized token has no column in the table; the parse fails there with no root.
+                if(terminal >= mParser.mGrammar.terminals().size()) {
+                    return forest;
+                }
+
+                DataPointer terminalData{};
+                if(terminal < mTerminalDecorators.size() && mTerminalDecorators[terminal]) {
+                    terminalData = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                        return mTerminalDecorators[terminal](stream.nextToken());
+                    });
+                }
+
+                shifts.clear();
+                for(size_t i=0; i<frontier.size(); i++) {
+                    unsigned int node = frontier[i];
+                    unsigned int state = stack.state(node);
+                    if(mParser.mAcceptStates.count(state) > 0) {
+                        continue;
+                    }
+
+                    unsigned int edgeLimit = stack.numEdges();
+                    processed[node] = true;
+                    size_t numShifts = shifts.size();
+                    unsigned int numActions = 0;
+
+                    const ParseTableEntry &entry = mParser.mParseTable.at(state, terminal);
+                    if(entry.type == ParseTableEntry::Type::Shift) {
+                        shifts.push_back(std::make_pair(node, entry.index));
+                    } else if(entry.type == ParseTableEntry::Type::Multi) {
+                        for(const auto &multiEntry : mParser.mMultiEntries[entry.index]) {
+                            if(multiEntry.type == ParseTableEntry::Type::Shift) {
+                                shifts.push_back(std::make_pair(node, multiEntry.index));
                             }
-                            break;
                         }
+                    }
 
-                        case ParseTableEntry::Type::Error:
-                        {
-                            stacks.erase(i);
-                            repeat = true;
-                            break;
-                        }
+                    forEachReduction(node, terminal, [&](const Reduction &reduction) {
+                        numActions++;
+                        size_t length = reductionSize(reduction);
+                        stack.forEachPath(node, length, edgeLimit, [&](unsigned int end, const unsigned int *edges) {
+                            reducePath(end, reduction, edges, length, terminal);
+                        });
+                    });
+
+                    // A node with more than one action on the terminal forks the stack.
+                    numActions += (unsigned int)(shifts.size() - numShifts);
+                    if(numActions > 1) {
+                        mProfiler.countSplit();
                     }
                 }
 
-                if(stream.nextToken().value == stream.tokenizer().endValue()) {
-                    break;
+                for(unsigned int node : frontier) {
+                    stateNodes[stack.state(node)] = Util::GraphStack<unsigned int>::kNone;
                 }
-                stream.consumeToken();
-
-                if(stacks.size() > 1) {
-                    std::map<unsigned int, size_t> stackMap;
-                    repeat = false;
-                    for(size_t i=0; i<stacks.size() || repeat; i++) {
-                        if(repeat) {
-                            i--;
-                            repeat = false;
-                            if(i >= stacks.size()) {
-                                break;
-                            }
-                        }
-                        const StackItem &stackItem = stacks.back(i);
-                        auto it = stackMap.find(stackItem.state);
-                        if(it == stackMap.end()) {
-                            stackMap[stackItem.state] = i;
-                        } else {
-                            stacks.pop_back(i);
-                            std::vector<Util::MultiStack<StackItem>::iterator> begins = stacks.backtrack(stacks.end(it->second), 1);
-                            stacks.join(i, begins[0]);
-                            repeat = true;
-                        }
+                frontier.clear();
+
+                if(shifts.size() == 0) {
+                    return forest;
+                }
+
+                unsigned int forestNode = forest.addTerminal(terminal, level, std::move(terminalData));
+                level++;
+                for(const auto &shift : shifts) {
+                    mProfiler.countShift();
+                    unsigned int target = stateNodes[shift.second];
+                    if(target == Util::GraphStack<unsigned int>::kNone) {
+                        target = stack.addNode(shift.second, level);
+                        stateNodes[shift.second] = target;
+                        frontier.push_back(target);
+                        processed.push_back(false);
+                    } else {
+                        mProfiler.countMerge();
                     }
+                    stack.addEdge(target, shift.first, forestNode);
+                }
+
+                mProfiler.countToken();
+                if(terminal == stream.tokenizer().endValue()) {
+                    break;
                 }
+                mProfiler.time(ProfileCounters::Phase::Tokenizer, [&]() {
+                    stream.consumeToken();
+                });
             }
 
-            std::vector<std::shared_ptr<ParseData>> results;
-            for(size_t i=0; i<stacks.size(); i++) {
-                reduce(stacks, i, mParser.mGrammar.startRule(), 0, true);
-                results.push_back(stacks.back(i).parseItems[0].data);
+            Reduction startReduction{mParser.mGrammar.startRule(), 0};
+            size_t length = reductionSize(startReduction);
+            for(unsigned int node : frontier) {
+                if(mParser.mAcceptStates.count(stack.state(node)) == 0) {
+                    continue;
+                }
+
+                stack.forEachPath(node, length, stack.numEdges(), [&](unsigned int end, const unsigned int *edges) {
+                    mProfiler.countReduction(startReduction.rule);
+                    forest.setRoot(addPacked(end, startReduction, edges, length));
+                });
             }
 
-            return results;
+            return forest;
         }
 
-        template<typename ParseData> void GLR::ParseSession<ParseData>::reduce(Util::MultiStack<StackItem> &stacks, size_t stack, unsigned int rule, unsigned int rhs, bool allowRelocate)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> size_t GLR::ParseSession<ParseData, DataPointer, ProfilerType>::reductionSize(const Reduction &reduction) const
         {
             size_t size = 0;
-            for(const auto &symbol: mParser.mGrammar.rules()[rule].rhs[rhs]) {
+            for(const auto &symbol: mParser.mGrammar.rules()[reduction.rule].rhs[reduction.rhs]) {
                 if(symbol.type != Grammar::Symbol::Type::Epsilon) {
                     size++;
                 }
             }
 
-            Util::MultiStack<StackItem>::Locator end = stacks.end(stack);
-            std::vector<Util::MultiStack<StackItem>::iterator> begins = stacks.backtrack(end, size + 1);
-            for(size_t i = 0; i<begins.size(); i++) {
-                auto &begin = begins[i];
-                std::vector<ParseItem> parseStack;
-                parseStack.reserve(size);
-                
-                unsigned int state = begin->state;
-                const ParseTableEntry &newEntry = mParser.mParseTable.at(state, mParser.ruleIndex(rule));
-                state = newEntry.index;
-
-                ++begin;
-                for(auto it = begin; it != end; ++it) {
-                    parseStack.insert(parseStack.end(), it->parseItems.begin(), it->parseItems.end());
-                }
-
-                StackItem stackItem;
-                stackItem.state = state;
-
-                auto it = mReducers.find(rule);
-                if(it == mReducers.end()) {
-                    stackItem.parseItems = std::move(parseStack);
-                } else {
-                    std::shared_ptr<ParseData> data = it->second(&parseStack[0], &parseStack[0] + parseStack.size());
-                    stackItem.parseItems.push_back(ParseItem{ParseItem::Type::Nonterminal, rule, data});
-                }
-
-                if(i == begins.size() - 1 && allowRelocate) {
-                    stacks.relocate(stack, begin);
-                    stacks.push_back(stack, stackItem);
-                } else {
-                    size_t newStack = stacks.add(begin);
-                    stacks.push_back(newStack, stackItem);
-                }
-            }
+            return size;
         }
     }
 }
@@ -1,7 +1,6 @@
 #include "Parser/Impl/LALR.hpp"
 
-#include <iostream>
-#include <sstream>
+#include "Util/Digraph.hpp"
 
 namespace Parser
 {
@@ -12,93 +11,96 @@ namespace Parser
         {
             std::vector<State> states = computeStates();
 
-            std::vector<std::pair<unsigned int, unsigned int>> newNonterminals;
-            auto findNonterminal = [&](unsigned int state, unsigned int rule) {
-                for(unsigned int i=0; i<newNonterminals.size(); i++) {
-                    if(newNonterminals[i] == std::make_pair(state, rule)) { return i;}
-                }
-                return UINT_MAX;
-            };
+            Util::BitSet nullableNonterminals = mGrammar.computeNullable();
+
+            unsigned int numTerminals = (unsigned int)mGrammar.terminals().size();
 
-            std::vector<Grammar::Rule> newRules;
+            struct Transition {
+                unsigned int state;
+                unsigned int rule;
+                unsigned int target;
+            };
+            std::vector<Transition> transitions;
+            std::vector<std::map<unsigned int, unsigned int>> transitionIndices(states.size());
             for(unsigned int i=0; i<states.size(); i++) {
-                for(const auto &item : states[i].items) {
-                    if(item.pos == 0 && findNonterminal(i, item.rule) == UINT_MAX) {
-                        newNonterminals.push_back(std::make_pair(i, item.rule));
-                        std::stringstream ss;
-                        ss << grammar.rules()[item.rule].lhs << "@" << i;
-                        newRules.push_back(Grammar::Rule{ss.str()});        
+                for(const auto &transition : states[i].transitions) {
+                    if(transition.first >= numTerminals) {
+                        unsigned int rule = transition.first - numTerminals;
+                        transitionIndices[i][rule] = (unsigned int)transitions.size();
+                        transitions.push_back(Transition{i, rule, transition.second});
                     }
                 }
             }
 
-            std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> reductionStarts;
-            for(unsigned int i=0; i<states.size(); i++) {
-                const State &state = states[i];
+            std::vector<Util::BitSet> lookaheadSets(transitions.size(), Util::BitSet(numTerminals));
+            std::vector<std::vector<unsigned int>> reads(transitions.size());
+            for(unsigned int i=0; i<transitions.size(); i++) {
+                for(const auto &transition : states[transitions[i].target].transitions) {
+                    if(transition.first < numTerminals) {
+                        lookaheadSets[i].set(transition.first);
+                    } else if(nullableNonterminals.test(transition.first - numTerminals)) {
+                        reads[i].push_back(transitionIndices[transitions[i].target][transition.first - numTerminals]);
+                    }
+                }
+            }
+            Util::propagateSets(reads, lookaheadSets);
 
-                for(const auto &item : state.items) {
-                    if(item.pos == 0) {
-                        const Grammar::RHS &rhs = grammar.rules()[item.rule].rhs[item.rhs];
-                        
-                        Grammar::RHS newRhs;
-                        unsigned int stateNum = i;
-                        for(unsigned int j=0; j<rhs.size(); j++) {
-                            switch(rhs[j].type) {
-                                case Grammar::Symbol::Type::Nonterminal:
-                                {
-                                    unsigned int s = findNonterminal(stateNum, rhs[j].index);
-                                    newRhs.push_back(Grammar::Symbol{Grammar::Symbol::Type::Nonterminal, s});
-                                    auto it = states[stateNum].transitions.find(symbolIndex(rhs[j]));
-                                    stateNum = it->second;
-                                    break;
-                                }
-                                case Grammar::Symbol::Type::Terminal:
-                                {
-                                    newRhs.push_back(rhs[j]);
-                                    auto it = states[stateNum].transitions.find(symbolIndex(rhs[j]));
-                                    stateNum = it->second;
-                                    break;
-                                }
-                                case Grammar::Symbol::Type::Epsilon:
-                                {
-                                    newRhs.push_back(rhs[j]);
-                                    break;
-                                }
-                            }
+            std::vector<std::vector<unsigned int>> includes(transitions.size());
+            std::map<std::pair<unsigned int, unsigned int>, std::vector<unsigned int>> lookbacks;
+            for(unsigned int i=0; i<transitions.size(); i++) {
+                const Grammar::Rule &rule = mGrammar.rules()[transitions[i].rule];
+                for(const Grammar::RHS &rhs : rule.rhs) {
+                    std::vector<unsigned int> path;
+                    unsigned int state = transitions[i].state;
+                    for(const Grammar::Symbol &symbol : rhs) {
+                        path.push_back(state);
+                        if(symbol.type != Grammar::Symbol::Type::Epsilon) {
+                            state = states[state].transitions.at(symbolIndex(symbol));
                         }
+                    }
+                    lookbacks[std::make_pair(state, transitions[i].rule)].push_back(i);
 
-                        unsigned int r = findNonterminal(i, item.rule);
-                        newRules[r].rhs.push_back(std::move(newRhs));
-        
-                        reductionStarts[std::make_pair(stateNum, item.rule)].insert(i);
-                    }    
-                }
-            }
+                    bool nullable = true;
+                    for(unsigned int j=(unsigned int)rhs.size(); j>0 && nullable; j--) {
+                        const Grammar::Symbol &symbol = rhs[j - 1];
+                        switch(symbol.type) {
+                            case Grammar::Symbol::Type::Terminal:
+                                nullable = false;
+                                break;
 
-            Grammar newGrammar(grammar.terminals(), std::move(newRules), grammar.startRule());
+                            case Grammar::Symbol::Type::Nonterminal:
+                                includes[transitionIndices[path[j - 1]][symbol.index]].push_back(i);
+                                nullable = nullableNonterminals.test(symbol.index);
+                                break;
 
-            std::vector<std::set<unsigned int>> firstSets;
-            std::vector<std::set<unsigned int>> followSets;
-            std::set<unsigned int> nullableTerminals;
-            newGrammar.computeSets(firstSets, followSets, nullableTerminals);
+                            case Grammar::Symbol::Type::Epsilon:
+                                break;
+                        }
+                    }
+                }
+            }
+            Util::propagateSets(includes, lookaheadSets);
 
-            std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> followPerStateSets;
-            for(const auto &it : reductionStarts) {
-                unsigned int reduceState = it.first.first;
-                unsigned int rule = it.first.second;
-                for(unsigned int startState : it.second) {
-                    unsigned int r = findNonterminal(startState, rule);
-                    followPerStateSets[std::make_pair(reduceState, rule)].insert(followSets[r].begin(), followSets[r].end());
+            std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> reduceLookaheads;
+            for(const auto &lookback : lookbacks) {
+                std::set<unsigned int> &terminals = reduceLookaheads[lookback.first];
+                for(unsigned int transition : lookback.second) {
+                    lookaheadSets[transition].forEach([&](unsigned int terminal) { terminals.insert(terminal); });
                 }
             }
 
             auto getReduceLookahead = [&](unsigned int state, unsigned int rule) {
-                return followPerStateSets[std::make_pair(state, rule)];
+                return reduceLookaheads[std::make_pair(state, rule)];
             };
 
             if(computeParseTable(states, getReduceLookahead)) {
                 mValid = true;
             }
         }
+
+        LALR::LALR(const Grammar &grammar, Util::BinaryReader &reader)
+        : LRSingle(grammar, reader)
+        {
+        }
     }
-}
\ No newline at end of file
+}
@@ -11,6 +11,7 @@ namespace Parser
         {
         public:
             LALR(const Grammar &grammar);
+            LALR(const Grammar &grammar, Util::BinaryReader &reader);
         };
     }
 }
@@ -17,6 +17,47 @@ namespace Parser
             mValid = computeParseTable(firstSets, followSets, nullableNonterminals);
         }
 
+        LL::LL(const Grammar &grammar, Util::BinaryReader &reader)
+        : Base(grammar)
+        {
+            reader.expect(Util::binaryTag("LL  "));
+            mParseTable.load(reader);
+            reader.read(mValid);
+            reader.read(mConflict);
+            if(reader.valid() && !validateTable()) {
+                reader.invalidate();
+            }
+            if(!reader.valid()) {
+                mValid = false;
+            }
+        }
+
+        bool LL::validateTable() const
+        {
+            if(mParseTable.width() != mGrammar.rules().size() || mParseTable.height() != mGrammar.terminals().size()) {
+                return false;
+            }
+
+            for(unsigned int i=0; i<mParseTable.width(); i++) {
+                for(unsigned int j=0; j<mParseTable.height(); j++) {
+                    unsigned int rhs = mParseTable.at(i, j);
+                    if(rhs != UINT_MAX && rhs >= mGrammar.rules()[i].rhs.size()) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        void LL::save(Util::BinaryWriter &writer) const
+        {
+            writer.write(Util::binaryTag("LL  "));
+            mParseTable.save(writer);
+            writer.write(mValid);
+            writer.write(mConflict);
+        }
+
         bool LL::addParseTableEntry(unsigned int rule, unsigned int symbol, unsigned int rhs)
         {
             if(mParseTable.at(rule, symbol) == UINT_MAX) {
@@ -2,8 +2,12 @@
 #define PARSER_IMPL_LL_HPP
 
 #include "Parser/Base.hpp"
+#include "Parser/Impl/Session.hpp"
+#include "Parser/Diagnostic.hpp"
+#include "Parser/Profiler.hpp"
 #include "Parser/Tokenizer.hpp"
 
+#include "Util/Arena.hpp"
 #include "Util/Table.hpp"
 
 #include <vector>
@@ -16,6 +20,9 @@ namespace Parser
         class LL : public Base {
         public:
             LL(const Grammar &grammar);
+            LL(const Grammar &grammar, Util::BinaryReader &reader);
+
+            void save(Util::BinaryWriter &writer) const;
 
             bool valid() const;
 
@@ -29,7 +36,7 @@ namespace Parser
 
             unsigned int rhs(unsigned int rule, unsigned int symbol) const;
 
-            template<typename ParseData> class ParseSession
+            template<typename ParseData, typename DataPointer = std::unique_ptr<ParseData>, typename ProfilerType = NullProfiler> class ParseSession
             {
             public:
                 struct ParseItem {
@@ -39,13 +46,13 @@ namespace Parser
                     };
                     Type type;
                     unsigned int index;
-                    std::unique_ptr<ParseData> data;
+                    DataPointer data{};
 
                     typedef ParseItem* iterator;
                 };
 
-                typedef std::function<std::unique_ptr<ParseData>(const Tokenizer::Token&)> TerminalDecorator;
-                typedef std::function<std::unique_ptr<ParseData>(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
+                typedef std::function<DataPointer(const Tokenizer::Token&)> TerminalDecorator;
+                typedef std::function<DataPointer(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
                 typedef std::function<void(unsigned int)> MatchListener;
 
                 ParseSession(const LL &parser);
@@ -53,32 +60,100 @@ namespace Parser
                 void addMatchListener(const std::string &rule, MatchListener matchListener);        
                 void addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator);
                 void addReducer(const std::string &rule, Reducer reducer);
+                Util::Arena &arena();
+
+                // Capacity above which a stack is released after a parse instead of kept; see releaseStack().
+                void setRetainedCapacity(size_t capacity);
+
+                // With recovery enabled a syntax error is recorded in diagnostics() and the parse carries
+                // on, and a result is returned if the parse still reaches the end of the input.  If the
+                // grammar uses the error terminal, predictions are abandoned until one which can begin
+                // with error, which is passed to reducers with no data; otherwise tokens are discarded
+                // until the current prediction accepts one.  Only the first error is reported until three
+                // tokens have been matched after it.
+                void setRecovery(bool recovery);
+                const std::vector<Diagnostic> &diagnostics() const;
 
-                std::unique_ptr<ParseData> parse(Tokenizer::Stream &stream) const;
+                ProfilerType &profiler();
+
+                DataPointer parse(Tokenizer::Stream &stream);
+
+                // Push-mode parsing; see PushParse in Parser/Impl/Session.hpp.
+                void start(const Tokenizer &tokenizer);
+                bool feed(std::string_view bytes);
+                DataPointer finish();
 
             private:
+                struct PredictItem {
+                    enum class Type {
+                        Terminal,
+                        Nonterminal,
+                        Reduce
+                    };
+                    Type type;
+                    union {
+                        struct {
+                            unsigned int index;
+                            unsigned int rule;
+                            unsigned int pos;
+                        } symbol;
+                        struct {
+                            unsigned int rule;
+                            unsigned int parseStackStart;
+                        } reduce;
+                    };
+                };
+
+                struct ParseState {
+                    std::vector<PredictItem> predictStack;
+                    std::vector<ParseItem> parseStack;
+                    unsigned int recovering;
+                    bool errorPending;
+                };
+
+                typedef ParseStatus Status;
+
+                void startState(ParseState &parseState) const;
+                void releaseState(ParseState &parseState) const;
+                Status run(Tokenizer::Stream &stream, ParseState &parseState);
+                bool recover(Tokenizer::Stream &stream, ParseState &parseState);
+
                 const LL &mParser;
-                std::map<unsigned int, MatchListener> mMatchListeners;
-                std::map<unsigned int, TerminalDecorator> mTerminalDecorators;
-                std::map<unsigned int, Reducer> mReducers;
+                std::vector<MatchListener> mMatchListeners;
+                std::vector<TerminalDecorator> mTerminalDecorators;
+                std::vector<Reducer> mReducers;
+                Util::Arena mArena;
+
+                ParseState mParseState;
+                size_t mRetainedCapacity;
+
+                bool mRecovery;
+                unsigned int mErrorTerminal;
+                std::vector<Diagnostic> mDiagnostics;
+
+                ProfilerType mProfiler;
+
+                PushParse<ParseState> mPush;
             };
 
         private:
             bool addParseTableEntry(unsigned int rule, unsigned int symbol, unsigned int rhs);
             bool addParseTableEntries(unsigned int rule, const std::set<unsigned int> &symbols, unsigned int rhs);
             bool computeParseTable(const std::vector<std::set<unsigned int>> &firstSets, std::vector<std::set<unsigned int>> &followSets, std::set<unsigned int> &nullableNonterminals);
+            bool validateTable() const;
         
             Util::Table<unsigned int> mParseTable;  
             bool mValid;
             Conflict mConflict;
         };
 
-        template<typename ParseData> LL::ParseSession<ParseData>::ParseSession(const LL &parser)
-        : mParser(parser)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> LL::ParseSession<ParseData, DataPointer, ProfilerType>::ParseSession(const LL &parser)
+        : mParser(parser), mMatchListeners(parser.grammar().rules().size()), mTerminalDecorators(parser.grammar().terminals().size()), mReducers(parser.grammar().rules().size()), mRetainedCapacity(4096), mRecovery(false)
         {
+            mErrorTerminal = parser.grammar().terminalIndex("error");
         }
 
-        template<typename ParseData> void LL::ParseSession<ParseData>::addMatchListener(const std::string &rule, MatchListener matchListener)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::addMatchListener(const std::string &rule, MatchListener matchListener)
         {
             unsigned int ruleIndex = mParser.grammar().ruleIndex(rule);
             if(ruleIndex != UINT_MAX) {
@@ -86,7 +161,7 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> void LL::ParseSession<ParseData>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
         {
             unsigned int terminalIndex = mParser.grammar().terminalIndex(terminal);
             if(terminalIndex != UINT_MAX) {
@@ -94,7 +169,7 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> void LL::ParseSession<ParseData>::addReducer(const std::string &rule, Reducer reducer)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::addReducer(const std::string &rule, Reducer reducer)
         {
             unsigned int ruleIndex = mParser.grammar().ruleIndex(rule);
             if(ruleIndex != UINT_MAX) {
@@ -102,56 +177,148 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> std::unique_ptr<ParseData> LL::ParseSession<ParseData>::parse(Tokenizer::Stream &stream) const
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Util::Arena &LL::ParseSession<ParseData, DataPointer, ProfilerType>::arena()
         {
-            struct PredictItem {
-                enum class Type {
-                    Terminal,
-                    Nonterminal,
-                    Reduce
-                };
-                Type type;
-                union {
-                    struct {
-                        unsigned int index;
-                        unsigned int rule;
-                        unsigned int pos;
-                    } symbol;
-                    struct {
-                        unsigned int rule;
-                        unsigned int parseStackStart;
-                    } reduce;
-                };
-            };
+            return mArena;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::setRetainedCapacity(size_t capacity)
+        {
+            mRetainedCapacity = capacity;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::setRecovery(bool recovery)
+        {
+            mRecovery = recovery;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> const std::vector<Diagnostic> &LL::ParseSession<ParseData, DataPointer, ProfilerType>::diagnostics() const
+        {
+            return mDiagnostics;
+        }
 
-            std::vector<PredictItem> predictStack;
-            std::vector<ParseItem> parseStack;
+        template<typename ParseData, typename DataPointer, typename ProfilerType> ProfilerType &LL::ParseSession<ParseData, DataPointer, ProfilerType>::profiler()
+        {
+            return mProfiler;
+        }
 
-            predictStack.push_back(PredictItem{PredictItem::Type::Nonterminal, mParser.mGrammar.startRule()});
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LL::ParseSession<ParseData, DataPointer, ProfilerType>::parse(Tokenizer::Stream &stream)
+        {
+            startState(mParseState);
+            mDiagnostics.clear();
+
+            DataPointer result{};
+            Status status = mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                return run(stream, mParseState);
+            });
+            if(status == Status::Accepted) {
+                result = std::move(mParseState.parseStack[0].data);
+            }
+
+            releaseState(mParseState);
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::start(const Tokenizer &tokenizer)
+        {
+            startState(mPush.start(tokenizer));
+            mDiagnostics.clear();
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> bool LL::ParseSession<ParseData, DataPointer, ProfilerType>::feed(std::string_view bytes)
+        {
+            return mPush.feed(bytes, [&](Tokenizer::Stream &stream, ParseState &parseState) {
+                return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                    return run(stream, parseState);
+                });
+            });
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LL::ParseSession<ParseData, DataPointer, ProfilerType>::finish()
+        {
+            DataPointer result = mPush.finish([&](Tokenizer::Stream &stream, ParseState &parseState) {
+                return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                    return run(stream, parseState);
+                });
+            }, [&](ParseState &parseState) {
+                return std::move(parseState.parseStack[0].data);
+            });
+
+            releaseState(mPush.state());
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::startState(ParseState &parseState) const
+        {
+            parseState.predictStack.clear();
+            parseState.parseStack.clear();
+            parseState.predictStack.push_back(PredictItem{PredictItem::Type::Nonterminal, mParser.mGrammar.startRule()});
+            parseState.recovering = 0;
+            parseState.errorPending = false;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LL::ParseSession<ParseData, DataPointer, ProfilerType>::releaseState(ParseState &parseState) const
+        {
+            releaseStack(parseState.predictStack, mRetainedCapacity);
+            releaseStack(parseState.parseStack, mRetainedCapacity);
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> typename LL::ParseSession<ParseData, DataPointer, ProfilerType>::Status LL::ParseSession<ParseData, DataPointer, ProfilerType>::run(Tokenizer::Stream &stream, ParseState &parseState)
+        {
+            std::vector<PredictItem> &predictStack = parseState.predictStack;
+            std::vector<ParseItem> &parseStack = parseState.parseStack;
+
+            readToken(stream, mProfiler);
 
             while(predictStack.size() > 0) {
+                if(predictStack.back().type != PredictItem::Type::Reduce && !parseState.errorPending && stream.nextToken().value == Tokenizer::kPendingTokenValue) {
+                    return Status::Pending;
+                }
+
                 PredictItem predictItem = predictStack.back();
                 predictStack.pop_back();
 
+                // While recovering, the error terminal stands in for the next token until it is matched.
+                Tokenizer::TokenValue lookahead = parseState.errorPending ? mErrorTerminal : stream.nextToken().value;
+
                 switch(predictItem.type) {
                     case PredictItem::Type::Terminal:
                     {
-                        if(stream.nextToken().value == predictItem.symbol.index) {
+                        if(lookahead == predictItem.symbol.index) {
                             ParseItem parseItem;
                             parseItem.type = ParseItem::Type::Terminal;
                             parseItem.index = predictItem.symbol.index;
-                            auto it = mTerminalDecorators.find(predictItem.symbol.index);
-                            if(it != mTerminalDecorators.end()) {
-                                parseItem.data = it->second(stream.nextToken());
+                            const TerminalDecorator &terminalDecorator = mTerminalDecorators[predictItem.symbol.index];
+                            if(terminalDecorator && !parseState.errorPending) {
+                                parseItem.data = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                                    return terminalDecorator(stream.nextToken());
+                                });
                             }
                             parseStack.push_back(std::move(parseItem));
-                            auto it2 = mMatchListeners.find(predictItem.symbol.rule);
-                            if(it2 != mMatchListeners.end()) {
-                                it2->second(predictItem.symbol.pos);
+                            const MatchListener &matchListener = mMatchListeners[predictItem.symbol.rule];
+                            if(matchListener) {
+                                mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                                    matchListener(predictItem.symbol.pos);
+                                });
+                            }
+
+                            if(parseState.errorPending) {
+                                parseState.errorPending = false;
+                            } else {
+                                mProfiler.countShift();
+                                mProfiler.countToken();
+                                mProfiler.time(ProfileCounters::Phase::Tokenizer, [&]() {
+                                    stream.consumeToken();
+                                });
+                                if(parseState.recovering > 0) {
+                                    parseState.recovering--;
+                                }
                             }
-                            stream.consumeToken();
                         } else {
-                            return std::unique_ptr<ParseData>();
+                            predictStack.push_back(predictItem);
+                            if(!mRecovery || !recover(stream, parseState)) {
+                                return Status::Error;
+                            }
                         }
                         break;
                     }
@@ -159,13 +326,21 @@ namespace Parser
                     case PredictItem::Type::Nonterminal:
                     {
                         unsigned int nextRule = predictItem.symbol.index;
-                        unsigned int nextRhs = mParser.rhs(nextRule, stream.nextToken().value);
+                        unsigned int nextRhs = mParser.rhs(nextRule, lookahead);
 
                         if(nextRhs == UINT_MAX) {
-                            return std::unique_ptr<ParseData>();
-                        }   
+                            predictStack.push_back(predictItem);
+                            if(!mRecovery || !recover(stream, parseState)) {
+                                return Status::Error;
+                            }
+                            break;
+                        }
 
-                        if(mReducers.find(nextRule) != mReducers.end()) {
+                        mProfiler.countReduction(nextRule);
+
+                        // With recovery enabled every rule gets a reduce marker, so that recovery knows
+                        // where the items of a rule it abandons begin.
+                        if(mReducers[nextRule] || mRecovery) {
                             predictStack.push_back(PredictItem{PredictItem::Type::Reduce, nextRule, (unsigned int)parseStack.size()});
                         }
 
@@ -194,23 +369,67 @@ namespace Parser
                         unsigned int currentRule = predictItem.reduce.rule;
                         unsigned int parseStackStart = predictItem.reduce.parseStackStart;
 
-                        auto it = mReducers.find(currentRule);
-                        if(it != mReducers.end()) {
-                            std::unique_ptr<ParseData> data = it->second(&parseStack[parseStackStart], &parseStack[0] + parseStack.size());
-                            parseStack.erase(parseStack.begin() + parseStackStart, parseStack.end());
-
-                            ParseItem parseItem;
-                            parseItem.type = ParseItem::Type::Nonterminal;
-                            parseItem.index = currentRule;
-                            parseItem.data = std::move(data);
-                            parseStack.push_back(std::move(parseItem));
+                        const Reducer &reducer = mReducers[currentRule];
+                        if(reducer) {
+                            DataPointer data = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                                return reducer(&parseStack[parseStackStart], &parseStack[0] + parseStack.size());
+                            });
+                            replaceReduced(parseStack, parseStackStart, currentRule, std::move(data));
                         }
                         break;
                     }
                 }
             }
-        
-            return std::move(parseStack[0].data);
+
+            return Status::Accepted;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> bool LL::ParseSession<ParseData, DataPointer, ProfilerType>::recover(Tokenizer::Stream &stream, ParseState &parseState)
+        {
+            switch(startRecovery(stream, parseState, mDiagnostics)) {
+                case RecoveryStart::Abandon:
+                    return false;
+
+                case RecoveryStart::Skipped:
+                    return true;
+
+                case RecoveryStart::Resynchronize:
+                    break;
+            }
+
+            const Tokenizer::Token &token = stream.nextToken();
+            bool end = (token.value == stream.tokenizer().endValue());
+
+            if(mErrorTerminal == UINT_MAX) {
+                if(end) {
+                    return false;
+                }
+                stream.consumeToken();
+                return true;
+            }
+
+            // Abandon predictions until one can begin with error, dropping the items of every rule
+            // abandoned along the way.
+            std::vector<PredictItem> &predictStack = parseState.predictStack;
+            std::vector<ParseItem> &parseStack = parseState.parseStack;
+            while(predictStack.size() > 0) {
+                const PredictItem &predictItem = predictStack.back();
+                if(predictItem.type == PredictItem::Type::Terminal && predictItem.symbol.index == mErrorTerminal) {
+                    break;
+                } else if(predictItem.type == PredictItem::Type::Nonterminal && mParser.rhs(predictItem.symbol.index, mErrorTerminal) != UINT_MAX) {
+                    break;
+                } else if(predictItem.type == PredictItem::Type::Reduce) {
+                    parseStack.erase(parseStack.begin() + predictItem.reduce.parseStackStart, parseStack.end());
+                }
+                predictStack.pop_back();
+            }
+
+            if(predictStack.size() == 0) {
+                return false;
+            }
+
+            parseState.errorPending = true;
+            return true;
         }
     }
 }
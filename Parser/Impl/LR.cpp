@@ -1,6 +1,8 @@
 #include "Parser/Impl/LR.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
 namespace Parser
 {
@@ -24,6 +26,18 @@ namespace Parser
             return rule == other.rule && rhs == other.rhs && pos == other.pos;
         }
 
+        size_t LR::ItemsHash::operator()(const std::vector<Item> &items) const
+        {
+            size_t hash = items.size();
+            for(const auto &item : items) {
+                hash = hash * 31 + item.rule;
+                hash = hash * 31 + item.rhs;
+                hash = hash * 31 + item.pos;
+            }
+
+            return hash;
+        }
+
         unsigned int LR::symbolIndex(const Grammar::Symbol &symbol) const
         {
             switch(symbol.type) {
@@ -46,21 +60,10 @@ namespace Parser
             return (unsigned int)mGrammar.terminals().size() + rule;
         }
 
-        void LR::computeClosure(std::set<Item> &items) const
+        void LR::computeClosure(std::vector<Item> &items, std::vector<bool> &expandedRules) const
         {
-            std::vector<Item> queue;
-            queue.insert(queue.begin(), items.begin(), items.end());
-
-            auto addItem = [&](const Item &item) {
-                if(items.count(item) == 0) {
-                    items.insert(item);
-                    queue.push_back(item);
-                }
-            };
-
-            while(queue.size() > 0) {
-                Item item = queue.front();
-                queue.erase(queue.begin());
+            for(size_t i=0; i<items.size(); i++) {
+                Item item = items[i];
 
                 const Grammar::RHS &rhs = mGrammar.rules()[item.rule].rhs[item.rhs];
                 if(item.pos < rhs.size()) {
@@ -68,70 +71,69 @@ namespace Parser
                         case Grammar::Symbol::Type::Nonterminal:
                         {
                             unsigned int newRuleIndex = rhs[item.pos].index;
-                            const Grammar::Rule &newRule = mGrammar.rules()[newRuleIndex];
+                            if(!expandedRules[newRuleIndex]) {
+                                expandedRules[newRuleIndex] = true;
 
-                            for(unsigned int i=0; i<newRule.rhs.size(); i++) {
-                                addItem(Item{newRuleIndex, i, 0});
+                                const Grammar::Rule &newRule = mGrammar.rules()[newRuleIndex];
+                                for(unsigned int j=0; j<newRule.rhs.size(); j++) {
+                                    items.push_back(Item{newRuleIndex, j, 0});
+                                }
                             }
                             break;
                         }
 
                         case Grammar::Symbol::Type::Epsilon:
                         {
-                            addItem(Item{item.rule, item.rhs, item.pos + 1});
+                            items.push_back(Item{item.rule, item.rhs, item.pos + 1});
                             break;
                         }
                     }
                 }
             }
+
+            for(const auto &item : items) {
+                expandedRules[item.rule] = false;
+            }
+
+            std::sort(items.begin(), items.end());
+            items.erase(std::unique(items.begin(), items.end()), items.end());
         }
 
         std::vector<LR::State> LR::computeStates() const
         {
             std::vector<State> states;
+            std::unordered_map<std::vector<Item>, unsigned int, ItemsHash> stateIndices;
+            std::vector<bool> expandedRules(mGrammar.rules().size(), false);
 
             State start;
             for(unsigned int i=0; i<mGrammar.rules()[mGrammar.startRule()].rhs.size(); i++) {
-                start.items.insert(Item{mGrammar.startRule(), i, 0});
+                start.items.push_back(Item{mGrammar.startRule(), i, 0});
             }
-            computeClosure(start.items);
+            stateIndices[start.items] = 0;
+            computeClosure(start.items, expandedRules);
             states.push_back(std::move(start));
 
-            std::vector<unsigned int> queue;
-            queue.push_back(0);
-
-            while(queue.size() > 0) {
-                unsigned int index = queue.front();
-                queue.erase(queue.begin());
-
-                for(unsigned int i=0; i<mGrammar.terminals().size() + mGrammar.rules().size(); i++) {
-                    State &state = states[index];
-                    std::set<Item> newItems;
-                
-                    for(const auto &item : state.items) {
-                        const Grammar::RHS &rhs = mGrammar.rules()[item.rule].rhs[item.rhs];
-                        if(item.pos < rhs.size() && symbolIndex(rhs[item.pos]) == i) {
-                            newItems.insert(Item{item.rule, item.rhs, item.pos + 1});
-                        }
+            for(unsigned int index=0; index<states.size(); index++) {
+                std::map<unsigned int, std::vector<Item>> kernels;
+                for(const auto &item : states[index].items) {
+                    const Grammar::RHS &rhs = mGrammar.rules()[item.rule].rhs[item.rhs];
+                    if(item.pos < rhs.size() && rhs[item.pos].type != Grammar::Symbol::Type::Epsilon) {
+                        kernels[symbolIndex(rhs[item.pos])].push_back(Item{item.rule, item.rhs, item.pos + 1});
                     }
+                }
 
-                    if(newItems.size() > 0) {
-                        computeClosure(newItems);
-
-                        bool found = false;
-                        for(unsigned int j=0; j<states.size(); j++) {
-                            if(states[j].items == newItems) {
-                                state.transitions[i] = j;
-                                found = true;
-                                break;
-                            }
-                        }
+                for(auto &kernel : kernels) {
+                    auto it = stateIndices.find(kernel.second);
+                    if(it != stateIndices.end()) {
+                        states[index].transitions[kernel.first] = it->second;
+                    } else {
+                        unsigned int newIndex = (unsigned int)states.size();
+                        stateIndices[kernel.second] = newIndex;
+                        states[index].transitions[kernel.first] = newIndex;
 
-                        if(!found) {
-                            state.transitions[i] = (unsigned int)states.size();
-                            queue.push_back((unsigned int)states.size());
-                            states.push_back(State{std::move(newItems)});
-                        }
+                        State newState{std::move(kernel.second)};
+                        computeClosure(newState.items, expandedRules);
+                        states.push_back(std::move(newState));
                     }
                 }
             }
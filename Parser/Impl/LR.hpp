@@ -25,12 +25,16 @@ namespace Parser
                 unsigned int pos;
             };
 
+            struct ItemsHash {
+                size_t operator()(const std::vector<Item> &items) const;
+            };
+
             struct State {
-                std::set<Item> items;
+                std::vector<Item> items;
                 std::map<unsigned int, unsigned int> transitions;
             };
 
-            void computeClosure(std::set<Item> &items) const;
+            void computeClosure(std::vector<Item> &items, std::vector<bool> &expandedRules) const;
             std::vector<State> computeStates() const;
 
             typedef std::function<std::set<unsigned int>(unsigned int, unsigned int)> GetReduceLookahead;
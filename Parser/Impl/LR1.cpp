@@ -0,0 +1,223 @@
+#include "Parser/Impl/LR1.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace Parser
+{
+    namespace Impl
+    {
+        LR1::LR1(const Grammar &grammar)
+        : LRSingle(grammar)
+        {
+            std::vector<Util::BitSet> firstSets;
+            std::vector<Util::BitSet> followSets;
+            Util::BitSet nullableNonterminals;
+            mGrammar.computeSets(firstSets, followSets, nullableNonterminals);
+
+            unsigned int numTerminals = (unsigned int)mGrammar.terminals().size();
+
+            std::vector<State> states;
+            std::vector<std::vector<Item>> kernels;
+            std::vector<std::vector<Util::BitSet>> kernelLookaheads;
+            std::vector<std::vector<Util::BitSet>> itemLookaheads;
+            std::unordered_map<std::vector<Item>, std::vector<unsigned int>, ItemsHash> statesByKernel;
+            std::vector<bool> expandedRules(mGrammar.rules().size(), false);
+
+            std::vector<unsigned int> queue;
+            std::vector<bool> queued;
+
+            auto addState = [&](std::vector<Item> kernel, std::vector<Util::BitSet> lookaheads) {
+                unsigned int index = (unsigned int)states.size();
+                statesByKernel[kernel].push_back(index);
+
+                State state{kernel};
+                computeClosure(state.items, expandedRules);
+                states.push_back(std::move(state));
+                kernels.push_back(std::move(kernel));
+                kernelLookaheads.push_back(std::move(lookaheads));
+                itemLookaheads.emplace_back();
+
+                queue.push_back(index);
+                queued.push_back(true);
+                return index;
+            };
+
+            auto mergeLookaheads = [&](unsigned int index, const std::vector<Util::BitSet> &lookaheads) {
+                bool changed = false;
+                for(unsigned int i=0; i<lookaheads.size(); i++) {
+                    changed |= kernelLookaheads[index][i].add(lookaheads[i]);
+                }
+
+                if(changed && !queued[index]) {
+                    queue.push_back(index);
+                    queued[index] = true;
+                }
+            };
+
+            std::vector<Item> startKernel;
+            for(unsigned int i=0; i<mGrammar.rules()[mGrammar.startRule()].rhs.size(); i++) {
+                startKernel.push_back(Item{mGrammar.startRule(), i, 0});
+            }
+            std::vector<Util::BitSet> startLookaheads(startKernel.size(), Util::BitSet(numTerminals));
+            addState(std::move(startKernel), std::move(startLookaheads));
+
+            while(queue.size() > 0) {
+                unsigned int index = queue.back();
+                queue.pop_back();
+                queued[index] = false;
+
+                const std::vector<Item> &items = states[index].items;
+                auto itemIndex = [&](const Item &item) {
+                    return (unsigned int)(std::lower_bound(items.begin(), items.end(), item) - items.begin());
+                };
+
+                std::vector<Util::BitSet> &lookaheads = itemLookaheads[index];
+                lookaheads.assign(items.size(), Util::BitSet(numTerminals));
+                std::vector<unsigned int> pending;
+                std::vector<bool> isPending(items.size(), false);
+                for(unsigned int i=0; i<kernels[index].size(); i++) {
+                    unsigned int item = itemIndex(kernels[index][i]);
+                    lookaheads[item] = kernelLookaheads[index][i];
+                    pending.push_back(item);
+                    isPending[item] = true;
+                }
+
+                while(pending.size() > 0) {
+                    unsigned int i = pending.back();
+                    pending.pop_back();
+                    isPending[i] = false;
+
+                    const Item &item = items[i];
+                    const Grammar::RHS &rhs = mGrammar.rules()[item.rule].rhs[item.rhs];
+                    if(item.pos == rhs.size()) {
+                        continue;
+                    }
+
+                    auto addLookahead = [&](unsigned int target, const Util::BitSet &terminals) {
+                        if(lookaheads[target].add(terminals) && !isPending[target]) {
+                            pending.push_back(target);
+                            isPending[target] = true;
+                        }
+                    };
+
+                    switch(rhs[item.pos].type) {
+                        case Grammar::Symbol::Type::Nonterminal:
+                        {
+                            Util::BitSet terminals(numTerminals);
+                            bool nullable = true;
+                            for(unsigned int j=item.pos + 1; j<rhs.size() && nullable; j++) {
+                                switch(rhs[j].type) {
+                                    case Grammar::Symbol::Type::Terminal:
+                                        terminals.set(rhs[j].index);
+                                        nullable = false;
+                                        break;
+
+                                    case Grammar::Symbol::Type::Nonterminal:
+                                        terminals.add(firstSets[rhs[j].index]);
+                                        nullable = nullableNonterminals.test(rhs[j].index);
+                                        break;
+
+                                    case Grammar::Symbol::Type::Epsilon:
+                                        break;
+                                }
+                            }
+                            if(nullable) {
+                                terminals.add(lookaheads[i]);
+                            }
+
+                            unsigned int rule = rhs[item.pos].index;
+                            for(unsigned int j=0; j<mGrammar.rules()[rule].rhs.size(); j++) {
+                                addLookahead(itemIndex(Item{rule, j, 0}), terminals);
+                            }
+                            break;
+                        }
+
+                        case Grammar::Symbol::Type::Epsilon:
+                            addLookahead(itemIndex(Item{item.rule, item.rhs, item.pos + 1}), lookaheads[i]);
+                            break;
+
+                        case Grammar::Symbol::Type::Terminal:
+                            break;
+                    }
+                }
+
+                std::map<unsigned int, std::pair<std::vector<Item>, std::vector<Util::BitSet>>> successors;
+                for(unsigned int i=0; i<items.size(); i++) {
+                    const Grammar::RHS &rhs = mGrammar.rules()[items[i].rule].rhs[items[i].rhs];
+                    if(items[i].pos < rhs.size() && rhs[items[i].pos].type != Grammar::Symbol::Type::Epsilon) {
+                        auto &successor = successors[symbolIndex(rhs[items[i].pos])];
+                        successor.first.push_back(Item{items[i].rule, items[i].rhs, items[i].pos + 1});
+                        successor.second.push_back(lookaheads[i]);
+                    }
+                }
+
+                for(auto &successor : successors) {
+                    auto it = states[index].transitions.find(successor.first);
+                    if(it != states[index].transitions.end()) {
+                        mergeLookaheads(it->second, successor.second.second);
+                        continue;
+                    }
+
+                    unsigned int target = UINT_MAX;
+                    auto candidates = statesByKernel.find(successor.second.first);
+                    if(candidates != statesByKernel.end()) {
+                        for(unsigned int candidate : candidates->second) {
+                            if(compatible(kernelLookaheads[candidate], successor.second.second)) {
+                                target = candidate;
+                                mergeLookaheads(target, successor.second.second);
+                                break;
+                            }
+                        }
+                    }
+
+                    if(target == UINT_MAX) {
+                        target = addState(std::move(successor.second.first), std::move(successor.second.second));
+                    }
+                    states[index].transitions[successor.first] = target;
+                }
+            }
+
+            std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> reduceLookaheads;
+            for(unsigned int i=0; i<states.size(); i++) {
+                for(unsigned int j=0; j<states[i].items.size(); j++) {
+                    const Item &item = states[i].items[j];
+                    if(item.pos == mGrammar.rules()[item.rule].rhs[item.rhs].size()) {
+                        std::set<unsigned int> &terminals = reduceLookaheads[std::make_pair(i, item.rule)];
+                        itemLookaheads[i][j].forEach([&](unsigned int terminal) { terminals.insert(terminal); });
+                    }
+                }
+            }
+
+            auto getReduceLookahead = [&](unsigned int state, unsigned int rule) {
+                return reduceLookaheads[std::make_pair(state, rule)];
+            };
+
+            if(computeParseTable(states, getReduceLookahead)) {
+                mValid = true;
+            }
+        }
+
+        LR1::LR1(const Grammar &grammar, Util::BinaryReader &reader)
+        : LRSingle(grammar, reader)
+        {
+        }
+
+        bool LR1::compatible(const std::vector<Util::BitSet> &lookaheads1, const std::vector<Util::BitSet> &lookaheads2)
+        {
+            for(unsigned int i=0; i<lookaheads1.size(); i++) {
+                for(unsigned int j=i + 1; j<lookaheads1.size(); j++) {
+                    if(!lookaheads1[i].intersects(lookaheads2[j]) && !lookaheads2[i].intersects(lookaheads1[j])) {
+                        continue;
+                    }
+
+                    if(!lookaheads1[i].intersects(lookaheads1[j]) && !lookaheads2[i].intersects(lookaheads2[j])) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PARSER_IMPL_LR1_HPP
+#define PARSER_IMPL_LR1_HPP
+
+#include "Parser/Impl/LRSingle.hpp"
+
+#include "Util/BitSet.hpp"
+
+#include <vector>
+
+namespace Parser
+{
+    namespace Impl
+    {
+        // LR(1) tables built with Pager's weak compatibility test: states with the same core are
+        // merged unless doing so could introduce a reduce/reduce conflict that canonical LR(1) would
+        // not have.  Accepts every LR(1) grammar with a state count close to LALR(1).
+        class LR1 : public LRSingle
+        {
+        public:
+            LR1(const Grammar &grammar);
+            LR1(const Grammar &grammar, Util::BinaryReader &reader);
+
+        private:
+            static bool compatible(const std::vector<Util::BitSet> &lookaheads1, const std::vector<Util::BitSet> &lookaheads2);
+        };
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,522 @@
+#ifndef PARSER_IMPL_LR_INCREMENTAL_HPP
+#define PARSER_IMPL_LR_INCREMENTAL_HPP
+
+#include "Parser/Impl/LRSingle.hpp"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Parser
+{
+    namespace Impl
+    {
+        // Parse session which owns a document and reparses it after each edit.  Only the lines touched by
+        // an edit are retokenized.  The subtrees built by the previous parse are then read in place of the
+        // tokens they cover: a subtree is reused whole when the parser reaches it in the state it was first
+        // built from and neither its tokens nor its lookahead were damaged, and is otherwise broken down
+        // along the path to the damage.  Reused subtrees keep their reducer results, so DataPointer must
+        // be copyable and reducers must not modify the data they are passed.  The tokenizer always runs
+        // in its first configuration.
+        //
+        // A repetition in the grammar is a chain of recursive rules, one node per element, so an edit
+        // inside a list still costs time in proportion to its distance from the end of the chain: every
+        // node of the chain above the edit covers it and is rebuilt, and the reducer of the rule holding
+        // the list runs over all of its elements.  The LR tables only produce these chains, and not the
+        // balanced trees which would make a reparse proportional to the edit alone.
+        template<typename ParseData, typename DataPointer> class LRSingle::IncrementalSession
+        {
+        public:
+            struct ParseItem {
+                enum class Type {
+                    Terminal,
+                    Nonterminal
+                };
+                Type type;
+                unsigned int index;
+                DataPointer data{};
+
+                typedef ParseItem* iterator;
+            };
+
+            typedef std::function<DataPointer(const Tokenizer::Token&)> TerminalDecorator;
+            typedef std::function<DataPointer(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
+
+            IncrementalSession(const LRSingle &parser, const Tokenizer &tokenizer);
+
+            void addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator);
+            void addReducer(const std::string &rule, Reducer reducer);
+
+            DataPointer parse(std::string document);
+            DataPointer edit(size_t start, size_t length, std::string_view text);
+
+            const std::string &document() const;
+
+        private:
+            static constexpr unsigned int kNone = UINT_MAX;
+
+            struct TokenInfo {
+                Tokenizer::TokenValue value;
+                unsigned int line;
+                unsigned int column;
+                unsigned int length;
+            };
+
+            // A symbol on the parse stack, and afterwards a subtree available for reuse.  Terminals and
+            // reduced rules with a reducer carry a parse item; any other rule stands for the items of its
+            // children, which are lastChild and the nodes below it through parent.
+            struct Node {
+                unsigned int state;
+                unsigned int leftState;
+                unsigned int symbol;
+                unsigned int length;
+                unsigned int parent;
+                unsigned int firstChild;
+                unsigned int lastChild;
+                unsigned int numChildren;
+                unsigned int item;
+            };
+
+            void tokenizeLines(unsigned int first, unsigned int last, std::vector<TokenInfo> &tokens) const;
+            Tokenizer::Token token(unsigned int index) const;
+            unsigned int undamagedChildren(unsigned int node, unsigned int start, unsigned int &last, unsigned int &end) const;
+            void gatherItems(unsigned int last, unsigned int count);
+            DataPointer run();
+            void compact();
+
+            const LRSingle &mParser;
+            const Tokenizer &mTokenizer;
+            std::vector<TerminalDecorator> mTerminalDecorators;
+            std::vector<Reducer> mReducers;
+
+            std::string mDocument;
+            std::vector<size_t> mLineStarts;
+            std::vector<TokenInfo> mTokens;
+            std::vector<unsigned int> mSubtrees;
+            unsigned int mDamageStart;
+            unsigned int mDamageEnd;
+
+            std::vector<Node> mNodes;
+            std::vector<ParseItem> mItems;
+            size_t mCompactSize;
+            std::vector<ParseItem> mReduceItems;
+            std::vector<unsigned int> mGatherStack;
+        };
+
+        template<typename ParseData, typename DataPointer> LRSingle::IncrementalSession<ParseData, DataPointer>::IncrementalSession(const LRSingle &parser, const Tokenizer &tokenizer)
+        : mParser(parser), mTokenizer(tokenizer), mTerminalDecorators(parser.grammar().terminals().size()), mReducers(parser.grammar().rules().size())
+        {
+            mDamageStart = mDamageEnd = 0;
+            mCompactSize = 0;
+        }
+
+        template<typename ParseData, typename DataPointer> void LRSingle::IncrementalSession<ParseData, DataPointer>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
+        {
+            unsigned int terminalIndex = mParser.grammar().terminalIndex(terminal);
+            if(terminalIndex != UINT_MAX) {
+                mTerminalDecorators[terminalIndex] = terminalDecorator;
+            }
+        }
+
+        template<typename ParseData, typename DataPointer> void LRSingle::IncrementalSession<ParseData, DataPointer>::addReducer(const std::string &rule, Reducer reducer)
+        {
+            unsigned int ruleIndex = mParser.grammar().ruleIndex(rule);
+            if(ruleIndex != UINT_MAX) {
+                mReducers[ruleIndex] = reducer;
+            }
+        }
+
+        template<typename ParseData, typename DataPointer> const std::string &LRSingle::IncrementalSession<ParseData, DataPointer>::document() const
+        {
+            return mDocument;
+        }
+
+        template<typename ParseData, typename DataPointer> DataPointer LRSingle::IncrementalSession<ParseData, DataPointer>::parse(std::string document)
+        {
+            mDocument = std::move(document);
+            mLineStarts.assign(1, 0);
+            for(size_t i=0; i<mDocument.size(); i++) {
+                if(mDocument[i] == '\n') {
+                    mLineStarts.push_back(i + 1);
+                }
+            }
+
+            mTokens.clear();
+            tokenizeLines(0, (unsigned int)mLineStarts.size() - 1, mTokens);
+            mSubtrees.assign(mTokens.size() + 1, kNone);
+            mDamageStart = mDamageEnd = 0;
+            mNodes.clear();
+            mItems.clear();
+            mCompactSize = 0;
+
+            return run();
+        }
+
+        template<typename ParseData, typename DataPointer> DataPointer LRSingle::IncrementalSession<ParseData, DataPointer>::edit(size_t start, size_t length, std::string_view text)
+        {
+            start = std::min(start, mDocument.size());
+            length = std::min(length, mDocument.size() - start);
+
+            unsigned int firstLine = (unsigned int)(std::upper_bound(mLineStarts.begin(), mLineStarts.end(), start) - mLineStarts.begin() - 1);
+            unsigned int lastLine = (unsigned int)(std::upper_bound(mLineStarts.begin(), mLineStarts.end(), start + length) - mLineStarts.begin() - 1);
+
+            auto lineLess = [](const TokenInfo &token, unsigned int line) { return token.line < line; };
+            unsigned int firstToken = (unsigned int)(std::lower_bound(mTokens.begin(), mTokens.end(), firstLine, lineLess) - mTokens.begin());
+            unsigned int lastToken = (unsigned int)(std::lower_bound(mTokens.begin(), mTokens.end(), lastLine + 1, lineLess) - mTokens.begin());
+
+            mDocument.replace(start, length, text);
+
+            // The damaged lines become the lines between the first line's start and the end of the
+            // inserted text; every later line moves by the same number of bytes.
+            std::vector<size_t> lineStarts(1, mLineStarts[firstLine]);
+            for(size_t i=mLineStarts[firstLine]; i<start + text.size(); i++) {
+                if(mDocument[i] == '\n') {
+                    lineStarts.push_back(i + 1);
+                }
+            }
+            for(size_t i=lastLine + 1; i<mLineStarts.size(); i++) {
+                mLineStarts[i] = mLineStarts[i] + text.size() - length;
+            }
+            mLineStarts.erase(mLineStarts.begin() + firstLine, mLineStarts.begin() + lastLine + 1);
+            mLineStarts.insert(mLineStarts.begin() + firstLine, lineStarts.begin(), lineStarts.end());
+
+            std::vector<TokenInfo> tokens;
+            tokenizeLines(firstLine, firstLine + (unsigned int)lineStarts.size() - 1, tokens);
+            unsigned int lineDelta = (unsigned int)lineStarts.size() - (lastLine + 1 - firstLine);
+            for(unsigned int i=lastToken; i<mTokens.size(); i++) {
+                mTokens[i].line += lineDelta;
+            }
+            mTokens.erase(mTokens.begin() + firstToken, mTokens.begin() + lastToken);
+            mTokens.insert(mTokens.begin() + firstToken, tokens.begin(), tokens.end());
+            mSubtrees.erase(mSubtrees.begin() + firstToken, mSubtrees.begin() + lastToken);
+            mSubtrees.insert(mSubtrees.begin() + firstToken, tokens.size(), kNone);
+
+            // The damage always covers the first token after the new ones, since whatever follows a
+            // deletion now has a different left context and every subtree spanning it changed length.
+            unsigned int damageStart = firstToken;
+            unsigned int damageEnd = firstToken + (unsigned int)tokens.size() + 1;
+            if(mDamageStart < mDamageEnd) {
+                auto map = [&](unsigned int token) {
+                    if(token < firstToken) {
+                        return token;
+                    } else if(token < lastToken) {
+                        return firstToken;
+                    } else {
+                        return token - lastToken + firstToken + (unsigned int)tokens.size();
+                    }
+                };
+                damageStart = std::min(damageStart, map(mDamageStart));
+                damageEnd = std::max(damageEnd, map(mDamageEnd));
+            }
+            mDamageStart = damageStart;
+            mDamageEnd = std::min(damageEnd, (unsigned int)mTokens.size() + 1);
+
+            return run();
+        }
+
+        template<typename ParseData, typename DataPointer> void LRSingle::IncrementalSession<ParseData, DataPointer>::tokenizeLines(unsigned int first, unsigned int last, std::vector<TokenInfo> &tokens) const
+        {
+            // Tokens never span lines, so each line is tokenized on its own.  A line's tokens end with
+            // the newline token, as they would in a stream over the whole document.
+            for(unsigned int line = first; line <= last; line++) {
+                size_t begin = mLineStarts[line];
+                size_t end = (line + 1 < mLineStarts.size()) ? mLineStarts[line + 1] - 1 : mDocument.size();
+                Tokenizer::Stream stream(mTokenizer, std::string_view(mDocument).substr(begin, end - begin));
+                while(true) {
+                    const Tokenizer::Token &token = stream.nextToken();
+                    if(token.value == mTokenizer.endValue()) {
+                        break;
+                    }
+
+                    tokens.push_back(TokenInfo{token.value, line, token.start, (unsigned int)token.text.size()});
+                    if(token.value == Tokenizer::kErrorTokenValue) {
+                        break;
+                    }
+                    stream.consumeToken();
+                }
+            }
+        }
+
+        template<typename ParseData, typename DataPointer> Tokenizer::Token LRSingle::IncrementalSession<ParseData, DataPointer>::token(unsigned int index) const
+        {
+            if(index == mTokens.size()) {
+                unsigned int line = (unsigned int)mLineStarts.size();
+                return Tokenizer::Token{mTokenizer.endValue(), (unsigned int)(mDocument.size() - mLineStarts.back()) + 1, line, "<end>"};
+            }
+
+            const TokenInfo &info = mTokens[index];
+            if(info.value == mTokenizer.newlineValue()) {
+                return Tokenizer::Token{info.value, info.column, info.line + 1, "<newline>"};
+            }
+
+            return Tokenizer::Token{info.value, info.column, info.line + 1, std::string_view(mDocument).substr(mLineStarts[info.line] + info.column, info.length)};
+        }
+
+        template<typename ParseData, typename DataPointer> unsigned int LRSingle::IncrementalSession<ParseData, DataPointer>::undamagedChildren(unsigned int node, unsigned int start, unsigned int &last, unsigned int &end) const
+        {
+            // Counts the children of the node starting at start which end before the damage, along with
+            // their lookahead.  last is set to the rightmost of them and end to the position after it.
+            unsigned int childEnd = start + mNodes[node].length;
+            unsigned int child = mNodes[node].lastChild;
+            for(unsigned int i=0; i<mNodes[node].numChildren; i++) {
+                if(childEnd < mDamageStart) {
+                    last = child;
+                    end = childEnd;
+                    return mNodes[node].numChildren - i;
+                }
+                childEnd -= mNodes[child].length;
+                child = mNodes[child].parent;
+            }
+
+            return 0;
+        }
+
+        template<typename ParseData, typename DataPointer> void LRSingle::IncrementalSession<ParseData, DataPointer>::gatherItems(unsigned int last, unsigned int count)
+        {
+            // Appends the items of the count stack nodes ending at last to mReduceItems, leftmost first.
+            // Nodes are pushed right to left so that the leftmost is expanded first.
+            mGatherStack.clear();
+            for(unsigned int i=0; i<count; i++) {
+                mGatherStack.push_back(last);
+                last = mNodes[last].parent;
+            }
+
+            while(!mGatherStack.empty()) {
+                const Node &node = mNodes[mGatherStack.back()];
+                mGatherStack.pop_back();
+                if(node.item != kNone) {
+                    mReduceItems.push_back(mItems[node.item]);
+                    continue;
+                }
+
+                unsigned int child = node.lastChild;
+                for(unsigned int i=0; i<node.numChildren; i++) {
+                    mGatherStack.push_back(child);
+                    child = mNodes[child].parent;
+                }
+            }
+        }
+
+        template<typename ParseData, typename DataPointer> DataPointer LRSingle::IncrementalSession<ParseData, DataPointer>::run()
+        {
+            unsigned int numTokens = (unsigned int)mTokens.size();
+            unsigned int numTerminals = (unsigned int)mParser.mGrammar.terminals().size();
+            auto undamaged = [&](unsigned int start, unsigned int length) {
+                return start + length < mDamageStart || start >= mDamageEnd;
+            };
+
+            mNodes.push_back(Node{0, kNone, kNone, 0, kNone, kNone, kNone, 0, kNone});
+            unsigned int top = (unsigned int)mNodes.size() - 1;
+            unsigned int depth = 0;
+            unsigned int position = 0;
+            bool accepted = false;
+
+            while(true) {
+                unsigned int state = mNodes[top].state;
+                if(mParser.mAcceptStates.count(state) > 0) {
+                    accepted = true;
+                    break;
+                }
+
+                Tokenizer::TokenValue terminal = (position < numTokens) ? mTokens[position].value : mTokenizer.endValue();
+                if(terminal == Tokenizer::kErrorTokenValue) {
+                    break;
+                }
+
+                const ParseTableEntry &entry = mParser.mParseTable.at(state, mParser.terminalIndex(terminal));
+                if(entry.type == ParseTableEntry::Type::Error) {
+                    break;
+                }
+
+                if(entry.type == ParseTableEntry::Type::Shift) {
+                    // Look for the largest previous subtree at this position which can stand in for the
+                    // parse of its tokens.  A terminal only depends on its token.  A damaged subtree reached
+                    // in its own left state is broken down along the path to the damage instead: its
+                    // children before the damage go onto the stack as they are, linked in through the
+                    // leftmost one, and the search starts again at the child holding the damage.  Only
+                    // subtrees without an item are sure to have kept their children through compact().
+                    unsigned int reused = kNone;
+                    unsigned int numChildren = 0;
+                    unsigned int lastChild = kNone;
+                    unsigned int childrenEnd = position;
+                    for(unsigned int candidate = mSubtrees[position]; candidate != kNone; candidate = mNodes[candidate].firstChild) {
+                        Node node = mNodes[candidate];
+                        if(node.length == 0) {
+                            continue;
+                        }
+
+                        if(!undamaged(position, node.length)) {
+                            if(node.symbol >= numTerminals && node.item == kNone && node.leftState == state) {
+                                numChildren = undamagedChildren(candidate, position, lastChild, childrenEnd);
+                                if(numChildren > 0) {
+                                    mNodes[node.firstChild].parent = top;
+                                    break;
+                                }
+                            }
+                            continue;
+                        }
+
+                        if(node.symbol < numTerminals) {
+                            node.state = entry.index;
+                        } else if(node.leftState == state) {
+                            node.state = mParser.mParseTable.at(state, node.symbol).index;
+                        } else {
+                            continue;
+                        }
+
+                        node.leftState = state;
+                        node.parent = top;
+                        mNodes.push_back(node);
+                        reused = (unsigned int)mNodes.size() - 1;
+                        break;
+                    }
+
+                    if(reused != kNone) {
+                        mSubtrees[position] = reused;
+                        position += mNodes[reused].length;
+                        top = reused;
+                        depth++;
+                        continue;
+                    }
+
+                    if(numChildren > 0) {
+                        position = childrenEnd;
+                        top = lastChild;
+                        depth += numChildren;
+                        continue;
+                    }
+
+                    DataPointer data{};
+                    if(terminal < mTerminalDecorators.size() && mTerminalDecorators[terminal]) {
+                        data = mTerminalDecorators[terminal](token(position));
+                    }
+                    mItems.push_back(ParseItem{ParseItem::Type::Terminal, terminal, std::move(data)});
+                    mNodes.push_back(Node{entry.index, state, mParser.terminalIndex(terminal), 1, top, kNone, kNone, 0, (unsigned int)mItems.size() - 1});
+                    top = (unsigned int)mNodes.size() - 1;
+                    depth++;
+                    mSubtrees[position] = top;
+                    position++;
+                    continue;
+                }
+
+                const Reduction &reduction = mParser.mReductions[entry.index];
+                Node node{0, 0, mParser.ruleIndex(reduction.rule), 0, kNone, kNone, kNone, 0, kNone};
+                unsigned int below = top;
+                for(const auto &symbol : mParser.mGrammar.rules()[reduction.rule].rhs[reduction.rhs]) {
+                    if(symbol.type != Grammar::Symbol::Type::Epsilon) {
+                        node.length += mNodes[below].length;
+                        node.numChildren++;
+                        node.firstChild = below;
+                        below = mNodes[below].parent;
+                    }
+                }
+
+                node.leftState = mNodes[below].state;
+                node.state = mParser.mParseTable.at(node.leftState, node.symbol).index;
+                node.parent = below;
+                node.lastChild = (node.numChildren > 0) ? top : kNone;
+
+                const Reducer &reducer = mReducers[reduction.rule];
+                if(reducer) {
+                    mReduceItems.clear();
+                    gatherItems(top, node.numChildren);
+                    DataPointer data = reducer(mReduceItems.data(), mReduceItems.data() + mReduceItems.size());
+                    mItems.push_back(ParseItem{ParseItem::Type::Nonterminal, reduction.rule, std::move(data)});
+                    node.item = (unsigned int)mItems.size() - 1;
+                }
+
+                mNodes.push_back(node);
+                top = (unsigned int)mNodes.size() - 1;
+                depth = depth - node.numChildren + 1;
+                if(node.length > 0) {
+                    mSubtrees[position - node.length] = top;
+                }
+            }
+
+            // A failed parse did not revisit the subtrees past the error, so the damage stays in force
+            // until a parse gets through it.
+            DataPointer result{};
+            if(accepted) {
+                mDamageStart = mDamageEnd = 0;
+
+                const Reducer &reducer = mReducers[mParser.mGrammar.startRule()];
+                if(reducer) {
+                    mReduceItems.clear();
+                    gatherItems(top, depth);
+                    result = reducer(mReduceItems.data(), mReduceItems.data() + mReduceItems.size());
+                }
+            }
+            mReduceItems.clear();
+
+            if(mNodes.size() > 2 * mCompactSize + 1024) {
+                compact();
+            }
+
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer> void LRSingle::IncrementalSession<ParseData, DataPointer>::compact()
+        {
+            // Only subtrees reachable from mSubtrees, directly or as leftmost children, can be reused, and
+            // those without an item of their own need their children to gather items from.  The stack
+            // links are dead once a parse finishes, except where they chain siblings together.
+            std::vector<unsigned int> nodeMap(mNodes.size(), kNone);
+            std::vector<unsigned int> work;
+            for(unsigned int root : mSubtrees) {
+                for(unsigned int node = root; node != kNone && nodeMap[node] == kNone; node = mNodes[node].firstChild) {
+                    nodeMap[node] = 0;
+                    work.push_back(node);
+                }
+            }
+
+            std::vector<unsigned int> liveNodes;
+            while(!work.empty()) {
+                unsigned int node = work.back();
+                work.pop_back();
+                liveNodes.push_back(node);
+                if(mNodes[node].item != kNone) {
+                    continue;
+                }
+
+                unsigned int child = mNodes[node].lastChild;
+                for(unsigned int i=0; i<mNodes[node].numChildren; i++) {
+                    if(nodeMap[child] == kNone) {
+                        nodeMap[child] = 0;
+                        work.push_back(child);
+                    }
+                    child = mNodes[child].parent;
+                }
+            }
+            std::sort(liveNodes.begin(), liveNodes.end());
+
+            std::vector<unsigned int> itemMap(mItems.size(), kNone);
+            std::vector<ParseItem> items;
+            std::vector<Node> nodes;
+            for(unsigned int node : liveNodes) {
+                nodeMap[node] = (unsigned int)nodes.size();
+                nodes.push_back(mNodes[node]);
+
+                unsigned int item = mNodes[node].item;
+                if(item != kNone && itemMap[item] == kNone) {
+                    itemMap[item] = (unsigned int)items.size();
+                    items.push_back(std::move(mItems[item]));
+                }
+            }
+            for(auto &node : nodes) {
+                node.parent = (node.parent == kNone) ? kNone : nodeMap[node.parent];
+                node.firstChild = (node.firstChild == kNone) ? kNone : nodeMap[node.firstChild];
+                node.lastChild = (node.lastChild == kNone) ? kNone : nodeMap[node.lastChild];
+                node.item = (node.item == kNone) ? kNone : itemMap[node.item];
+            }
+            for(auto &subtree : mSubtrees) {
+                subtree = (subtree == kNone) ? kNone : nodeMap[subtree];
+            }
+
+            mNodes = std::move(nodes);
+            mItems = std::move(items);
+            mCompactSize = mNodes.size();
+        }
+    }
+}
+#endif
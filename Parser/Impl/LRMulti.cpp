@@ -9,6 +9,92 @@ namespace Parser
         {
         }
 
+        LRMulti::LRMulti(const Grammar &grammar, Util::BinaryReader &reader)
+        : LR(grammar)
+        {
+            reader.expect(Util::binaryTag("LRM "));
+            mParseTable.load(reader);
+            uint32_t numMultiEntries = 0;
+            reader.read(numMultiEntries);
+            for(uint32_t i=0; i<numMultiEntries && reader.valid(); i++) {
+                std::vector<ParseTableEntry> entries;
+                reader.read(entries);
+                mMultiEntries.push_back(std::move(entries));
+            }
+            reader.read(mReductions);
+            std::vector<unsigned int> acceptStates;
+            reader.read(acceptStates);
+            mAcceptStates.insert(acceptStates.begin(), acceptStates.end());
+            if(reader.valid() && !validateTables()) {
+                reader.invalidate();
+            }
+        }
+
+        bool LRMulti::validateEntry(const ParseTableEntry &entry, bool allowMulti) const
+        {
+            switch(entry.type) {
+                case ParseTableEntry::Type::Shift:
+                    return entry.index < mParseTable.width();
+                case ParseTableEntry::Type::Reduce:
+                    return entry.index < mReductions.size();
+                case ParseTableEntry::Type::Multi:
+                    return allowMulti && entry.index < mMultiEntries.size();
+                case ParseTableEntry::Type::Error:
+                    return allowMulti;
+                default:
+                    return false;
+            }
+        }
+
+        bool LRMulti::validateTables() const
+        {
+            if(mParseTable.height() != mGrammar.terminals().size() + mGrammar.rules().size()) {
+                return false;
+            }
+
+            for(const Reduction &reduction : mReductions) {
+                if(reduction.rule >= mGrammar.rules().size() || reduction.rhs >= mGrammar.rules()[reduction.rule].rhs.size()) {
+                    return false;
+                }
+            }
+
+            for(unsigned int i=0; i<mParseTable.width(); i++) {
+                for(unsigned int j=0; j<mParseTable.height(); j++) {
+                    if(!validateEntry(mParseTable.at(i, j), true)) {
+                        return false;
+                    }
+                }
+            }
+
+            for(const auto &entries : mMultiEntries) {
+                for(const ParseTableEntry &entry : entries) {
+                    if(!validateEntry(entry, false)) {
+                        return false;
+                    }
+                }
+            }
+
+            for(unsigned int state : mAcceptStates) {
+                if(state >= mParseTable.width()) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void LRMulti::save(Util::BinaryWriter &writer) const
+        {
+            writer.write(Util::binaryTag("LRM "));
+            mParseTable.save(writer);
+            writer.write((uint32_t)mMultiEntries.size());
+            for(const auto &entries : mMultiEntries) {
+                writer.write(entries);
+            }
+            writer.write(mReductions);
+            writer.write(std::vector<unsigned int>(mAcceptStates.begin(), mAcceptStates.end()));
+        }
+
         void LRMulti::addParseTableEntry(unsigned int state, unsigned int symbol, const ParseTableEntry &entry)
         {
             switch(mParseTable.at(state, symbol).type) {
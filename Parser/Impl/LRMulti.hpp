@@ -12,7 +12,11 @@ namespace Parser
         public:
             LRMulti(const Grammar &grammar);
 
+            void save(Util::BinaryWriter &writer) const;
+
         protected:
+            LRMulti(const Grammar &grammar, Util::BinaryReader &reader);
+
             struct ParseTableEntry {
                 enum class Type {
                     Shift,
@@ -35,6 +39,8 @@ namespace Parser
 
             void addParseTableEntry(unsigned int state, unsigned int symbol, const ParseTableEntry &entry);
             void computeParseTable(const std::vector<State> &states, GetReduceLookahead getReduceLookahead);
+            bool validateEntry(const ParseTableEntry &entry, bool allowMulti) const;
+            bool validateTables() const;
 
             Util::Table<ParseTableEntry> mParseTable;
             std::vector<std::vector<ParseTableEntry>> mMultiEntries;
@@ -10,6 +10,79 @@ namespace Parser
             mValid = false;
         }
 
+        LRSingle::LRSingle(const Grammar &grammar, Util::BinaryReader &reader)
+        : LR(grammar)
+        {
+            reader.expect(Util::binaryTag("LRS "));
+            mParseTable.load(reader);
+            reader.read(mReductions);
+            std::vector<unsigned int> acceptStates;
+            reader.read(acceptStates);
+            mAcceptStates.insert(acceptStates.begin(), acceptStates.end());
+            reader.read(mValid);
+            reader.read(mConflict);
+            if(reader.valid() && !validateTables()) {
+                reader.invalidate();
+            }
+            if(!reader.valid()) {
+                mValid = false;
+            }
+        }
+
+        bool LRSingle::validateTables() const
+        {
+            unsigned int numStates = (unsigned int)mParseTable.width();
+            if(mParseTable.height() != mGrammar.terminals().size() + mGrammar.rules().size()) {
+                return false;
+            }
+
+            for(const Reduction &reduction : mReductions) {
+                if(reduction.rule >= mGrammar.rules().size() || reduction.rhs >= mGrammar.rules()[reduction.rule].rhs.size()) {
+                    return false;
+                }
+            }
+
+            for(unsigned int i=0; i<numStates; i++) {
+                for(unsigned int j=0; j<mParseTable.height(); j++) {
+                    const ParseTableEntry &entry = mParseTable.at(i, j);
+                    switch(entry.type) {
+                        case ParseTableEntry::Type::Shift:
+                            if(entry.index >= numStates) {
+                                return false;
+                            }
+                            break;
+                        case ParseTableEntry::Type::Reduce:
+                            if(entry.index >= mReductions.size()) {
+                                return false;
+                            }
+                            break;
+                        case ParseTableEntry::Type::Error:
+                            break;
+                        default:
+                            return false;
+                    }
+                }
+            }
+
+            for(unsigned int state : mAcceptStates) {
+                if(state >= numStates) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void LRSingle::save(Util::BinaryWriter &writer) const
+        {
+            writer.write(Util::binaryTag("LRS "));
+            mParseTable.save(writer);
+            writer.write(mReductions);
+            writer.write(std::vector<unsigned int>(mAcceptStates.begin(), mAcceptStates.end()));
+            writer.write(mValid);
+            writer.write(mConflict);
+        }
+
         bool LRSingle::valid() const
         {
             return mValid;
@@ -20,6 +93,36 @@ namespace Parser
             return mConflict;
         }
 
+        unsigned int LRSingle::numStates() const
+        {
+            return (unsigned int)mParseTable.width();
+        }
+
+        const LRSingle::ParseTableEntry &LRSingle::action(unsigned int state, unsigned int terminal) const
+        {
+            return mParseTable.at(state, terminalIndex(terminal));
+        }
+
+        const LRSingle::ParseTableEntry &LRSingle::transition(unsigned int state, unsigned int rule) const
+        {
+            return mParseTable.at(state, ruleIndex(rule));
+        }
+
+        unsigned int LRSingle::numReductions() const
+        {
+            return (unsigned int)mReductions.size();
+        }
+
+        const LRSingle::Reduction &LRSingle::reduction(unsigned int index) const
+        {
+            return mReductions[index];
+        }
+
+        bool LRSingle::acceptState(unsigned int state) const
+        {
+            return mAcceptStates.count(state) > 0;
+        }
+
         bool LRSingle::computeParseTable(const std::vector<State> &states, GetReduceLookahead getReduceLookahead)
         {
             mParseTable.resize(states.size(), mGrammar.terminals().size() + mGrammar.rules().size(), ParseTableEntry{ParseTableEntry::Type::Error, 0});
@@ -2,6 +2,12 @@
 #define PARSER_IMPL_LR_SINGLE_HPP
 
 #include "Parser/Impl/LR.hpp"
+#include "Parser/Impl/Session.hpp"
+
+#include "Parser/Diagnostic.hpp"
+#include "Parser/Profiler.hpp"
+
+#include "Util/Arena.hpp"
 
 namespace Parser
 {
@@ -12,6 +18,8 @@ namespace Parser
         public:
             LRSingle(const Grammar &grammar);
 
+            void save(Util::BinaryWriter &writer) const;
+
             struct Conflict {
                 enum class Type {
                     ShiftReduce,
@@ -26,7 +34,33 @@ namespace Parser
             bool valid() const;
             const Conflict &conflict() const;
 
-            template<typename ParseData> class ParseSession
+            struct ParseTableEntry {
+                enum class Type {
+                    Shift,
+                    Reduce,
+                    Error
+                };
+                Type type;
+                unsigned int index;
+            };
+
+            struct Reduction {
+                bool operator==(const Reduction &other) {
+                    return rule == other.rule && rhs == other.rhs;
+                }
+
+                unsigned int rule;
+                unsigned int rhs;
+            };
+
+            unsigned int numStates() const;
+            const ParseTableEntry &action(unsigned int state, unsigned int terminal) const;
+            const ParseTableEntry &transition(unsigned int state, unsigned int rule) const;
+            unsigned int numReductions() const;
+            const Reduction &reduction(unsigned int index) const;
+            bool acceptState(unsigned int state) const;
+
+            template<typename ParseData, typename DataPointer = std::unique_ptr<ParseData>, typename ProfilerType = NullProfiler> class ParseSession
             {
             public:
                 struct ParseItem {
@@ -36,49 +70,101 @@ namespace Parser
                     };
                     Type type;
                     unsigned int index;
-                    std::unique_ptr<ParseData> data;
+                    DataPointer data{};
 
                     typedef ParseItem* iterator;
                 };
 
-                typedef std::function<std::unique_ptr<ParseData>(const Tokenizer::Token&)> TerminalDecorator;
-                typedef std::function<std::unique_ptr<ParseData>(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
+                typedef std::function<DataPointer(const Tokenizer::Token&)> TerminalDecorator;
+                typedef std::function<DataPointer(typename ParseItem::iterator, typename ParseItem::iterator)> Reducer;
                 
                 ParseSession(const LRSingle &parser);
             
                 void addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator);
                 void addReducer(const std::string &rule, Reducer reducer);
+                Util::Arena &arena();
+
+                // Capacity above which a stack is released after a parse instead of kept; see releaseStack().
+                void setRetainedCapacity(size_t capacity);
+
+                // With recovery enabled a syntax error is recorded in diagnostics() and the parse carries
+                // on, and a result is returned if the parse still reaches the end of the input.  If the
+                // grammar uses the error terminal, states are popped until one has an action on error,
+                // which is then shifted as if it were the next token and passed to reducers with no data;
+                // otherwise states are popped until one has an action on the next token, discarding
+                // tokens until one does.  Only the first error is reported until three tokens have been
+                // shifted after it.
+                void setRecovery(bool recovery);
+                const std::vector<Diagnostic> &diagnostics() const;
+
+                ProfilerType &profiler();
+
+                DataPointer parse(Tokenizer::Stream &stream);
+
+                // Parses with actions resolved at compile time rather than through the registered
+                // std::functions.  Actions provides hasReducer(rule), reduce(rule, begin, end) and
+                // decorate(terminal, token) with the same signatures as below, rule and terminal being
+                // grammar indices; the session itself is the Actions used by parse(stream).
+                template<typename Actions> DataPointer parse(Tokenizer::Stream &stream, Actions &actions);
 
-                std::unique_ptr<ParseData> parse(Tokenizer::Stream &stream);
+                bool hasReducer(unsigned int rule) const;
+                DataPointer reduce(unsigned int rule, typename ParseItem::iterator begin, typename ParseItem::iterator end);
+                DataPointer decorate(unsigned int terminal, const Tokenizer::Token &token);
+
+                // Push-mode parsing; see PushParse in Parser/Impl/Session.hpp.
+                void start(const Tokenizer &tokenizer);
+                bool feed(std::string_view bytes);
+                DataPointer finish();
 
             private:
+                struct StateItem {
+                    unsigned int state;
+                    unsigned int parseStackStart;
+                };
+
+                struct ParseState {
+                    std::vector<StateItem> stateStack;
+                    std::vector<ParseItem> parseStack;
+                    unsigned int state;
+                    unsigned int recovering;
+                    bool errorPending;
+                };
+
+                typedef ParseStatus Status;
+
+                template<typename Actions> Status run(Tokenizer::Stream &stream, ParseState &parseState, Actions &actions);
+                template<typename Actions> DataPointer reduceStart(ParseState &parseState, Actions &actions);
+                void startState(ParseState &parseState);
+                void releaseState(ParseState &parseState);
+                bool recover(Tokenizer::Stream &stream, ParseState &parseState);
+                void popTo(ParseState &parseState, size_t depth);
+
                 const LRSingle &mParser;
-                std::map<unsigned int, TerminalDecorator> mTerminalDecorators;
-                std::map<unsigned int, Reducer> mReducers;
-            };
+                std::vector<TerminalDecorator> mTerminalDecorators;
+                std::vector<Reducer> mReducers;
+                Util::Arena mArena;
 
-        protected:
-            bool computeParseTable(const std::vector<State> &states, GetReduceLookahead getReduceLookahead);
+                ParseState mParseState;
+                size_t mRetainedCapacity;
 
-            struct ParseTableEntry {
-                enum class Type {
-                    Shift,
-                    Reduce,
-                    Error
-                };
-                Type type;
-                unsigned int index;
-            };
+                bool mRecovery;
+                unsigned int mErrorTerminal;
+                std::vector<Diagnostic> mDiagnostics;
 
-            struct Reduction {
-                bool operator==(const Reduction &other) {
-                    return rule == other.rule && rhs == other.rhs;
-                }
+                ProfilerType mProfiler;
 
-                unsigned int rule;
-                unsigned int rhs;
+                PushParse<ParseState> mPush;
             };
 
+            // Session which reparses a document incrementally after edits; see Parser/Impl/LRIncremental.hpp.
+            template<typename ParseData, typename DataPointer = std::shared_ptr<ParseData>> class IncrementalSession;
+
+        protected:
+            LRSingle(const Grammar &grammar, Util::BinaryReader &reader);
+
+            bool computeParseTable(const std::vector<State> &states, GetReduceLookahead getReduceLookahead);
+            bool validateTables() const;
+
             Util::Table<ParseTableEntry> mParseTable;
             std::vector<Reduction> mReductions;
             std::set<unsigned int> mAcceptStates;
@@ -87,12 +173,13 @@ namespace Parser
             Conflict mConflict;
         };
 
-        template<typename ParseData> LRSingle::ParseSession<ParseData>::ParseSession(const LRSingle &parser)
-        : mParser(parser)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::ParseSession(const LRSingle &parser)
+        : mParser(parser), mTerminalDecorators(parser.grammar().terminals().size()), mReducers(parser.grammar().rules().size()), mRetainedCapacity(4096), mRecovery(false)
         {
+            mErrorTerminal = parser.grammar().terminalIndex("error");
         }
 
-        template<typename ParseData> void LRSingle::ParseSession<ParseData>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::addTerminalDecorator(const std::string &terminal, TerminalDecorator terminalDecorator)
         {
             unsigned int terminalIndex = mParser.grammar().terminalIndex(terminal);
             if(terminalIndex != UINT_MAX) {
@@ -100,7 +187,7 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> void LRSingle::ParseSession<ParseData>::addReducer(const std::string &rule, Reducer reducer)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::addReducer(const std::string &rule, Reducer reducer)
         {
             unsigned int ruleIndex = mParser.grammar().ruleIndex(rule);
             if(ruleIndex != UINT_MAX) {
@@ -108,34 +195,153 @@ namespace Parser
             }
         }
 
-        template<typename ParseData> std::unique_ptr<ParseData> LRSingle::ParseSession<ParseData>::parse(Tokenizer::Stream &stream)
+        template<typename ParseData, typename DataPointer, typename ProfilerType> Util::Arena &LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::arena()
         {
-            struct StateItem {
-                unsigned int state;
-                unsigned int parseStackStart;
-            };
+            return mArena;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::setRetainedCapacity(size_t capacity)
+        {
+            mRetainedCapacity = capacity;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::setRecovery(bool recovery)
+        {
+            mRecovery = recovery;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> const std::vector<Diagnostic> &LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::diagnostics() const
+        {
+            return mDiagnostics;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> ProfilerType &LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::profiler()
+        {
+            return mProfiler;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::parse(Tokenizer::Stream &stream)
+        {
+            return parse(stream, *this);
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> bool LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::hasReducer(unsigned int rule) const
+        {
+            return (bool)mReducers[rule];
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::reduce(unsigned int rule, typename ParseItem::iterator begin, typename ParseItem::iterator end)
+        {
+            return mReducers[rule](begin, end);
+        }
 
-            std::vector<StateItem> stateStack;
-            std::vector<ParseItem> parseStack;
-            unsigned int state = 0;
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::decorate(unsigned int terminal, const Tokenizer::Token &token)
+        {
+            const TerminalDecorator &terminalDecorator = mTerminalDecorators[terminal];
+            if(terminalDecorator) {
+                return terminalDecorator(token);
+            }
+
+            return DataPointer();
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> template<typename Actions> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::parse(Tokenizer::Stream &stream, Actions &actions)
+        {
+            startState(mParseState);
+            mDiagnostics.clear();
+
+            DataPointer result = mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                DataPointer result{};
+                if(run(stream, mParseState, actions) == Status::Accepted) {
+                    result = reduceStart(mParseState, actions);
+                }
+                return result;
+            });
+
+            releaseState(mParseState);
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::start(const Tokenizer &tokenizer)
+        {
+            startState(mPush.start(tokenizer));
+            mDiagnostics.clear();
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> bool LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::feed(std::string_view bytes)
+        {
+            return mPush.feed(bytes, [&](Tokenizer::Stream &stream, ParseState &parseState) {
+                return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                    return run(stream, parseState, *this);
+                });
+            });
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::finish()
+        {
+            DataPointer result = mPush.finish([&](Tokenizer::Stream &stream, ParseState &parseState) {
+                return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                    return run(stream, parseState, *this);
+                });
+            }, [&](ParseState &parseState) {
+                return mProfiler.time(ProfileCounters::Phase::Parse, [&]() {
+                    return reduceStart(parseState, *this);
+                });
+            });
+
+            releaseState(mPush.state());
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> template<typename Actions> typename LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::Status LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::run(Tokenizer::Stream &stream, ParseState &parseState, Actions &actions)
+        {
+            std::vector<StateItem> &stateStack = parseState.stateStack;
+            std::vector<ParseItem> &parseStack = parseState.parseStack;
+            unsigned int &state = parseState.state;
+
+            readToken(stream, mProfiler);
 
             while(mParser.mAcceptStates.count(state) == 0) {
+                if(!parseState.errorPending && stream.nextToken().value == Tokenizer::kPendingTokenValue) {
+                    return Status::Pending;
+                } else if(!parseState.errorPending && stream.nextToken().value == Tokenizer::kErrorTokenValue) {
+                    if(!mRecovery || !recover(stream, parseState)) {
+                        return Status::Error;
+                    }
+                    continue;
+                }
+
+                // While recovering, the error terminal stands in for the next token until it is shifted.
+                Tokenizer::TokenValue lookahead = parseState.errorPending ? mErrorTerminal : stream.nextToken().value;
+
                 stateStack.push_back(StateItem{state, (unsigned int)parseStack.size()});
-                const ParseTableEntry &entry = mParser.mParseTable.at(state, mParser.terminalIndex(stream.nextToken().value));
+                const ParseTableEntry &entry = mParser.mParseTable.at(state, mParser.terminalIndex(lookahead));
                 switch(entry.type) {
                     case ParseTableEntry::Type::Shift:
                     {
                         ParseItem parseItem;
                         parseItem.type = ParseItem::Type::Terminal;
-                        parseItem.index = stream.nextToken().value;
-                        auto it = mTerminalDecorators.find(stream.nextToken().value);
-                        if(it != mTerminalDecorators.end()) {
-                            parseItem.data = it->second(stream.nextToken());
+                        parseItem.index = lookahead;
+                        if(!parseState.errorPending) {
+                            parseItem.data = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                                return actions.decorate(lookahead, stream.nextToken());
+                            });
                         }
                         parseStack.push_back(std::move(parseItem));
-
-                        stream.consumeToken();
                         state = entry.index;
+
+                        if(parseState.errorPending) {
+                            parseState.errorPending = false;
+                        } else {
+                            mProfiler.countShift();
+                            mProfiler.countToken();
+                            mProfiler.time(ProfileCounters::Phase::Tokenizer, [&]() {
+                                stream.consumeToken();
+                            });
+                            if(parseState.recovering > 0) {
+                                parseState.recovering--;
+                            }
+                        }
                         break;
                     }
 
@@ -152,16 +358,12 @@ namespace Parser
                         state = stateStack.back().state;
                         unsigned int parseStackStart = stateStack.back().parseStackStart;
 
-                        auto it = mReducers.find(reduction.rule);
-                        if(it != mReducers.end()) {
-                            std::unique_ptr<ParseData> data = it->second(&parseStack[parseStackStart], &parseStack[0] + parseStack.size());
-                            parseStack.erase(parseStack.begin() + parseStackStart, parseStack.end());
-
-                            ParseItem parseItem;
-                            parseItem.type = ParseItem::Type::Nonterminal;
-                            parseItem.index = reduction.rule;
-                            parseItem.data = std::move(data);
-                            parseStack.push_back(std::move(parseItem));
+                        mProfiler.countReduction(reduction.rule);
+                        if(actions.hasReducer(reduction.rule)) {
+                            DataPointer data = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                                return actions.reduce(reduction.rule, &parseStack[parseStackStart], &parseStack[0] + parseStack.size());
+                            });
+                            replaceReduced(parseStack, parseStackStart, reduction.rule, std::move(data));
                         }
                         
                         const ParseTableEntry &newEntry = mParser.mParseTable.at(state, mParser.ruleIndex(reduction.rule));
@@ -170,17 +372,114 @@ namespace Parser
                     }
 
                     case ParseTableEntry::Type::Error:
-                        return std::unique_ptr<ParseData>();
+                        stateStack.pop_back();
+                        if(!mRecovery || !recover(stream, parseState)) {
+                            return Status::Error;
+                        }
+                        break;
                 }
             }
 
-            std::unique_ptr<ParseData> result;
-            auto it = mReducers.find(mParser.mGrammar.startRule());
-            if(it != mReducers.end()) {
-                result = it->second(&parseStack[0], (unsigned int)parseStack.size());
+            return Status::Accepted;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> template<typename Actions> DataPointer LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::reduceStart(ParseState &parseState, Actions &actions)
+        {
+            std::vector<ParseItem> &parseStack = parseState.parseStack;
+
+            DataPointer result{};
+            unsigned int startRule = mParser.mGrammar.startRule();
+            mProfiler.countReduction(startRule);
+            if(actions.hasReducer(startRule)) {
+                result = mProfiler.time(ProfileCounters::Phase::Reducers, [&]() {
+                    return actions.reduce(startRule, &parseStack[0], &parseStack[0] + parseStack.size());
+                });
+            }
+
+            return result;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::startState(ParseState &parseState)
+        {
+            parseState.stateStack.clear();
+            parseState.parseStack.clear();
+            parseState.state = 0;
+            parseState.recovering = 0;
+            parseState.errorPending = false;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::releaseState(ParseState &parseState)
+        {
+            releaseStack(parseState.stateStack, mRetainedCapacity);
+            releaseStack(parseState.parseStack, mRetainedCapacity);
+            startState(parseState);
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> bool LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::recover(Tokenizer::Stream &stream, ParseState &parseState)
+        {
+            switch(startRecovery(stream, parseState, mDiagnostics)) {
+                case RecoveryStart::Abandon:
+                    return false;
+
+                case RecoveryStart::Skipped:
+                    return true;
+
+                case RecoveryStart::Resynchronize:
+                    break;
+            }
+
+            const Tokenizer::Token &token = stream.nextToken();
+            bool end = (token.value == stream.tokenizer().endValue());
+
+            // With error productions, states are popped until one has an action on error, and error
+            // then becomes the lookahead so that any reductions on it happen before it is shifted.
+            std::vector<StateItem> &stateStack = parseState.stateStack;
+            if(mErrorTerminal != UINT_MAX) {
+                unsigned int errorIndex = mParser.terminalIndex(mErrorTerminal);
+                for(size_t depth = stateStack.size() + 1; depth > 0; depth--) {
+                    unsigned int state = (depth > stateStack.size()) ? parseState.state : stateStack[depth - 1].state;
+                    if(mParser.mParseTable.at(state, errorIndex).type != ParseTableEntry::Type::Error) {
+                        popTo(parseState, depth - 1);
+                        parseState.errorPending = true;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            if(token.value != Tokenizer::kErrorTokenValue) {
+                unsigned int terminalIndex = mParser.terminalIndex(token.value);
+                for(size_t depth = stateStack.size() + 1; depth > 0; depth--) {
+                    unsigned int state = (depth > stateStack.size()) ? parseState.state : stateStack[depth - 1].state;
+                    if(mParser.mParseTable.at(state, terminalIndex).type != ParseTableEntry::Type::Error) {
+                        popTo(parseState, depth - 1);
+                        return true;
+                    }
+                }
+            }
+
+            // No state can use this token, so drop it and try again with the next one.
+            if(end) {
+                return false;
+            }
+            stream.consumeToken();
+            parseState.recovering = 2;
+            return true;
+        }
+
+        template<typename ParseData, typename DataPointer, typename ProfilerType> void LRSingle::ParseSession<ParseData, DataPointer, ProfilerType>::popTo(ParseState &parseState, size_t depth)
+        {
+            // Makes the state depth entries up the state stack current again, discarding everything
+            // parsed since.
+            if(depth == parseState.stateStack.size()) {
+                return;
             }
 
-            return std::move(result);
+            const StateItem &stateItem = parseState.stateStack[depth];
+            parseState.state = stateItem.state;
+            parseState.parseStack.erase(parseState.parseStack.begin() + stateItem.parseStackStart, parseState.parseStack.end());
+            parseState.stateStack.resize(depth);
         }
     }
 }
@@ -22,5 +22,10 @@ namespace Parser
                 mValid = true;
             }
         }
+
+        SLR::SLR(const Grammar &grammar, Util::BinaryReader &reader)
+        : LRSingle(grammar, reader)
+        {
+        }
     }
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ namespace Parser
         {
         public:
             SLR(const Grammar &grammar);
+            SLR(const Grammar &grammar, Util::BinaryReader &reader);
 
         private:
         };
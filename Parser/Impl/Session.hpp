@@ -0,0 +1,167 @@
+#ifndef PARSER_IMPL_SESSION_HPP
+#define PARSER_IMPL_SESSION_HPP
+
+#include "Parser/Diagnostic.hpp"
+#include "Parser/Profiler.hpp"
+#include "Parser/Tokenizer.hpp"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Parser
+{
+    namespace Impl
+    {
+        // Pieces shared by the stack-based LL and LRSingle parse sessions.
+
+        enum class ParseStatus {
+            Pending,
+            Accepted,
+            Error
+        };
+
+        // Stacks are kept between parses so that repeated parses of small inputs do not allocate.
+        // Clearing keeps the capacity for the next parse; a stack which grew beyond retainedCapacity
+        // entries is given back instead.
+        template<typename T> void releaseStack(std::vector<T> &stack, size_t retainedCapacity)
+        {
+            if(stack.capacity() > retainedCapacity) {
+                std::vector<T>().swap(stack);
+            }
+            stack.clear();
+        }
+
+        // Replaces the items of a reduced rule, from start to the top of the parse stack, with a single
+        // nonterminal item.  The result takes the place of the first reduced item rather than being
+        // pushed after erasing them all.
+        template<typename ParseItem, typename DataPointer> void replaceReduced(std::vector<ParseItem> &parseStack, size_t start, unsigned int rule, DataPointer data)
+        {
+            parseStack.resize(start + 1);
+
+            ParseItem &parseItem = parseStack.back();
+            parseItem.type = ParseItem::Type::Nonterminal;
+            parseItem.index = rule;
+            parseItem.data = std::move(data);
+        }
+
+        // Reads the first token, or one that was pending on more input, so that the time spent matching
+        // it is charged to the tokenizer; afterwards nextToken() returns it without further work.
+        template<typename ProfilerType> void readToken(Tokenizer::Stream &stream, ProfilerType &profiler)
+        {
+            profiler.time(ProfileCounters::Phase::Tokenizer, [&]() {
+                stream.nextToken();
+            });
+        }
+
+        enum class RecoveryStart {
+            Abandon,
+            Skipped,
+            Resynchronize
+        };
+
+        // The first step of error recovery, common to both sessions.  ParseState has recovering, the
+        // number of tokens still to consume before another error is reported, and errorPending.  Returns
+        // Abandon if recovery cannot continue and Skipped if the token was dropped without
+        // resynchronizing; otherwise the error is reported unless one was reported recently, and the
+        // session goes on to resynchronize with Resynchronize.
+        template<typename ParseState> RecoveryStart startRecovery(Tokenizer::Stream &stream, ParseState &parseState, std::vector<Diagnostic> &diagnostics)
+        {
+            // The error terminal itself could not be used, so there is nothing left to resynchronize on.
+            if(parseState.errorPending) {
+                return RecoveryStart::Abandon;
+            }
+
+            const Tokenizer::Token &token = stream.nextToken();
+            bool end = (token.value == stream.tokenizer().endValue());
+
+            // Nothing has been consumed since the last resynchronization, so the token cannot be used.
+            if(parseState.recovering == 3) {
+                if(end) {
+                    return RecoveryStart::Abandon;
+                }
+                stream.consumeToken();
+                return RecoveryStart::Skipped;
+            }
+
+            if(parseState.recovering == 0) {
+                diagnostics.push_back(Diagnostic{token.line, token.start, "Unexpected symbol " + std::string(token.text)});
+            }
+            parseState.recovering = 3;
+            return RecoveryStart::Resynchronize;
+        }
+
+        // Push-mode parsing for input that arrives in chunks.  start() begins a parse, feed() tokenizes
+        // and parses each complete line as it arrives and returns false once the input can no longer be
+        // valid, and finish() ends the input and returns the result.  The session supplies run(stream,
+        // state), which parses as far as the buffered input allows, and accept(state), which produces
+        // the result of an accepted parse.
+        template<typename ParseState> class PushParse
+        {
+        public:
+            PushParse();
+
+            // Returns the state for the session to reset.
+            ParseState &start(const Tokenizer &tokenizer);
+            template<typename Run> bool feed(std::string_view bytes, Run run);
+            template<typename Run, typename Accept> auto finish(Run run, Accept accept) -> decltype(accept(std::declval<ParseState&>()));
+
+            ParseState &state();
+
+        private:
+            std::unique_ptr<Tokenizer::Stream> mStream;
+            ParseState mState;
+            ParseStatus mStatus;
+        };
+
+        template<typename ParseState> PushParse<ParseState>::PushParse()
+        : mStatus(ParseStatus::Error)
+        {
+        }
+
+        template<typename ParseState> ParseState &PushParse<ParseState>::start(const Tokenizer &tokenizer)
+        {
+            mStream = std::make_unique<Tokenizer::Stream>(tokenizer);
+            mStatus = ParseStatus::Pending;
+            return mState;
+        }
+
+        template<typename ParseState> template<typename Run> bool PushParse<ParseState>::feed(std::string_view bytes, Run run)
+        {
+            if(mStatus != ParseStatus::Pending) {
+                return mStatus == ParseStatus::Accepted;
+            }
+
+            mStream->feed(bytes);
+            mStatus = run(*mStream, mState);
+            return mStatus != ParseStatus::Error;
+        }
+
+        template<typename ParseState> template<typename Run, typename Accept> auto PushParse<ParseState>::finish(Run run, Accept accept) -> decltype(accept(std::declval<ParseState&>()))
+        {
+            decltype(accept(mState)) result{};
+            if(!mStream) {
+                return result;
+            }
+
+            mStream->finish();
+            if(mStatus == ParseStatus::Pending) {
+                mStatus = run(*mStream, mState);
+            }
+            if(mStatus == ParseStatus::Accepted) {
+                result = accept(mState);
+            }
+
+            mStream.reset();
+            mStatus = ParseStatus::Error;
+            return result;
+        }
+
+        template<typename ParseState> ParseState &PushParse<ParseState>::state()
+        {
+            return mState;
+        }
+    }
+}
+
+#endif
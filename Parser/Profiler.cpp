@@ -0,0 +1,142 @@
+#include "Parser/Profiler.hpp"
+
+#include <algorithm>
+
+namespace Parser
+{
+    static void writeJsonString(std::ostream &out, const std::string &string)
+    {
+        out << '"';
+        for(char c : string) {
+            switch(c) {
+                case '"':
+                    out << "\\\"";
+                    break;
+
+                case '\\':
+                    out << "\\\\";
+                    break;
+
+                default:
+                    out << c;
+                    break;
+            }
+        }
+        out << '"';
+    }
+
+    ProfileCounters::ProfileCounters()
+    {
+        reset();
+    }
+
+    void ProfileCounters::reset()
+    {
+        tokens = 0;
+        shifts = 0;
+        reductions = 0;
+        ruleReductions.clear();
+        stackSplits = 0;
+        stackMerges = 0;
+        earleySets = 0;
+        earleyItems = 0;
+        maxEarleyItems = 0;
+        parseTime = 0;
+        tokenizerTime = 0;
+        reducerTime = 0;
+    }
+
+    void ProfileCounters::add(const ProfileCounters &other)
+    {
+        tokens += other.tokens;
+        shifts += other.shifts;
+        reductions += other.reductions;
+        if(ruleReductions.size() < other.ruleReductions.size()) {
+            ruleReductions.resize(other.ruleReductions.size(), 0);
+        }
+        for(size_t i=0; i<other.ruleReductions.size(); i++) {
+            ruleReductions[i] += other.ruleReductions[i];
+        }
+        stackSplits += other.stackSplits;
+        stackMerges += other.stackMerges;
+        earleySets += other.earleySets;
+        earleyItems += other.earleyItems;
+        maxEarleyItems = std::max(maxEarleyItems, other.maxEarleyItems);
+        parseTime += other.parseTime;
+        tokenizerTime += other.tokenizerTime;
+        reducerTime += other.reducerTime;
+    }
+
+    unsigned long long ProfileCounters::tableTime() const
+    {
+        unsigned long long other = tokenizerTime + reducerTime;
+        return (parseTime > other) ? parseTime - other : 0;
+    }
+
+    void ProfileCounters::writeJson(std::ostream &out, const Grammar &grammar) const
+    {
+        out << "{" << std::endl;
+        out << "  \"tokens\": " << tokens << "," << std::endl;
+        out << "  \"shifts\": " << shifts << "," << std::endl;
+        out << "  \"reductions\": " << reductions << "," << std::endl;
+
+        out << "  \"rules\": {";
+        bool first = true;
+        for(size_t i=0; i<ruleReductions.size() && i<grammar.rules().size(); i++) {
+            if(ruleReductions[i] == 0) {
+                continue;
+            }
+            out << (first ? "" : ",") << std::endl << "    ";
+            writeJsonString(out, grammar.rules()[i].lhs);
+            out << ": " << ruleReductions[i];
+            first = false;
+        }
+        out << (first ? "" : "\n  ") << "}," << std::endl;
+
+        out << "  \"stackSplits\": " << stackSplits << "," << std::endl;
+        out << "  \"stackMerges\": " << stackMerges << "," << std::endl;
+        out << "  \"earleySets\": " << earleySets << "," << std::endl;
+        out << "  \"earleyItems\": " << earleyItems << "," << std::endl;
+        out << "  \"maxEarleyItems\": " << maxEarleyItems << "," << std::endl;
+
+        out << "  \"timeNs\": {" << std::endl;
+        out << "    \"parse\": " << parseTime << "," << std::endl;
+        out << "    \"tokenizer\": " << tokenizerTime << "," << std::endl;
+        out << "    \"tables\": " << tableTime() << "," << std::endl;
+        out << "    \"reducers\": " << reducerTime << std::endl;
+        out << "  }" << std::endl;
+        out << "}" << std::endl;
+    }
+
+    const ProfileCounters &NullProfiler::counters() const
+    {
+        static const ProfileCounters counters;
+        return counters;
+    }
+
+    void Profiler::countReduction(unsigned int rule)
+    {
+        mCounters.reductions++;
+        if(rule >= mCounters.ruleReductions.size()) {
+            mCounters.ruleReductions.resize(rule + 1, 0);
+        }
+        mCounters.ruleReductions[rule]++;
+    }
+
+    void Profiler::countEarleySet(size_t items)
+    {
+        mCounters.earleySets++;
+        mCounters.earleyItems += items;
+        mCounters.maxEarleyItems = std::max(mCounters.maxEarleyItems, (unsigned long long)items);
+    }
+
+    const ProfileCounters &Profiler::counters() const
+    {
+        return mCounters;
+    }
+
+    void Profiler::reset()
+    {
+        mCounters.reset();
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef PARSER_PROFILER_HPP
+#define PARSER_PROFILER_HPP
+
+#include "Parser/Grammar.hpp"
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+namespace Parser
+{
+    // Counters gathered by a session profiled with Profiler, accumulated over every parse until reset.
+    // LL sessions count matched terminals as shifts and rule expansions as reductions; GLR and Earley
+    // sessions count a reduction for each derivation added to the forest, and Earley sessions count
+    // the completed items in each set.  Times are in nanoseconds.  Table time is the part of parse
+    // time spent neither in the tokenizer nor in user reducers, decorators and listeners; Earley
+    // sessions tokenize from inside their set construction, so their tokenizer time is included in it.
+    struct ProfileCounters {
+        enum class Phase {
+            Parse,
+            Tokenizer,
+            Reducers
+        };
+
+        ProfileCounters();
+
+        void reset();
+        void add(const ProfileCounters &other);
+
+        unsigned long long tableTime() const;
+        void writeJson(std::ostream &out, const Grammar &grammar) const;
+
+        unsigned long long tokens;
+        unsigned long long shifts;
+        unsigned long long reductions;
+        std::vector<unsigned long long> ruleReductions;
+
+        unsigned long long stackSplits;
+        unsigned long long stackMerges;
+
+        unsigned long long earleySets;
+        unsigned long long earleyItems;
+        unsigned long long maxEarleyItems;
+
+        unsigned long long parseTime;
+        unsigned long long tokenizerTime;
+        unsigned long long reducerTime;
+    };
+
+    // Profiling policy which records nothing.  Sessions use it by default, and every call on it
+    // compiles away.
+    class NullProfiler
+    {
+    public:
+        void countToken() {}
+        void countShift() {}
+        void countReduction(unsigned int) {}
+        void countSplit() {}
+        void countMerge() {}
+        void countEarleySet(size_t) {}
+
+        template<typename F> auto time(ProfileCounters::Phase, F f) { return f(); }
+
+        const ProfileCounters &counters() const;
+        void reset() {}
+    };
+
+    // Profiling policy which fills in ProfileCounters.  Pass it as a session's last template argument.
+    class Profiler
+    {
+    public:
+        void countToken() { mCounters.tokens++; }
+        void countShift() { mCounters.shifts++; }
+        void countReduction(unsigned int rule);
+        void countSplit() { mCounters.stackSplits++; }
+        void countMerge() { mCounters.stackMerges++; }
+        void countEarleySet(size_t items);
+
+        // Calls f and adds the time it took to the given phase.
+        template<typename F> auto time(ProfileCounters::Phase phase, F f);
+
+        const ProfileCounters &counters() const;
+        void reset();
+
+    private:
+        class Timer {
+        public:
+            Timer(unsigned long long &total) : mTotal(total), mStart(std::chrono::steady_clock::now()) {}
+            ~Timer() { mTotal += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count(); }
+
+        private:
+            unsigned long long &mTotal;
+            std::chrono::steady_clock::time_point mStart;
+        };
+
+        ProfileCounters mCounters;
+    };
+
+    template<typename F> auto Profiler::time(ProfileCounters::Phase phase, F f)
+    {
+        unsigned long long *total = &mCounters.parseTime;
+        switch(phase) {
+            case ProfileCounters::Phase::Parse:
+                total = &mCounters.parseTime;
+                break;
+
+            case ProfileCounters::Phase::Tokenizer:
+                total = &mCounters.tokenizerTime;
+                break;
+
+            case ProfileCounters::Phase::Reducers:
+                total = &mCounters.reducerTime;
+                break;
+        }
+
+        Timer timer(*total);
+        return f();
+    }
+}
+#endif
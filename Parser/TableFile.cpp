@@ -0,0 +1,97 @@
+#include "Parser/TableFile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace Parser
+{
+    static const uint32_t kMagic = Util::binaryTag("PTBL");
+
+    TableFile::TableFile(const std::string &filename, uint64_t sourceHash)
+    : mFile(filename), mReader(mFile.data())
+    {
+        uint32_t version = 0;
+        uint64_t hash = 0;
+        uint64_t size = 0;
+
+        mReader.expect(kMagic);
+        mReader.read(version);
+        mReader.read(hash);
+        mReader.read(size);
+
+        mValid = mFile.valid() && mReader.valid() && version == kVersion && hash == sourceHash && size == mFile.data().size();
+        if(!mValid) {
+            mReader.invalidate();
+        }
+    }
+
+    bool TableFile::valid() const
+    {
+        return mValid;
+    }
+
+    Util::BinaryReader &TableFile::reader()
+    {
+        return mReader;
+    }
+
+    uint64_t TableFile::hashFile(const std::string &filename)
+    {
+        Util::MappedFile file(filename);
+
+        uint64_t hash = 14695981039346656037ull;
+        for(char c : file.data()) {
+            hash ^= (unsigned char)c;
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    bool TableFile::write(const std::string &filename, uint64_t sourceHash, const Util::BinaryWriter &writer)
+    {
+        Util::BinaryWriter header;
+        header.write(kMagic);
+        header.write((uint32_t)kVersion);
+        header.write(sourceHash);
+
+        uint64_t size = header.data().size() + sizeof(uint64_t) + writer.data().size();
+        header.write(size);
+
+        // Other processes may have the old file mapped, and would fault reading past the end of a file
+        // truncated under them, or see it half written.  The tables are written to a file of their own
+        // and renamed over the old one once complete, so readers see either the old file or the new.
+        std::random_device random;
+        std::stringstream ss;
+        ss << filename << ".tmp" << std::hex << random() << random();
+        std::string tempFilename = ss.str();
+
+        std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+        file.write(header.data().data(), header.data().size());
+        file.write(writer.data().data(), writer.data().size());
+        file.close();
+        if(!file) {
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+
+#ifdef _WIN32
+        bool renamed = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        bool renamed = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+        if(!renamed) {
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef PARSER_TABLE_FILE_HPP
+#define PARSER_TABLE_FILE_HPP
+
+#include "Util/Binary.hpp"
+#include "Util/MappedFile.hpp"
+
+#include <string>
+#include <cstdint>
+
+namespace Parser
+{
+    class TableFile
+    {
+    public:
+        static const uint32_t kVersion = 3;
+
+        TableFile(const std::string &filename, uint64_t sourceHash);
+
+        bool valid() const;
+        Util::BinaryReader &reader();
+
+        static uint64_t hashFile(const std::string &filename);
+        static bool write(const std::string &filename, uint64_t sourceHash, const Util::BinaryWriter &writer);
+
+    private:
+        Util::MappedFile mFile;
+        Util::BinaryReader mReader;
+        bool mValid;
+    };
+}
+#endif
@@ -1,6 +1,7 @@
 #include "Parser/Tokenizer.hpp"
 
 #include <algorithm>
+#include <thread>
 
 namespace Parser
 {
@@ -15,9 +16,77 @@ namespace Parser
                 patterns.push_back(pattern.regex);
             }
             mMatchers.push_back(std::make_unique<Regex::Matcher>(std::move(patterns)));
+            createIgnoreScanner(configuration, *mMatchers.back());
         }
     }
 
+    Tokenizer::Tokenizer(Util::BinaryReader &reader)
+    {
+        reader.expect(Util::binaryTag("TOKN"));
+        reader.read(mEndValue);
+        reader.read(mNewlineValue);
+
+        uint32_t numConfigurations = 0;
+        reader.read(numConfigurations);
+        for(uint32_t i=0; i<numConfigurations && reader.valid(); i++) {
+            Configuration configuration;
+            uint32_t numPatterns = 0;
+            reader.read(numPatterns);
+            for(uint32_t j=0; j<numPatterns && reader.valid(); j++) {
+                Pattern pattern;
+                reader.read(pattern.regex);
+                reader.read(pattern.name);
+                reader.read(pattern.value);
+                configuration.patterns.push_back(std::move(pattern));
+            }
+
+            std::unique_ptr<Regex::Matcher> matcher = std::make_unique<Regex::Matcher>(reader);
+            if(!reader.valid() || matcher->numPatterns() != configuration.patterns.size()) {
+                reader.invalidate();
+                return;
+            }
+
+            createIgnoreScanner(configuration, *matcher);
+            mMatchers.push_back(std::move(matcher));
+            mConfigurations.push_back(std::move(configuration));
+        }
+    }
+
+    void Tokenizer::save(Util::BinaryWriter &writer) const
+    {
+        writer.write(Util::binaryTag("TOKN"));
+        writer.write(mEndValue);
+        writer.write(mNewlineValue);
+
+        writer.write((uint32_t)mConfigurations.size());
+        for(unsigned int i=0; i<mConfigurations.size(); i++) {
+            const Configuration &configuration = mConfigurations[i];
+            writer.write((uint32_t)configuration.patterns.size());
+            for(const auto &pattern : configuration.patterns) {
+                writer.write(pattern.regex);
+                writer.write(pattern.name);
+                writer.write(pattern.value);
+            }
+            mMatchers[i]->save(writer);
+        }
+    }
+
+    void Tokenizer::createIgnoreScanner(const Configuration &configuration, const Regex::Matcher &matcher)
+    {
+        std::vector<unsigned int> ignorePatterns;
+        for(unsigned int i=0; i<configuration.patterns.size(); i++) {
+            if(configuration.patterns[i].value == kInvalidTokenValue) {
+                ignorePatterns.push_back(i);
+            }
+        }
+
+        std::unique_ptr<Regex::ClassScanner> ignoreScanner;
+        if(ignorePatterns.size() > 0 && matcher.valid()) {
+            ignoreScanner = matcher.createSkipScanner(ignorePatterns);
+        }
+        mIgnoreScanners.push_back(std::move(ignoreScanner));
+    }
+
     unsigned int Tokenizer::patternValue(const std::string &name, unsigned int configuration) const
     {
         for(unsigned int i=0; i<mConfigurations[configuration].patterns.size(); i++) {
@@ -34,13 +103,134 @@ namespace Parser
         return mEndValue;
     }
 
+    Tokenizer::TokenValue Tokenizer::newlineValue() const
+    {
+        return mNewlineValue;
+    }
+
+    const std::vector<Tokenizer::Configuration> &Tokenizer::configurations() const
+    {
+        return mConfigurations;
+    }
+
+    const Regex::Matcher &Tokenizer::matcher(unsigned int configuration) const
+    {
+        return *mMatchers[configuration];
+    }
+
+    std::vector<Tokenizer::Token> Tokenizer::tokenizeParallel(std::string_view buffer, unsigned int threads) const
+    {
+        std::vector<std::string_view> chunks;
+        size_t begin = 0;
+        for(unsigned int i=1; i<threads; i++) {
+            size_t target = std::max(begin, buffer.size() * i / threads);
+            size_t split = buffer.find('\n', target);
+            if(split == std::string_view::npos) {
+                break;
+            }
+            chunks.push_back(buffer.substr(begin, split - begin));
+            begin = split + 1;
+        }
+        chunks.push_back(buffer.substr(begin));
+
+        std::vector<std::vector<Token>> chunkTokens(chunks.size());
+        auto tokenizeChunk = [&](size_t chunk) {
+            Stream stream(*this, chunks[chunk]);
+            while(true) {
+                chunkTokens[chunk].push_back(stream.nextToken());
+                if(stream.nextToken().value == mEndValue || stream.nextToken().value == kErrorTokenValue) {
+                    break;
+                }
+                stream.consumeToken();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(size_t i=1; i<chunks.size(); i++) {
+            workers.push_back(std::thread(tokenizeChunk, i));
+        }
+        tokenizeChunk(0);
+        for(auto &worker : workers) {
+            worker.join();
+        }
+
+        std::vector<Token> tokens;
+        size_t total = 0;
+        for(const auto &t : chunkTokens) {
+            total += t.size();
+        }
+        tokens.reserve(total);
+
+        unsigned int lineOffset = 0;
+        for(size_t i=0; i<chunkTokens.size(); i++) {
+            for(const Token &token : chunkTokens[i]) {
+                Token stitched = token;
+                stitched.line += lineOffset;
+                if(token.value == mEndValue && i < chunkTokens.size() - 1) {
+                    lineOffset = stitched.line;
+                    break;
+                }
+                tokens.push_back(stitched);
+                if(token.value == kErrorTokenValue) {
+                    return tokens;
+                }
+            }
+        }
+
+        return tokens;
+    }
+
     Tokenizer::Stream::Stream(const Tokenizer &tokenizer, std::istream &input)
-    : mTokenizer(tokenizer), mInput(input)
+    : mTokenizer(tokenizer), mInput(&input)
+    {
+        mBufferPos = 0;
+        mPush = false;
+        mFinished = false;
+        mConsumed = 0;
+        mLine = 0;
+        mConfiguration = 0;
+        mNextToken = {kInvalidTokenValue, 0, 0, {}};
+    }
+
+    Tokenizer::Stream::Stream(const Tokenizer &tokenizer, std::string_view buffer)
+    : mTokenizer(tokenizer), mInput(nullptr), mBuffer(buffer)
     {
+        mBufferPos = 0;
+        mPush = false;
+        mFinished = false;
         mConsumed = 0;
         mLine = 0;
         mConfiguration = 0;
-        mNextToken = {kInvalidTokenValue, 0, 0};
+        mNextToken = {kInvalidTokenValue, 0, 0, {}};
+    }
+
+    Tokenizer::Stream::Stream(const Tokenizer &tokenizer)
+    : mTokenizer(tokenizer), mInput(nullptr)
+    {
+        mBufferPos = 0;
+        mPush = true;
+        mFinished = false;
+        mConsumed = 0;
+        mLine = 0;
+        mConfiguration = 0;
+        mNextToken = {kInvalidTokenValue, 0, 0, {}};
+    }
+
+    void Tokenizer::Stream::feed(std::string_view bytes)
+    {
+        if(!mPush || mFinished) {
+            return;
+        }
+
+        // Lines already handed out have been copied to mLineBuffer, so the consumed prefix can go.
+        mPending.erase(0, mBufferPos);
+        mBufferPos = 0;
+        mPending.append(bytes);
+    }
+
+    void Tokenizer::Stream::finish()
+    {
+        mFinished = true;
     }
 
     void Tokenizer::Stream::setConfiguration(unsigned int configuration)
@@ -57,7 +247,7 @@ namespace Parser
 
     const Tokenizer::Token &Tokenizer::Stream::nextToken()
     {
-        if(mLine == 0) {
+        if(mLine == 0 || mNextToken.value == kPendingTokenValue) {
             consumeToken();
         }
         return mNextToken;
@@ -65,10 +255,15 @@ namespace Parser
 
     void Tokenizer::Stream::consumeToken()
     {
-        if(mNextToken.value == kErrorTokenValue || mNextToken.value == mTokenizer.mEndValue) {
+        if(mNextToken.value == mTokenizer.mEndValue) {
             return;
         }
 
+        // An error token is the one character no pattern matched, so consuming it skips that character.
+        if(mNextToken.value == kErrorTokenValue) {
+            mConsumed++;
+        }
+
         bool repeat = true;
         while(repeat) {
             while(mConsumed >= mCurrentLine.size()) {
@@ -81,7 +276,15 @@ namespace Parser
                     return;
                 }
 
-                if(mInput.eof() || mInput.fail()) {
+                if(!readLine()) {
+                    if(mPush && !mFinished) {
+                        mNextToken.value = kPendingTokenValue;
+                        mNextToken.start = mConsumed;
+                        mNextToken.line = mLine;
+                        mNextToken.text = "<pending>";
+                        return;
+                    }
+
                     mNextToken.value = mTokenizer.mEndValue;
                     mNextToken.start = mConsumed;
                     mNextToken.line = mLine;
@@ -89,11 +292,18 @@ namespace Parser
                     return;
                 }
 
-                std::getline(mInput, mCurrentLine);
                 mConsumed = 0;
                 mLine++;
             }
 
+            const Regex::ClassScanner *ignoreScanner = mTokenizer.mIgnoreScanners[mConfiguration].get();
+            if(ignoreScanner) {
+                mConsumed = ignoreScanner->skip(mCurrentLine, mConsumed);
+                if(mConsumed >= mCurrentLine.size()) {
+                    continue;
+                }
+            }
+
             unsigned int pattern;
             unsigned int matched = mTokenizer.mMatchers[mConfiguration]->match(mCurrentLine, mConsumed, pattern);
             if(matched == 0) {
@@ -119,6 +329,46 @@ namespace Parser
         }
     }
 
+    bool Tokenizer::Stream::readLine()
+    {
+        if(mInput) {
+            if(mInput->eof() || mInput->fail()) {
+                return false;
+            }
+
+            std::getline(*mInput, mLineBuffer);
+            mCurrentLine = mLineBuffer;
+        } else if(mPush) {
+            if(mBufferPos > mPending.size()) {
+                return false;
+            }
+
+            size_t end = mPending.find('\n', mBufferPos);
+            if(end == std::string::npos) {
+                if(!mFinished) {
+                    return false;
+                }
+                end = mPending.size();
+            }
+            mLineBuffer.assign(mPending, mBufferPos, end - mBufferPos);
+            mCurrentLine = mLineBuffer;
+            mBufferPos = end + 1;
+        } else {
+            if(mBufferPos > mBuffer.size()) {
+                return false;
+            }
+
+            size_t end = mBuffer.find('\n', mBufferPos);
+            if(end == std::string_view::npos) {
+                end = mBuffer.size();
+            }
+            mCurrentLine = mBuffer.substr(mBufferPos, end - mBufferPos);
+            mBufferPos = end + 1;
+        }
+
+        return true;
+    }
+
     const Tokenizer &Tokenizer::Stream::tokenizer() const
     {
         return mTokenizer;
@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <istream>
 #include <functional>
 
@@ -14,8 +15,9 @@ namespace Parser
     {
     public:
         typedef unsigned int TokenValue;
-        static const TokenValue kInvalidTokenValue = UINT_MAX;
-        static const TokenValue kErrorTokenValue = kInvalidTokenValue -1;
+        static constexpr TokenValue kInvalidTokenValue = UINT_MAX;
+        static constexpr TokenValue kErrorTokenValue = kInvalidTokenValue -1;
+        static constexpr TokenValue kPendingTokenValue = kInvalidTokenValue - 2;
 
         struct Pattern {
             std::string regex;
@@ -27,35 +29,60 @@ namespace Parser
             std::vector<Pattern> patterns;
         };
         Tokenizer(std::vector<Configuration> configurations, TokenValue endValue, TokenValue newlineValue);
+        Tokenizer(Util::BinaryReader &reader);
+
+        void save(Util::BinaryWriter &writer) const;
 
         struct Token {
             TokenValue value;
             unsigned int start;
             unsigned int line;
-            std::string text;
+            std::string_view text;
         };
 
         unsigned int patternValue(const std::string &name, unsigned int configuration) const;
 
         TokenValue endValue() const;
+        TokenValue newlineValue() const;
+
+        const std::vector<Configuration> &configurations() const;
+        const Regex::Matcher &matcher(unsigned int configuration) const;
+
+        std::vector<Token> tokenizeParallel(std::string_view buffer, unsigned int threads) const;
 
         class Stream
         {
         public:
             Stream(const Tokenizer &tokenizer, std::istream &input);
+            Stream(const Tokenizer &tokenizer, std::string_view buffer);
+
+            // Push mode: input arrives through feed() and ends with finish().  Tokens are produced a line
+            // at a time as complete lines arrive; until then nextToken() returns kPendingTokenValue.
+            Stream(const Tokenizer &tokenizer);
+            void feed(std::string_view bytes);
+            void finish();
 
             void setConfiguration(unsigned int configuration);
             unsigned int configuration() const;
 
             const Token &nextToken();
+            // Consuming an error token skips the character it was made from.
             void consumeToken();
 
             const Tokenizer &tokenizer() const;
 
         private:
+            bool readLine();
+
             const Tokenizer &mTokenizer;
-            std::istream &mInput;
-            std::string mCurrentLine;
+            std::istream *mInput;
+            std::string mLineBuffer;
+            std::string_view mBuffer;
+            size_t mBufferPos;
+            bool mPush;
+            bool mFinished;
+            std::string mPending;
+            std::string_view mCurrentLine;
             unsigned int mConsumed;
             Token mNextToken;
             unsigned int mLine;
@@ -63,10 +90,11 @@ namespace Parser
         };
 
     private:
-        void initialize();
+        void createIgnoreScanner(const Configuration &configuration, const Regex::Matcher &matcher);
 
         std::vector<Configuration> mConfigurations;
         std::vector<std::unique_ptr<Regex::Matcher>> mMatchers;
+        std::vector<std::unique_ptr<Regex::ClassScanner>> mIgnoreScanners;
 
         TokenValue mEndValue;
         TokenValue mNewlineValue;
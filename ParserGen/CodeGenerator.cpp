@@ -0,0 +1,529 @@
+#include "ParserGen/CodeGenerator.hpp"
+
+#include <cctype>
+#include <climits>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ParserGen
+{
+    static std::string quote(const std::string &string)
+    {
+        std::string result = "\"";
+        for(char c : string) {
+            switch(c) {
+                case '\\':
+                case '"':
+                    result.push_back('\\');
+                    result.push_back(c);
+                    break;
+
+                case '\n':
+                    result += "\\n";
+                    break;
+
+                case '\t':
+                    result += "\\t";
+                    break;
+
+                default:
+                    result.push_back(c);
+                    break;
+            }
+        }
+        result.push_back('"');
+
+        return result;
+    }
+
+    static std::string tokenValue(Parser::Tokenizer::TokenValue value)
+    {
+        if(value == Parser::Tokenizer::kInvalidTokenValue) {
+            return "kInvalidTokenValue";
+        } else {
+            return std::to_string(value);
+        }
+    }
+
+    CodeGenerator::CodeGenerator(const Parser::Tokenizer &tokenizer, const Parser::Grammar &grammar, const Parser::Impl::LRSingle &parser)
+    : mTokenizer(tokenizer), mGrammar(grammar), mParser(parser)
+    {
+    }
+
+    void CodeGenerator::write(std::ostream &out, const std::string &name, const std::string &source) const
+    {
+        std::string guard = "GENERATED_";
+        for(char c : name) {
+            guard.push_back((char)std::toupper((unsigned char)c));
+        }
+        guard += "_HPP";
+
+        out << "// Generated by parsergen from " << source << ", do not edit" << std::endl;
+        out << "#ifndef " << guard << std::endl;
+        out << "#define " << guard << std::endl;
+        out << std::endl;
+        out << "#include <climits>" << std::endl;
+        out << "#include <string_view>" << std::endl;
+        out << "#include <utility>" << std::endl;
+        out << "#include <vector>" << std::endl;
+        out << std::endl;
+        out << "namespace " << name << std::endl;
+        out << "{" << std::endl;
+
+        writeSymbols(out);
+        for(unsigned int i=0; i<mTokenizer.configurations().size(); i++) {
+            writeMatcher(out, i);
+        }
+        writeLexer(out);
+        writeTables(out);
+        writeParser(out);
+
+        out << "}" << std::endl;
+        out << "#endif" << std::endl;
+    }
+
+    void CodeGenerator::writeSymbols(std::ostream &out) const
+    {
+        out << "    typedef unsigned int TokenValue;" << std::endl;
+        out << "    static const TokenValue kInvalidTokenValue = UINT_MAX;" << std::endl;
+        out << "    static const TokenValue kErrorTokenValue = kInvalidTokenValue - 1;" << std::endl;
+        out << "    static const TokenValue kEndValue = " << tokenValue(mTokenizer.endValue()) << ";" << std::endl;
+        out << "    static const TokenValue kNewlineValue = " << tokenValue(mTokenizer.newlineValue()) << ";" << std::endl;
+        out << std::endl;
+        out << "    static const unsigned int kNumConfigurations = " << mTokenizer.configurations().size() << ";" << std::endl;
+        out << "    static const unsigned int kNumTerminals = " << mGrammar.terminals().size() << ";" << std::endl;
+        out << "    static const unsigned int kNumRules = " << mGrammar.rules().size() << ";" << std::endl;
+        out << "    static const unsigned int kStartRule = " << mGrammar.startRule() << ";" << std::endl;
+        out << std::endl;
+
+        out << "    inline const char *const kTerminalNames[kNumTerminals] = {" << std::endl;
+        for(const auto &terminal : mGrammar.terminals()) {
+            out << "        " << quote(terminal) << "," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    inline const char *const kRuleNames[kNumRules] = {" << std::endl;
+        for(const auto &rule : mGrammar.rules()) {
+            out << "        " << quote(rule.lhs) << "," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << R"(    inline unsigned int terminalIndex(std::string_view name)
+    {
+        for(unsigned int i=0; i<kNumTerminals; i++) {
+            if(name == kTerminalNames[i]) {
+                return i;
+            }
+        }
+
+        return UINT_MAX;
+    }
+
+    inline unsigned int ruleIndex(std::string_view name)
+    {
+        for(unsigned int i=0; i<kNumRules; i++) {
+            if(name == kRuleNames[i]) {
+                return i;
+            }
+        }
+
+        return UINT_MAX;
+    }
+
+    struct Token {
+        TokenValue value;
+        unsigned int start;
+        unsigned int line;
+        std::string_view text;
+    };
+
+)";
+    }
+
+    void CodeGenerator::writeMatcher(std::ostream &out, unsigned int configuration) const
+    {
+        const Parser::Tokenizer::Configuration &config = mTokenizer.configurations()[configuration];
+
+        out << "    inline const TokenValue kPatternValues" << configuration << "[] = {" << std::endl;
+        for(const auto &pattern : config.patterns) {
+            out << "        " << tokenValue(pattern.value) << "," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    inline unsigned int match" << configuration << "(std::string_view string, unsigned int start, unsigned int &pattern)" << std::endl;
+        out << "    {" << std::endl;
+
+        const Regex::Matcher &tokenizerMatcher = mTokenizer.matcher(configuration);
+        if(!tokenizerMatcher.valid()) {
+            out << "        return 0;" << std::endl;
+            out << "    }" << std::endl;
+            out << std::endl;
+            return;
+        }
+
+        // The generated code needs every state, so a matcher which fell back to a lazy DFA is rebuilt
+        // in full.
+        std::unique_ptr<Regex::Matcher> fullMatcher;
+        if(!tokenizerMatcher.hasDFA()) {
+            std::vector<std::string> patterns;
+            for(const auto &pattern : config.patterns) {
+                patterns.push_back(pattern.regex);
+            }
+            fullMatcher = std::make_unique<Regex::Matcher>(patterns, UINT_MAX);
+        }
+        const Regex::Matcher &matcher = fullMatcher ? *fullMatcher : tokenizerMatcher;
+
+        const Regex::DFA &dfa = matcher.dfa();
+        const Regex::Encoding &encoding = matcher.encoding();
+
+        out << "        unsigned int state = " << dfa.startState() << ";" << std::endl;
+        out << "        unsigned int matched = 0;" << std::endl;
+        out << std::endl;
+        out << "        for(unsigned int i=start; i<string.size(); i++) {" << std::endl;
+        out << "            switch(state) {" << std::endl;
+
+        for(unsigned int state=0; state<dfa.numStates(); state++) {
+            if(state == dfa.rejectState()) {
+                continue;
+            }
+
+            std::map<unsigned int, std::vector<unsigned int>> targets;
+            for(unsigned int byte=0; byte<256; byte++) {
+                Regex::Encoding::CodePoint codePoint = encoding.codePoint((Regex::Encoding::InputSymbol)byte);
+                if(codePoint == Regex::Encoding::kInvalidCodePoint) {
+                    continue;
+                }
+
+                unsigned int nextState = dfa.transition(state, codePoint);
+                if(nextState != dfa.rejectState()) {
+                    targets[nextState].push_back(byte);
+                }
+            }
+
+            if(targets.size() == 0) {
+                continue;
+            }
+
+            out << "                case " << state << ":" << std::endl;
+            out << "                    switch((unsigned char)string[i]) {" << std::endl;
+            for(const auto &target : targets) {
+                for(unsigned int i=0; i<target.second.size(); i++) {
+                    out << ((i % 8 == 0) ? "                        " : " ") << "case " << target.second[i] << ":";
+                    if(i % 8 == 7 || i == target.second.size() - 1) {
+                        out << std::endl;
+                    }
+                }
+                out << "                            state = " << target.first << ";" << std::endl;
+
+                unsigned int index;
+                if(dfa.accept(target.first, index)) {
+                    out << "                            pattern = " << index << ";" << std::endl;
+                    out << "                            matched = i - start + 1;" << std::endl;
+                }
+                out << "                            break;" << std::endl;
+                out << std::endl;
+            }
+            out << "                        default:" << std::endl;
+            out << "                            return matched;" << std::endl;
+            out << "                    }" << std::endl;
+            out << "                    break;" << std::endl;
+            out << std::endl;
+        }
+
+        out << "                default:" << std::endl;
+        out << "                    return matched;" << std::endl;
+        out << "            }" << std::endl;
+        out << "        }" << std::endl;
+        out << std::endl;
+        out << "        return matched;" << std::endl;
+        out << "    }" << std::endl;
+        out << std::endl;
+    }
+
+    void CodeGenerator::writeLexer(std::ostream &out) const
+    {
+        out << R"(    class Lexer
+    {
+    public:
+        Lexer(std::string_view buffer)
+        : mBuffer(buffer)
+        {
+            mBufferPos = 0;
+            mConsumed = 0;
+            mLine = 0;
+            mConfiguration = 0;
+            mNextToken = {kInvalidTokenValue, 0, 0, {}};
+        }
+
+        void setConfiguration(unsigned int configuration)
+        {
+            if(configuration < kNumConfigurations) {
+                mConfiguration = configuration;
+            }
+        }
+
+        unsigned int configuration() const
+        {
+            return mConfiguration;
+        }
+
+        const Token &nextToken()
+        {
+            if(mLine == 0) {
+                consumeToken();
+            }
+            return mNextToken;
+        }
+
+        void consumeToken()
+        {
+            if(mNextToken.value == kErrorTokenValue || mNextToken.value == kEndValue) {
+                return;
+            }
+
+            while(true) {
+                while(mConsumed >= mCurrentLine.size()) {
+                    if(mConsumed == mCurrentLine.size() && kNewlineValue != kInvalidTokenValue && mLine > 0) {
+                        setToken(kNewlineValue, "<newline>");
+                        mConsumed++;
+                        return;
+                    }
+
+                    if(mBufferPos > mBuffer.size()) {
+                        setToken(kEndValue, "<end>");
+                        return;
+                    }
+
+                    size_t end = mBuffer.find('\n', mBufferPos);
+                    if(end == std::string_view::npos) {
+                        end = mBuffer.size();
+                    }
+                    mCurrentLine = mBuffer.substr(mBufferPos, end - mBufferPos);
+                    mBufferPos = end + 1;
+                    mConsumed = 0;
+                    mLine++;
+                }
+
+                unsigned int pattern = 0;
+                unsigned int matched = match(pattern);
+                if(matched == 0) {
+                    setToken(kErrorTokenValue, mCurrentLine.substr(mConsumed, 1));
+                    return;
+                }
+
+                TokenValue value = patternValue(pattern);
+                if(value != kInvalidTokenValue) {
+                    setToken(value, mCurrentLine.substr(mConsumed, matched));
+                    mConsumed += matched;
+                    return;
+                }
+
+                mConsumed += matched;
+            }
+        }
+
+    private:
+        void setToken(TokenValue value, std::string_view text)
+        {
+            mNextToken.value = value;
+            mNextToken.start = mConsumed;
+            mNextToken.line = mLine;
+            mNextToken.text = text;
+        }
+
+        unsigned int match(unsigned int &pattern) const
+        {
+            switch(mConfiguration) {
+)";
+        for(unsigned int i=0; i<mTokenizer.configurations().size(); i++) {
+            out << "                case " << i << ":" << std::endl;
+            out << "                    return match" << i << "(mCurrentLine, mConsumed, pattern);" << std::endl;
+        }
+        out << R"(                default:
+                    return 0;
+            }
+        }
+
+        TokenValue patternValue(unsigned int pattern) const
+        {
+            switch(mConfiguration) {
+)";
+        for(unsigned int i=0; i<mTokenizer.configurations().size(); i++) {
+            out << "                case " << i << ":" << std::endl;
+            out << "                    return kPatternValues" << i << "[pattern];" << std::endl;
+        }
+        out << R"(                default:
+                    return kInvalidTokenValue;
+            }
+        }
+
+        std::string_view mBuffer;
+        size_t mBufferPos;
+        std::string_view mCurrentLine;
+        unsigned int mConsumed;
+        Token mNextToken;
+        unsigned int mLine;
+        unsigned int mConfiguration;
+    };
+
+)";
+    }
+
+    void CodeGenerator::writeTables(std::ostream &out) const
+    {
+        out << "    static const unsigned int kNumStates = " << mParser.numStates() << ";" << std::endl;
+        out << std::endl;
+        out << "    static const unsigned int kActionError = 0;" << std::endl;
+        out << "    static const unsigned int kActionShift = 1;" << std::endl;
+        out << "    static const unsigned int kActionReduce = 2;" << std::endl;
+        out << std::endl;
+
+        out << "    inline constexpr unsigned int kActions[kNumStates][kNumTerminals] = {" << std::endl;
+        for(unsigned int state=0; state<mParser.numStates(); state++) {
+            out << "        {";
+            for(unsigned int terminal=0; terminal<mGrammar.terminals().size(); terminal++) {
+                const Parser::Impl::LRSingle::ParseTableEntry &entry = mParser.action(state, terminal);
+                unsigned int action = 0;
+                switch(entry.type) {
+                    case Parser::Impl::LRSingle::ParseTableEntry::Type::Shift:
+                        action = (entry.index << 2) | 1;
+                        break;
+
+                    case Parser::Impl::LRSingle::ParseTableEntry::Type::Reduce:
+                        action = (entry.index << 2) | 2;
+                        break;
+
+                    case Parser::Impl::LRSingle::ParseTableEntry::Type::Error:
+                        break;
+                }
+                out << (terminal > 0 ? ", " : "") << action;
+            }
+            out << "}," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    inline constexpr unsigned int kGotos[kNumStates][kNumRules] = {" << std::endl;
+        for(unsigned int state=0; state<mParser.numStates(); state++) {
+            out << "        {";
+            for(unsigned int rule=0; rule<mGrammar.rules().size(); rule++) {
+                const Parser::Impl::LRSingle::ParseTableEntry &entry = mParser.transition(state, rule);
+                out << (rule > 0 ? ", " : "");
+                if(entry.type == Parser::Impl::LRSingle::ParseTableEntry::Type::Shift) {
+                    out << entry.index;
+                } else {
+                    out << "UINT_MAX";
+                }
+            }
+            out << "}," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    struct Reduction {" << std::endl;
+        out << "        unsigned int rule;" << std::endl;
+        out << "        unsigned int length;" << std::endl;
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    inline constexpr Reduction kReductions[] = {" << std::endl;
+        for(unsigned int i=0; i<mParser.numReductions(); i++) {
+            const Parser::Impl::LRSingle::Reduction &reduction = mParser.reduction(i);
+            unsigned int length = 0;
+            for(const Parser::Grammar::Symbol &symbol : mGrammar.rules()[reduction.rule].rhs[reduction.rhs]) {
+                if(symbol.type != Parser::Grammar::Symbol::Type::Epsilon) {
+                    length++;
+                }
+            }
+            out << "        {" << reduction.rule << ", " << length << "}," << std::endl;
+        }
+        if(mParser.numReductions() == 0) {
+            out << "        {UINT_MAX, 0}," << std::endl;
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+
+        out << "    inline constexpr bool kAcceptStates[kNumStates] = {" << std::endl;
+        for(unsigned int state=0; state<mParser.numStates(); state++) {
+            out << (state % 16 == 0 ? "        " : " ") << (mParser.acceptState(state) ? "true" : "false") << ",";
+            if(state % 16 == 15 || state == mParser.numStates() - 1) {
+                out << std::endl;
+            }
+        }
+        out << "    };" << std::endl;
+        out << std::endl;
+    }
+
+    void CodeGenerator::writeParser(std::ostream &out) const
+    {
+        out << R"(    template<typename Value> struct ParseItem {
+        enum class Type {
+            Terminal,
+            Nonterminal
+        };
+        Type type;
+        unsigned int index;
+        Value data;
+
+        typedef ParseItem* iterator;
+    };
+
+    template<typename Policy> bool parse(Lexer &lexer, Policy &policy, typename Policy::Value &result)
+    {
+        typedef ParseItem<typename Policy::Value> Item;
+
+        struct StateItem {
+            unsigned int state;
+            size_t parseStackStart;
+        };
+
+        std::vector<StateItem> stateStack;
+        std::vector<Item> parseStack;
+        unsigned int state = 0;
+
+        while(!kAcceptStates[state]) {
+            stateStack.push_back(StateItem{state, parseStack.size()});
+            const Token &token = lexer.nextToken();
+            unsigned int action = (token.value < kNumTerminals) ? kActions[state][token.value] : kActionError;
+            switch(action & 3) {
+                case kActionShift:
+                    parseStack.push_back(Item{Item::Type::Terminal, token.value, policy.terminal(token)});
+                    lexer.consumeToken();
+                    state = action >> 2;
+                    break;
+
+                case kActionReduce:
+                {
+                    const Reduction &reduction = kReductions[action >> 2];
+                    stateStack.resize(stateStack.size() - reduction.length);
+                    state = stateStack.back().state;
+                    size_t parseStackStart = stateStack.back().parseStackStart;
+
+                    if(policy.hasReducer(reduction.rule)) {
+                        typename Policy::Value data = policy.reduce(reduction.rule, parseStack.data() + parseStackStart, parseStack.data() + parseStack.size());
+                        parseStack.erase(parseStack.begin() + parseStackStart, parseStack.end());
+                        parseStack.push_back(Item{Item::Type::Nonterminal, reduction.rule, std::move(data)});
+                    }
+
+                    state = kGotos[state][reduction.rule];
+                    break;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        if(policy.hasReducer(kStartRule)) {
+            result = policy.reduce(kStartRule, parseStack.data(), parseStack.data() + parseStack.size());
+        }
+
+        return true;
+    }
+)";
+    }
+}
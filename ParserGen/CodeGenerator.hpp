@@ -0,0 +1,32 @@
+#ifndef PARSERGEN_CODE_GENERATOR_HPP
+#define PARSERGEN_CODE_GENERATOR_HPP
+
+#include "Parser/Tokenizer.hpp"
+#include "Parser/Grammar.hpp"
+#include "Parser/Impl/LRSingle.hpp"
+
+#include <ostream>
+#include <string>
+
+namespace ParserGen
+{
+    class CodeGenerator
+    {
+    public:
+        CodeGenerator(const Parser::Tokenizer &tokenizer, const Parser::Grammar &grammar, const Parser::Impl::LRSingle &parser);
+
+        void write(std::ostream &out, const std::string &name, const std::string &source) const;
+
+    private:
+        void writeSymbols(std::ostream &out) const;
+        void writeMatcher(std::ostream &out, unsigned int configuration) const;
+        void writeLexer(std::ostream &out) const;
+        void writeTables(std::ostream &out) const;
+        void writeParser(std::ostream &out) const;
+
+        const Parser::Tokenizer &mTokenizer;
+        const Parser::Grammar &mGrammar;
+        const Parser::Impl::LRSingle &mParser;
+    };
+}
+#endif
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LR1.hpp"
+#include "ParserGen/CodeGenerator.hpp"
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3) {
+        std::cout << "Usage: parsergen <grammar.def> <output.hpp> [namespace]" << std::endl;
+        return 1;
+    }
+
+    std::string name = (argc > 3) ? argv[3] : "Generated";
+
+    Parser::DefReader reader(argv[1]);
+    if(!reader.valid()) {
+        std::cout << "Error in def file, line " << reader.parseError().line << ": " << reader.parseError().message << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Parser::Impl::LRSingle> parser = std::make_unique<Parser::Impl::LALR>(reader.grammar());
+    if(!parser->valid()) {
+        parser = std::make_unique<Parser::Impl::LR1>(reader.grammar());
+    }
+
+    if(!parser->valid()) {
+        const Parser::Impl::LRSingle::Conflict &conflict = parser->conflict();
+        std::string symbol = (conflict.symbol < reader.grammar().terminals().size()) ? reader.grammar().terminals()[conflict.symbol] : std::to_string(conflict.symbol);
+        const char *type = (conflict.type == Parser::Impl::LRSingle::Conflict::Type::ShiftReduce) ? "Shift/reduce" : "Reduce/reduce";
+        std::cout << "Error: " << type << " conflict on symbol " << symbol << ", grammar is not LR(1)" << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(argv[2]);
+    if(!output) {
+        std::cout << "Error: Could not open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    ParserGen::CodeGenerator generator(reader.tokenizer(), reader.grammar(), *parser);
+    generator.write(output, name, argv[1]);
+
+    return 0;
+}
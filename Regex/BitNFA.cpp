@@ -0,0 +1,190 @@
+#include "BitNFA.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Regex {
+
+    static unsigned int firstSetBit(uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return (unsigned int)index;
+#else
+        return (unsigned int)__builtin_ctzll(mask);
+#endif
+    }
+
+    BitNFA::BitNFA(const NFA &nfa, const Encoding &encoding)
+    {
+        const std::vector<NFA::State> &states = nfa.states();
+
+        // Number the positions, and note which positions leave each NFA state.
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> positionMap;
+        std::vector<unsigned int> positionTargets;
+        std::vector<std::vector<unsigned int>> statePositions(states.size());
+        for(unsigned int i=0; i<states.size(); i++) {
+            for(const NFA::State::Transition &transition : states[i].transitions) {
+                auto result = positionMap.emplace(std::make_pair(i, transition.second), (unsigned int)positionTargets.size());
+                if(result.second) {
+                    positionTargets.push_back(transition.second);
+                    statePositions[i].push_back(result.first->second);
+                }
+            }
+        }
+
+        mNumPositions = (unsigned int)positionTargets.size();
+        mNumWords = std::max(1u, (mNumPositions + 63) / 64);
+        mNumChunks = mNumWords * 64 / kChunkBits;
+        if(mNumPositions > kMaxPositions) {
+            return;
+        }
+
+        std::vector<unsigned int> nfaAcceptPatterns(states.size(), UINT_MAX);
+        for(unsigned int i=0; i<nfa.acceptStates().size(); i++) {
+            unsigned int acceptState = nfa.acceptStates()[i];
+            nfaAcceptPatterns[acceptState] = std::min(nfaAcceptPatterns[acceptState], i);
+        }
+
+        // Sets the bits of every position leaving the epsilon closure of state, and returns the
+        // earliest pattern accepted in it.
+        std::vector<unsigned int> marks(states.size(), UINT_MAX);
+        std::vector<unsigned int> stack;
+        auto closeOver = [&](unsigned int state, unsigned int generation, uint64_t *mask) {
+            unsigned int acceptPattern = UINT_MAX;
+            marks[state] = generation;
+            stack.push_back(state);
+            while(stack.size() > 0) {
+                unsigned int current = stack.back();
+                stack.pop_back();
+                acceptPattern = std::min(acceptPattern, nfaAcceptPatterns[current]);
+                for(unsigned int position : statePositions[current]) {
+                    mask[position / 64] |= (uint64_t)1 << (position % 64);
+                }
+                for(unsigned int target : states[current].epsilonTransitions) {
+                    if(marks[target] != generation) {
+                        marks[target] = generation;
+                        stack.push_back(target);
+                    }
+                }
+            }
+            return acceptPattern;
+        };
+
+        mFirst.resize(mNumWords, 0);
+        closeOver(nfa.startState(), mNumPositions, mFirst.data());
+
+        std::vector<uint64_t> follow(mNumPositions * mNumWords, 0);
+        mAcceptMask.resize(mNumWords, 0);
+        mAcceptPatterns.resize(mNumPositions, UINT_MAX);
+        for(unsigned int i=0; i<mNumPositions; i++) {
+            mAcceptPatterns[i] = closeOver(positionTargets[i], i, &follow[i * mNumWords]);
+            if(mAcceptPatterns[i] != UINT_MAX) {
+                mAcceptMask[i / 64] |= (uint64_t)1 << (i % 64);
+            }
+        }
+
+        // A position is reachable on a byte if one of its transitions is on the byte's code point.
+        std::vector<std::vector<unsigned int>> codePointBytes(encoding.numCodePoints());
+        for(unsigned int i=0; i<256; i++) {
+            Encoding::CodePoint codePoint = encoding.codePoint((Encoding::InputSymbol)i);
+            if(codePoint != Encoding::kInvalidCodePoint) {
+                codePointBytes[codePoint].push_back(i);
+            }
+        }
+
+        mByteMasks.resize(256 * mNumWords, 0);
+        for(unsigned int i=0; i<states.size(); i++) {
+            for(const NFA::State::Transition &transition : states[i].transitions) {
+                unsigned int position = positionMap[std::make_pair(i, transition.second)];
+                for(unsigned int byte : codePointBytes[transition.first]) {
+                    mByteMasks[byte * mNumWords + position / 64] |= (uint64_t)1 << (position % 64);
+                }
+            }
+        }
+
+        // Follow sets are looked up a chunk of the active mask at a time.  Each entry adds the
+        // lowest bit of its value to the entry for the remaining bits.
+        mFollow.resize(mNumChunks * kChunkValues * mNumWords, 0);
+        for(unsigned int chunk=0; chunk<mNumChunks; chunk++) {
+            uint64_t *table = &mFollow[chunk * kChunkValues * mNumWords];
+            for(unsigned int value=1; value<kChunkValues; value++) {
+                unsigned int position = chunk * kChunkBits + firstSetBit(value);
+                const uint64_t *rest = &table[(value & (value - 1)) * mNumWords];
+                for(unsigned int w=0; w<mNumWords; w++) {
+                    table[value * mNumWords + w] = rest[w];
+                    if(position < mNumPositions) {
+                        table[value * mNumWords + w] |= follow[position * mNumWords + w];
+                    }
+                }
+            }
+        }
+    }
+
+    bool BitNFA::valid() const
+    {
+        return mNumPositions <= kMaxPositions;
+    }
+
+    unsigned int BitNFA::match(std::string_view string, unsigned int start, unsigned int &pattern) const
+    {
+        const unsigned char *data = (const unsigned char*)string.data();
+        uint64_t current[kMaxWords];
+        uint64_t next[kMaxWords];
+        unsigned int matched = 0;
+
+        for(size_t i=start; i<string.size(); i++) {
+            const uint64_t *byteMask = &mByteMasks[data[i] * mNumWords];
+            if(i == start) {
+                for(unsigned int w=0; w<mNumWords; w++) {
+                    next[w] = mFirst[w] & byteMask[w];
+                }
+            } else {
+                for(unsigned int w=0; w<mNumWords; w++) {
+                    next[w] = 0;
+                }
+                for(unsigned int chunk=0; chunk<mNumChunks; chunk++) {
+                    unsigned int value = (unsigned int)(current[chunk * kChunkBits / 64] >> (chunk * kChunkBits % 64)) & (kChunkValues - 1);
+                    if(value != 0) {
+                        const uint64_t *follow = &mFollow[(chunk * kChunkValues + value) * mNumWords];
+                        for(unsigned int w=0; w<mNumWords; w++) {
+                            next[w] |= follow[w];
+                        }
+                    }
+                }
+                for(unsigned int w=0; w<mNumWords; w++) {
+                    next[w] &= byteMask[w];
+                }
+            }
+
+            uint64_t active = 0;
+            unsigned int acceptPattern = UINT_MAX;
+            for(unsigned int w=0; w<mNumWords; w++) {
+                active |= next[w];
+                uint64_t accepting = next[w] & mAcceptMask[w];
+                while(accepting != 0) {
+                    acceptPattern = std::min(acceptPattern, mAcceptPatterns[w * 64 + firstSetBit(accepting)]);
+                    accepting &= accepting - 1;
+                }
+                current[w] = next[w];
+            }
+
+            if(active == 0) {
+                break;
+            }
+
+            if(acceptPattern != UINT_MAX) {
+                pattern = acceptPattern;
+                matched = (unsigned int)(i - start) + 1;
+            }
+        }
+
+        return matched;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef REGEX_BIT_NFA_HPP
+#define REGEX_BIT_NFA_HPP
+
+#include "NFA.hpp"
+#include "Encoding.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Regex {
+    // Simulates an NFA directly, holding the set of active states as a bitmask a few words wide.
+    // Each distinct pair of NFA states joined by symbol transitions becomes one bit, Glushkov style;
+    // after a character, the active bits are those whose transition was just taken.  A step is a
+    // handful of table lookups and word operations, however the NFA would have determinized.
+    class BitNFA {
+    public:
+        static const unsigned int kMaxWords = 4;
+        static const unsigned int kMaxPositions = kMaxWords * 64;
+
+        // NFAs with more than kMaxPositions positions leave the BitNFA invalid.
+        BitNFA(const NFA &nfa, const Encoding &encoding);
+
+        bool valid() const;
+
+        unsigned int match(std::string_view string, unsigned int start, unsigned int &pattern) const;
+
+    private:
+        static const unsigned int kChunkBits = 8;
+        static const unsigned int kChunkValues = 1 << kChunkBits;
+
+        unsigned int mNumPositions;
+        unsigned int mNumWords;
+        unsigned int mNumChunks;
+
+        std::vector<uint64_t> mFirst;
+        std::vector<uint64_t> mByteMasks;
+        std::vector<uint64_t> mFollow;
+        std::vector<uint64_t> mAcceptMask;
+        std::vector<unsigned int> mAcceptPatterns;
+    };
+}
+
+#endif
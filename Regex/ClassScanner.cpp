@@ -0,0 +1,103 @@
+#include "ClassScanner.hpp"
+
+#if defined(__AVX2__)
+#define REGEX_CLASS_SCANNER_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define REGEX_CLASS_SCANNER_SSE2
+#endif
+
+#if defined(REGEX_CLASS_SCANNER_AVX2) || defined(REGEX_CLASS_SCANNER_SSE2)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Regex {
+
+    static unsigned int firstSetBit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (unsigned int)index;
+#else
+        return (unsigned int)__builtin_ctz(mask);
+#endif
+    }
+
+    ClassScanner::ClassScanner(const ByteSet &bytes)
+    : mBytes(bytes)
+    {
+        for(unsigned int i=0; i<256; i++) {
+            if(!mBytes[i]) {
+                continue;
+            }
+
+            unsigned int end = i;
+            while(end + 1 < 256 && mBytes[end + 1]) {
+                end++;
+            }
+            mRanges.push_back(std::make_pair((unsigned char)i, (unsigned char)end));
+            i = end;
+        }
+
+        if(mRanges.size() > kMaxRanges) {
+            mRanges.clear();
+        }
+    }
+
+    unsigned int ClassScanner::skip(std::string_view string, unsigned int start) const
+    {
+        const unsigned char *data = (const unsigned char*)string.data();
+        size_t size = string.size();
+        size_t pos = start;
+
+#ifdef REGEX_CLASS_SCANNER_AVX2
+        if(mRanges.size() > 0) {
+            while(pos + 32 <= size) {
+                __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + pos));
+                __m256i in = _mm256_setzero_si256();
+                for(const auto &range : mRanges) {
+                    __m256i offset = _mm256_sub_epi8(chunk, _mm256_set1_epi8((char)range.first));
+                    __m256i width = _mm256_set1_epi8((char)(range.second - range.first));
+                    in = _mm256_or_si256(in, _mm256_cmpeq_epi8(_mm256_max_epu8(offset, width), width));
+                }
+
+                unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(in);
+                if(mask != 0) {
+                    return (unsigned int)(pos + firstSetBit(mask));
+                }
+                pos += 32;
+            }
+        }
+#endif
+
+#ifdef REGEX_CLASS_SCANNER_SSE2
+        if(mRanges.size() > 0) {
+            while(pos + 16 <= size) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)(data + pos));
+                __m128i in = _mm_setzero_si128();
+                for(const auto &range : mRanges) {
+                    __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8((char)range.first));
+                    __m128i width = _mm_set1_epi8((char)(range.second - range.first));
+                    in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_max_epu8(offset, width), width));
+                }
+
+                unsigned int mask = ~(unsigned int)_mm_movemask_epi8(in) & 0xffff;
+                if(mask != 0) {
+                    return (unsigned int)(pos + firstSetBit(mask));
+                }
+                pos += 16;
+            }
+        }
+#endif
+
+        while(pos < size && mBytes[data[pos]]) {
+            pos++;
+        }
+
+        return (unsigned int)pos;
+    }
+}
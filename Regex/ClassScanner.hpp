@@ -0,0 +1,26 @@
+#ifndef REGEX_CLASS_SCANNER_HPP
+#define REGEX_CLASS_SCANNER_HPP
+
+#include <bitset>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Regex {
+    class ClassScanner {
+    public:
+        typedef std::bitset<256> ByteSet;
+
+        ClassScanner(const ByteSet &bytes);
+
+        unsigned int skip(std::string_view string, unsigned int start) const;
+
+    private:
+        static const unsigned int kMaxRanges = 4;
+
+        ByteSet mBytes;
+        std::vector<std::pair<unsigned char, unsigned char>> mRanges;
+    };
+}
+
+#endif
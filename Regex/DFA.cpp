@@ -3,48 +3,124 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <unordered_map>
 
 namespace Regex {
-    DFA::DFA(const NFA &nfa, const Encoding &encoding)
+    // The epsilon closure of each NFA state on its own, as a sorted list.
+    static std::vector<std::vector<unsigned int>> epsilonClosures(const NFA &nfa)
     {
-        std::set<unsigned int> nfaStates;
-        nfaStates.insert(nfa.startState());
+        std::vector<std::vector<unsigned int>> closures(nfa.states().size());
+        std::vector<unsigned int> marks(nfa.states().size(), UINT_MAX);
+        std::vector<unsigned int> stack;
+
+        for(unsigned int i=0; i<closures.size(); i++) {
+            std::vector<unsigned int> &closure = closures[i];
+            marks[i] = i;
+            closure.push_back(i);
+            stack.push_back(i);
+            while(stack.size() > 0) {
+                unsigned int state = stack.back();
+                stack.pop_back();
+                for(unsigned int target : nfa.states()[state].epsilonTransitions) {
+                    if(marks[target] != i) {
+                        marks[target] = i;
+                        closure.push_back(target);
+                        stack.push_back(target);
+                    }
+                }
+            }
+            std::sort(closure.begin(), closure.end());
+        }
 
-        std::vector<StateSet> stateSets;
-        std::vector<State> states;
-        unsigned int startState = findOrAddState(stateSets, nfa, nfaStates);
+        return closures;
+    }
 
-        std::vector<std::set<unsigned int>> acceptSets;
-        acceptSets.resize(nfa.acceptStates().size());
-    
-        for(unsigned int i=0; i<stateSets.size(); i++) {
-            const StateSet &stateSet = stateSets[i];
-            State state;
+    size_t DFA::StateSetHash::operator()(const std::vector<unsigned int> &nfaStates) const
+    {
+        size_t hash = 14695981039346656037ULL;
+        for(unsigned int nfaState : nfaStates) {
+            hash = (hash ^ nfaState) * 1099511628211ULL;
+        }
+        return hash;
+    }
 
-            for(const auto &pair : stateSet.transitions) {
-                state.transitions[pair.first] = pair.second;
-            }
+    DFA::DFA(const NFA &nfa, const Encoding &encoding, unsigned int maxStates)
+    {
+        std::vector<std::vector<unsigned int>> closures = epsilonClosures(nfa);
+
+        // An NFA state can only complete one pattern; where a DFA state holds several, the earliest
+        // pattern wins.
+        std::vector<unsigned int> nfaAcceptStates(nfa.states().size(), UINT_MAX);
+        for(unsigned int i=0; i<nfa.acceptStates().size(); i++) {
+            unsigned int acceptState = nfa.acceptStates()[i];
+            nfaAcceptStates[acceptState] = std::min(nfaAcceptStates[acceptState], i);
+        }
+
+        // Subset construction, with each DFA state's NFA state set kept as a sorted list and looked
+        // up by hash.  States are numbered in the order they are found, and processed in that order.
+        std::unordered_map<std::vector<unsigned int>, unsigned int, StateSetHash> stateMap;
+        std::vector<const std::vector<unsigned int>*> stateSets;
+        std::vector<State> states;
+        std::vector<unsigned int> acceptStates;
+        bool abandoned = false;
+
+        auto findOrAddState = [&](std::vector<unsigned int> nfaStates) {
+            auto result = stateMap.emplace(std::move(nfaStates), (unsigned int)stateSets.size());
+            if(result.second) {
+                if(stateSets.size() >= maxStates) {
+                    abandoned = true;
+                    return UINT_MAX;
+                }
 
-            for(unsigned int j=0; j<nfa.acceptStates().size(); j++) { 
-                if(stateSet.nfaStates.find(nfa.acceptStates()[j]) != stateSet.nfaStates.end()) {
-                    acceptSets[j].insert(i);
+                unsigned int acceptState = UINT_MAX;
+                for(unsigned int nfaState : result.first->first) {
+                    acceptState = std::min(acceptState, nfaAcceptStates[nfaState]);
                 }
+                stateSets.push_back(&result.first->first);
+                states.push_back(State());
+                acceptStates.push_back(acceptState);
+            }
+            return result.first->second;
+        };
+
+        unsigned int startState = findOrAddState(closures[nfa.startState()]);
+
+        std::vector<NFA::State::Transition> transitions;
+        std::vector<unsigned int> marks(nfa.states().size(), UINT_MAX);
+        unsigned int generation = 0;
+        for(unsigned int i=0; i<stateSets.size() && !abandoned; i++) {
+            transitions.clear();
+            for(unsigned int nfaState : *stateSets[i]) {
+                const auto &nfaTransitions = nfa.states()[nfaState].transitions;
+                transitions.insert(transitions.end(), nfaTransitions.begin(), nfaTransitions.end());
             }
+            std::sort(transitions.begin(), transitions.end());
+
+            for(unsigned int j=0; j<transitions.size() && !abandoned;) {
+                NFA::Symbol symbol = transitions[j].first;
+                std::vector<unsigned int> nfaStates;
+                generation++;
+                for(; j<transitions.size() && transitions[j].first == symbol; j++) {
+                    for(unsigned int target : closures[transitions[j].second]) {
+                        if(marks[target] != generation) {
+                            marks[target] = generation;
+                            nfaStates.push_back(target);
+                        }
+                    }
+                }
+                std::sort(nfaStates.begin(), nfaStates.end());
 
-            states.push_back(std::move(state));
+                unsigned int target = findOrAddState(std::move(nfaStates));
+                states[i].transitions[(Symbol)symbol] = target;
+            }
         }
 
-        std::vector<unsigned int> acceptStates;
-        acceptStates.resize(states.size());
-        for(unsigned int i=0; i<acceptStates.size(); i++) {
-            const State &state = states[i];
-            acceptStates[i] = UINT_MAX;
-            for(unsigned int j=0; j<acceptSets.size(); j++) {
-                if(acceptSets[j].count(i) > 0) {
-                    acceptStates[i] = j;
-                    break;
-                }
-            }
+        if(abandoned) {
+            mNumCodePoints = encoding.numCodePoints();
+            mNumStates = 0;
+            mStartState = 0;
+            mRejectState = 0;
+            return;
         }
 
         minimize(states, startState, acceptStates);
@@ -56,6 +132,7 @@ namespace Regex {
         mRejectState = mNumStates - 1;
         mTransitions.resize(mNumStates, mNumCodePoints);
         mAcceptStates = std::move(acceptStates);
+        mAcceptStates.push_back(UINT_MAX);
 
         for(unsigned int i=0; i<mNumStates; i++) {
             const State &state = states[i];
@@ -71,6 +148,52 @@ namespace Regex {
         }
     }
 
+    DFA::DFA(Util::BinaryReader &reader)
+    {
+        reader.expect(Util::binaryTag("DFA "));
+        reader.read(mNumCodePoints);
+        reader.read(mNumStates);
+        reader.read(mStartState);
+        reader.read(mRejectState);
+        mTransitions.load(reader);
+        reader.read(mAcceptStates);
+        if(mAcceptStates.size() != mNumStates || mStartState >= mNumStates || mRejectState >= mNumStates ||
+           mTransitions.width() != mNumStates || mTransitions.height() != mNumCodePoints) {
+            reader.invalidate();
+            return;
+        }
+
+        for(unsigned int i=0; i<mNumStates; i++) {
+            for(unsigned int j=0; j<mNumCodePoints; j++) {
+                if(mTransitions.at(i, j) >= mNumStates) {
+                    reader.invalidate();
+                    return;
+                }
+            }
+        }
+    }
+
+    void DFA::save(Util::BinaryWriter &writer) const
+    {
+        writer.write(Util::binaryTag("DFA "));
+        writer.write(mNumCodePoints);
+        writer.write(mNumStates);
+        writer.write(mStartState);
+        writer.write(mRejectState);
+        mTransitions.save(writer);
+        writer.write(mAcceptStates);
+    }
+
+    unsigned int DFA::numStates() const
+    {
+        return mNumStates;
+    }
+
+    unsigned int DFA::numCodePoints() const
+    {
+        return mNumCodePoints;
+    }
+
     unsigned int DFA::startState() const
     {
         return mStartState;
@@ -119,146 +242,189 @@ namespace Regex {
         }
     }
 
-    unsigned int DFA::findOrAddState(std::vector<StateSet> &stateSets, const NFA &nfa, const std::set<unsigned int> &nfaStates)
+    void DFA::minimize(std::vector<State> &states, unsigned int &startState, std::vector<unsigned int> &acceptStates)
     {
-        std::set<unsigned int> epsilonClosure;
-        std::vector<unsigned int> queue;
-        queue.insert(queue.end(), nfaStates.begin(), nfaStates.end());
-        while(queue.size() > 0) {
-            unsigned int state = queue.front();
-            queue.erase(queue.begin());
-            if(epsilonClosure.find(state) == epsilonClosure.end()) {
-                epsilonClosure.insert(state);
-                const auto &transitions = nfa.states()[state].epsilonTransitions;
-                queue.insert(queue.end(), transitions.cbegin(), transitions.cend());
+        // Hopcroft's partition refinement.  Missing transitions are sent to an extra dead state so
+        // that the automaton is complete; states which end up alongside it can never accept, and
+        // transitions into them are dropped again afterwards.
+        unsigned int numStates = (unsigned int)states.size() + 1;
+        unsigned int deadState = numStates - 1;
+
+        std::vector<Symbol> alphabet;
+        for(const auto &state : states) {
+            for(const auto &transition : state.transitions) {
+                alphabet.push_back(transition.first);
             }
         }
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+        unsigned int numSymbols = (unsigned int)alphabet.size();
 
-        for(unsigned int i=0; i<stateSets.size(); i++) {
-            if(stateSets[i].nfaStates == epsilonClosure) {
-                return i;
+        std::vector<unsigned int> transitions(numStates * numSymbols, deadState);
+        for(unsigned int i=0; i<states.size(); i++) {
+            for(const auto &transition : states[i].transitions) {
+                unsigned int symbol = (unsigned int)(std::lower_bound(alphabet.begin(), alphabet.end(), transition.first) - alphabet.begin());
+                transitions[i * numSymbols + symbol] = transition.second;
             }
         }
 
-        std::map<Symbol, std::set<unsigned int>> transitions;
-        for(unsigned int state : epsilonClosure) {
-            for(const NFA::State::Transition &transition : nfa.states()[state].transitions) {
-                transitions[transition.first].insert(transition.second);
+        // Inverse transitions, grouped by symbol and then by target state.
+        std::vector<unsigned int> inverseStart(numSymbols * numStates + 1, 0);
+        for(unsigned int i=0; i<numStates; i++) {
+            for(unsigned int c=0; c<numSymbols; c++) {
+                inverseStart[c * numStates + transitions[i * numSymbols + c] + 1]++;
             }
         }
-        
-        stateSets.push_back(StateSet());
-        unsigned int idx = (unsigned int)(stateSets.size() - 1);
-        stateSets[idx].nfaStates = epsilonClosure;
-        
-        for(const auto &pair : transitions) {
-            stateSets[idx].transitions[pair.first] = findOrAddState(stateSets, nfa, pair.second);
+        for(unsigned int i=1; i<inverseStart.size(); i++) {
+            inverseStart[i] += inverseStart[i - 1];
         }
-
-        return idx;
-    }
-
-    void DFA::minimize(std::vector<State> &states, unsigned int &startState, std::vector<unsigned int> &acceptStates)
-    {
-        std::set<Symbol> alphabet;
-
-        for(const auto &state : states) {
-            for(const auto &transition : state.transitions) {
-                alphabet.insert(transition.first);
+        std::vector<unsigned int> inverse(numStates * numSymbols);
+        std::vector<unsigned int> inverseFill(inverseStart.begin(), inverseStart.end() - 1);
+        for(unsigned int i=0; i<numStates; i++) {
+            for(unsigned int c=0; c<numSymbols; c++) {
+                inverse[inverseFill[c * numStates + transitions[i * numSymbols + c]]++] = i;
             }
         }
 
-        std::map<unsigned int, std::set<unsigned int>> acceptSets;
-
-        for(unsigned int i=0; i<acceptStates.size(); i++) {
-            acceptSets[acceptStates[i]].insert(i);
+        // Blocks are contiguous ranges of elements; position is the inverse of elements.  The first
+        // marked[b] elements of block b are those marked by the current splitter.
+        std::vector<unsigned int> elements(numStates);
+        std::vector<unsigned int> position(numStates);
+        std::vector<unsigned int> blockOf(numStates);
+        std::vector<unsigned int> blockStart;
+        std::vector<unsigned int> blockEnd;
+        std::vector<unsigned int> marked;
+        std::vector<bool> pending;
+
+        // The initial partition groups states by the pattern they accept.
+        auto acceptOf = [&](unsigned int state) {
+            return (state == deadState) ? UINT_MAX : acceptStates[state];
+        };
+        for(unsigned int i=0; i<numStates; i++) {
+            elements[i] = i;
         }
-
-        std::vector<std::set<unsigned int>> partition;
-        for(auto &pair : acceptSets) {
-            partition.push_back(std::move(pair.second));
+        std::stable_sort(elements.begin(), elements.end(), [&](unsigned int a, unsigned int b) {
+            return acceptOf(a) < acceptOf(b);
+        });
+        for(unsigned int i=0; i<numStates; i++) {
+            if(i == 0 || acceptOf(elements[i]) != acceptOf(elements[i - 1])) {
+                if(i > 0) {
+                    blockEnd.push_back(i);
+                }
+                blockStart.push_back(i);
+            }
+            blockOf[elements[i]] = (unsigned int)(blockStart.size() - 1);
+            position[elements[i]] = i;
         }
+        blockEnd.push_back(numStates);
+        marked.resize(blockStart.size(), 0);
+        pending.resize(blockStart.size(), false);
 
+        // Every block but the largest starts out as a splitter.
         std::vector<unsigned int> queue;
-        for(unsigned int i = 0; i<acceptStates.size(); i++) {
-            queue.push_back(i);
+        unsigned int largest = 0;
+        for(unsigned int b=1; b<blockStart.size(); b++) {
+            if(blockEnd[b] - blockStart[b] > blockEnd[largest] - blockStart[largest]) {
+                largest = b;
+            }
+        }
+        for(unsigned int b=0; b<blockStart.size(); b++) {
+            if(b != largest) {
+                queue.push_back(b);
+                pending[b] = true;
+            }
         }
 
+        std::vector<unsigned int> splitter;
+        std::vector<unsigned int> touched;
         while(queue.size() > 0) {
-            std::set<unsigned int> distinguisher = partition[queue.front()];
-            queue.erase(queue.begin());
-
-            for(Symbol c : alphabet) {
-                std::set<unsigned int> inbound;
-                for(unsigned int i=0; i<states.size(); i++) {
-                    const auto &state = states[i];
-                    const auto it = state.transitions.find(c);
-                    if(it != state.transitions.end() && distinguisher.count(it->second)) {
-                        inbound.insert(i);
-                    }
-                }
+            unsigned int s = queue.back();
+            queue.pop_back();
+            pending[s] = false;
+            splitter.assign(elements.begin() + blockStart[s], elements.begin() + blockEnd[s]);
+
+            for(unsigned int c=0; c<numSymbols; c++) {
+                for(unsigned int target : splitter) {
+                    unsigned int begin = inverseStart[c * numStates + target];
+                    unsigned int end = inverseStart[c * numStates + target + 1];
+                    for(unsigned int i=begin; i<end; i++) {
+                        unsigned int state = inverse[i];
+                        unsigned int b = blockOf[state];
+                        unsigned int to = blockStart[b] + marked[b];
+                        if(position[state] < to) {
+                            continue;
+                        }
 
-                if(inbound.size() == 0) {
-                    continue;
+                        unsigned int other = elements[to];
+                        elements[to] = state;
+                        elements[position[state]] = other;
+                        position[other] = position[state];
+                        position[state] = to;
+                        if(marked[b] == 0) {
+                            touched.push_back(b);
+                        }
+                        marked[b]++;
+                    }
                 }
 
-                for(unsigned int i=0; i<partition.size(); i++) {
-                    std::set<unsigned int> in;
-                    std::set<unsigned int> out;
+                for(unsigned int b : touched) {
+                    unsigned int split = blockStart[b] + marked[b];
+                    marked[b] = 0;
+                    if(split == blockEnd[b]) {
+                        continue;
+                    }
 
-                    for(int s : partition[i]) {
-                        if(inbound.count(s)) {
-                            in.insert(s);
-                        } else {
-                            out.insert(s);
-                        }
+                    // The marked elements move to a new block.
+                    unsigned int n = (unsigned int)blockStart.size();
+                    blockStart.push_back(blockStart[b]);
+                    blockEnd.push_back(split);
+                    marked.push_back(0);
+                    pending.push_back(false);
+                    blockStart[b] = split;
+                    for(unsigned int i=blockStart[n]; i<blockEnd[n]; i++) {
+                        blockOf[elements[i]] = n;
                     }
 
-                    if(in.size() > 0 && out.size() > 0) {
-                        partition[i] = in;
-                        partition.push_back(out);
-                        unsigned int o = (unsigned int)(partition.size() - 1);
-
-                        auto it = std::find(queue.begin(), queue.end(), i);
-                        if(it == queue.end()) {
-                            if(in.size() > out.size()) {
-                                queue.push_back(o);
-                            } else {
-                                queue.push_back(i);
-                            }
-                        } else {
-                            queue.push_back(o);
-                        }
+                    unsigned int add = n;
+                    if(!pending[b] && blockEnd[b] - blockStart[b] < blockEnd[n] - blockStart[n]) {
+                        add = b;
                     }
+                    queue.push_back(add);
+                    pending[add] = true;
                 }
-            }       
+                touched.clear();
+            }
         }
 
-        std::map<unsigned int, unsigned int> stateMap;
-        for(unsigned int i=0; i<partition.size(); i++) {
-            for(unsigned int j : partition[i]) {
-                stateMap[j] = i;
+        // Number the blocks in order of their first state, leaving out the dead block unless the
+        // start state is in it.
+        unsigned int deadBlock = blockOf[deadState];
+        bool keepDead = blockOf[startState] == deadBlock;
+        std::vector<unsigned int> blockMap(blockStart.size(), UINT_MAX);
+        std::vector<unsigned int> representatives;
+        for(unsigned int i=0; i<states.size(); i++) {
+            unsigned int b = blockOf[i];
+            if(blockMap[b] == UINT_MAX && (b != deadBlock || keepDead)) {
+                blockMap[b] = (unsigned int)representatives.size();
+                representatives.push_back(i);
             }
         }
 
-        std::vector<State> newStates;
-        for(unsigned int i=0; i<partition.size(); i++) {
-            State newState;
-            int s = *partition[i].begin();
+        std::vector<State> newStates(representatives.size());
+        std::vector<unsigned int> newAcceptStates(representatives.size());
+        for(unsigned int i=0; i<representatives.size(); i++) {
+            unsigned int s = representatives[i];
             for(const auto &transition : states[s].transitions) {
-                newState.transitions[transition.first] = stateMap[transition.second];
+                unsigned int b = blockOf[transition.second];
+                if(b != deadBlock) {
+                    newStates[i].transitions[transition.first] = blockMap[b];
+                }
             }
-            newStates.push_back(std::move(newState));
-        }
-        unsigned int newStartState = stateMap[startState];
-        std::vector<unsigned int> newAcceptStates;
-        newAcceptStates.resize(newStates.size());
-        for(unsigned int i=0; i<states.size(); i++) {
-            newAcceptStates[stateMap[i]] = acceptStates[i];
+            newAcceptStates[i] = acceptStates[s];
         }
 
+        startState = blockMap[blockOf[startState]];
         states = std::move(newStates);
-        startState = newStartState;
         acceptStates = std::move(newAcceptStates);
     }
 }
\ No newline at end of file
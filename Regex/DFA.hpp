@@ -5,16 +5,24 @@
 #include "Encoding.hpp"
 #include "Util/Table.hpp"
 
+#include <climits>
 #include <map>
-#include <set>
+#include <vector>
 
 namespace Regex {
     class DFA {
     public:
         typedef int Symbol;
 
-        DFA(const NFA &nfa, const Encoding &encoding);
+        // Construction is abandoned once subset construction passes maxStates states, leaving a DFA
+        // with no states at all.
+        DFA(const NFA &nfa, const Encoding &encoding, unsigned int maxStates = UINT_MAX);
+        DFA(Util::BinaryReader &reader);
 
+        void save(Util::BinaryWriter &writer) const;
+
+        unsigned int numStates() const;
+        unsigned int numCodePoints() const;
         unsigned int startState() const;
         unsigned int rejectState() const;
 
@@ -28,12 +36,10 @@ namespace Regex {
             std::map<Symbol, unsigned int> transitions;
         };
 
-        struct StateSet {
-            std::set<unsigned int> nfaStates;
-            std::map<DFA::Symbol, unsigned int> transitions;
+        struct StateSetHash {
+            size_t operator()(const std::vector<unsigned int> &nfaStates) const;
         };
 
-        unsigned int findOrAddState(std::vector<StateSet> &stateSets, const NFA &nfa, const std::set<unsigned int> &nfaStates);
         void minimize(std::vector<State> &states, unsigned int &startState, std::vector<unsigned int> &acceptStates);
 
         unsigned int mNumCodePoints;
@@ -72,36 +72,25 @@ namespace Regex {
             visitNode(*node, inputSymbolRanges);
         }
 
-        auto cmp = [](const InputSymbolRange &a, const InputSymbolRange &b) { return a.first < b.first; };
-        std::sort(inputSymbolRanges.begin(), inputSymbolRanges.end(), cmp);
-        InputSymbolRange current = inputSymbolRanges.front();
-        inputSymbolRanges.erase(inputSymbolRanges.begin());
-        while(inputSymbolRanges.size() > 0) {
-            InputSymbolRange next = inputSymbolRanges.front();
-            inputSymbolRanges.erase(inputSymbolRanges.begin());
-
-            if(current.second < next.first) {
-                mInputSymbolRanges.push_back(current);
-                current = next;
-                continue;
-            }
-    
-            if(next.first > current.first) {
-                InputSymbolRange head(current.first, next.first - 1);
-                mInputSymbolRanges.push_back(head);
-                current.first = next.first;
-            }
+        // Every range start and every point just past a range end is a boundary between code points.
+        // Sweeping the sorted boundaries while counting how many ranges are open splits the ranges in
+        // a single pass; stretches which no range covers are not given a code point.
+        std::vector<std::pair<int, int>> boundaries;
+        boundaries.reserve(inputSymbolRanges.size() * 2);
+        for(const auto &range : inputSymbolRanges) {
+            boundaries.push_back(std::make_pair((int)range.first, 1));
+            boundaries.push_back(std::make_pair((int)range.second + 1, -1));
+        }
+        std::sort(boundaries.begin(), boundaries.end());
 
-            if(current.second != next.second) {
-                InputSymbolRange rest(std::min(current.second, next.second) + 1, std::max(current.second, next.second));
-                auto it = std::upper_bound(inputSymbolRanges.begin(), inputSymbolRanges.end(), rest, cmp);
-                inputSymbolRanges.insert(it, rest);
+        int open = 0;
+        for(size_t i=0; i<boundaries.size(); i++) {
+            open += boundaries[i].second;
+            if(open > 0 && boundaries[i + 1].first > boundaries[i].first) {
+                mInputSymbolRanges.push_back(InputSymbolRange((InputSymbol)boundaries[i].first, (InputSymbol)(boundaries[i + 1].first - 1)));
             }
-
-            current.second = std::min(current.second, next.second);
         }
 
-        mInputSymbolRanges.push_back(current);
         mTotalRange.first = mInputSymbolRanges[0].first;
         mTotalRange.second = mInputSymbolRanges[mInputSymbolRanges.size() - 1].second;
 
@@ -114,6 +103,45 @@ namespace Regex {
         }
     }
 
+    Encoding::Encoding(Util::BinaryReader &reader)
+    {
+        reader.expect(Util::binaryTag("ENC "));
+        std::vector<InputSymbol> bounds;
+        reader.read(bounds);
+        for(unsigned int i=0; i+1<bounds.size(); i+=2) {
+            mInputSymbolRanges.push_back(InputSymbolRange(bounds[i], bounds[i + 1]));
+        }
+        reader.read(mTotalRange.first);
+        reader.read(mTotalRange.second);
+        reader.read(mSymbolMap);
+        if(bounds.size() % 2 != 0 || mInputSymbolRanges.size() == 0 || mTotalRange.first > mTotalRange.second ||
+           mSymbolMap.size() != (size_t)(mTotalRange.second - mTotalRange.first + 1)) {
+            reader.invalidate();
+            return;
+        }
+
+        for(CodePoint codePoint : mSymbolMap) {
+            if(codePoint != kInvalidCodePoint && codePoint >= mInputSymbolRanges.size()) {
+                reader.invalidate();
+                return;
+            }
+        }
+    }
+
+    void Encoding::save(Util::BinaryWriter &writer) const
+    {
+        writer.write(Util::binaryTag("ENC "));
+        std::vector<InputSymbol> bounds;
+        for(const auto &range : mInputSymbolRanges) {
+            bounds.push_back(range.first);
+            bounds.push_back(range.second);
+        }
+        writer.write(bounds);
+        writer.write(mTotalRange.first);
+        writer.write(mTotalRange.second);
+        writer.write(mSymbolMap);
+    }
+
     std::vector<Encoding::CodePoint> Encoding::codePointRanges(InputSymbolRange inputSymbolRange) const
     {
         std::vector<Encoding::CodePoint> codePoints;
@@ -2,7 +2,9 @@
 #define REGEX_ENCODING_HPP
 
 #include "Parser.hpp"
+#include "Util/Binary.hpp"
 
+#include <climits>
 #include <tuple>
 #include <vector>
 #include <map>
@@ -14,11 +16,14 @@ namespace Regex {
     public:
         typedef char InputSymbol;
         typedef unsigned int CodePoint;
-        static const CodePoint kInvalidCodePoint = UINT_MAX;
+        static constexpr CodePoint kInvalidCodePoint = UINT_MAX;
 
         typedef std::pair<InputSymbol, InputSymbol> InputSymbolRange;
 
         Encoding(const std::vector<std::unique_ptr<Parser::Node>> &nodes);
+        Encoding(Util::BinaryReader &reader);
+
+        void save(Util::BinaryWriter &writer) const;
 
         std::vector<CodePoint> codePointRanges(InputSymbolRange range) const;
         CodePoint codePoint(InputSymbol symbol) const;
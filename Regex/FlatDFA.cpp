@@ -0,0 +1,74 @@
+#include "FlatDFA.hpp"
+
+#include <climits>
+
+namespace Regex {
+    FlatDFA::FlatDFA(const DFA &dfa, const Encoding &encoding)
+    {
+        unsigned int numStates = dfa.numStates();
+
+        std::vector<unsigned int> rows(numStates);
+        rows[dfa.rejectState()] = 0;
+        unsigned int row = 1;
+        for(unsigned int i=0; i<numStates; i++) {
+            if(i != dfa.rejectState()) {
+                rows[i] = row++;
+            }
+        }
+
+        auto entry = [&](unsigned int state) {
+            unsigned int index;
+            unsigned int value = rows[state] * kNumColumns;
+            if(dfa.accept(state, index)) {
+                value |= kAcceptFlag;
+            }
+            return value;
+        };
+
+        mTable.resize(numStates * kNumColumns, 0);
+        mAcceptPatterns.resize(numStates, UINT_MAX);
+        for(unsigned int i=0; i<numStates; i++) {
+            unsigned int base = rows[i] * kNumColumns;
+            for(unsigned int j=0; j<kNumColumns; j++) {
+                Encoding::CodePoint codePoint = encoding.codePoint((Encoding::InputSymbol)j);
+                if(codePoint != Encoding::kInvalidCodePoint) {
+                    mTable[base + j] = entry(dfa.transition(i, codePoint));
+                }
+            }
+
+            unsigned int index;
+            if(dfa.accept(i, index)) {
+                mAcceptPatterns[rows[i]] = index;
+            }
+        }
+
+        mStartState = entry(dfa.startState());
+    }
+
+    unsigned int FlatDFA::match(std::string_view string, unsigned int start, unsigned int &pattern) const
+    {
+        const unsigned int *table = mTable.data();
+        const unsigned char *data = (const unsigned char*)string.data();
+        unsigned int state = mStartState;
+        unsigned int acceptState = 0;
+        unsigned int matched = 0;
+
+        for(size_t i=start; i<string.size(); i++) {
+            state = table[(state & kRowMask) + data[i]];
+            if(state < kNumColumns) {
+                break;
+            }
+
+            if(state & kAcceptFlag) {
+                acceptState = state;
+                matched = (unsigned int)(i - start) + 1;
+            }
+        }
+
+        if(matched > 0) {
+            pattern = mAcceptPatterns[acceptState / kNumColumns];
+        }
+
+        return matched;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef REGEX_FLAT_DFA_HPP
+#define REGEX_FLAT_DFA_HPP
+
+#include "DFA.hpp"
+#include "Encoding.hpp"
+
+#include <vector>
+#include <string_view>
+
+namespace Regex {
+    class FlatDFA {
+    public:
+        static const unsigned int kMaxStates = 4096;
+
+        FlatDFA(const DFA &dfa, const Encoding &encoding);
+
+        unsigned int match(std::string_view string, unsigned int start, unsigned int &pattern) const;
+
+    private:
+        static const unsigned int kNumColumns = 256;
+        static const unsigned int kAcceptFlag = 1;
+        static const unsigned int kRowMask = ~(kNumColumns - 1);
+
+        std::vector<unsigned int> mTable;
+        std::vector<unsigned int> mAcceptPatterns;
+        unsigned int mStartState;
+    };
+}
+
+#endif
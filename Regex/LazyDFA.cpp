@@ -0,0 +1,200 @@
+#include "LazyDFA.hpp"
+
+#include <algorithm>
+
+namespace Regex {
+    LazyDFA::LazyDFA(NFA nfa, const Encoding &encoding, size_t cacheBytes)
+    : mNFA(std::move(nfa)), mEncoding(encoding), mCacheBytes(cacheBytes), mLifetime(std::make_shared<const char>(0))
+    {
+        mNumCodePoints = encoding.numCodePoints();
+
+        // An NFA state can only complete one pattern; where a DFA state holds several, the earliest
+        // pattern wins, as it does in the eager DFA.
+        mAcceptPatterns.resize(mNFA.states().size(), UINT_MAX);
+        for(unsigned int i=0; i<mNFA.acceptStates().size(); i++) {
+            unsigned int acceptState = mNFA.acceptStates()[i];
+            mAcceptPatterns[acceptState] = std::min(mAcceptPatterns[acceptState], i);
+        }
+    }
+
+    unsigned int LazyDFA::match(std::string_view string, unsigned int start, unsigned int &pattern) const
+    {
+        Cache &cache = threadCache();
+        unsigned int state = 0;
+        unsigned int matched = 0;
+
+        for(unsigned int i=start; i<string.size(); i++) {
+            Encoding::CodePoint codePoint = mEncoding.codePoint(string[i]);
+            if(codePoint == Encoding::kInvalidCodePoint) {
+                break;
+            }
+
+            unsigned int nextState = cache.transitions[state * mNumCodePoints + codePoint];
+            if(nextState == kUnknown) {
+                nextState = computeTransition(cache, state, codePoint);
+            }
+
+            if(nextState == kReject) {
+                break;
+            }
+
+            if(cache.acceptPatterns[nextState] != UINT_MAX) {
+                pattern = cache.acceptPatterns[nextState];
+                matched = (i - start) + 1;
+            }
+            state = nextState;
+        }
+
+        return matched;
+    }
+
+    size_t LazyDFA::StateSetHash::operator()(const std::vector<unsigned int> &nfaStates) const
+    {
+        size_t hash = 14695981039346656037ULL;
+        for(unsigned int nfaState : nfaStates) {
+            hash = (hash ^ nfaState) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    LazyDFA::Cache &LazyDFA::threadCache() const
+    {
+        struct Entry {
+            std::weak_ptr<const char> lifetime;
+            std::unique_ptr<Cache> cache;
+        };
+        thread_local std::unordered_map<const LazyDFA*, Entry> entries;
+
+        auto it = entries.find(this);
+        if(it != entries.end() && !it->second.lifetime.expired()) {
+            return *it->second.cache;
+        }
+
+        // Caches of DFAs which have been destroyed are only found here, so they are dropped whenever
+        // a new one is made.
+        for(auto entry = entries.begin(); entry != entries.end(); ) {
+            if(entry->second.lifetime.expired()) {
+                entry = entries.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+
+        std::unique_ptr<Cache> cache = std::make_unique<Cache>();
+        cache->marks.resize(mNFA.states().size(), 0);
+        cache->generation = 0;
+        flush(*cache);
+
+        Entry &entry = entries[this];
+        entry.lifetime = mLifetime;
+        entry.cache = std::move(cache);
+        return *entry.cache;
+    }
+
+    void LazyDFA::flush(Cache &cache) const
+    {
+        cache.transitions.clear();
+        cache.acceptPatterns.clear();
+        cache.nfaStates.clear();
+        cache.stateMap.clear();
+        cache.bytes = 0;
+
+        // The start state is always state 0.
+        nextGeneration(cache);
+        std::vector<unsigned int> nfaStates;
+        nfaStates.push_back(mNFA.startState());
+        cache.marks[mNFA.startState()] = cache.generation;
+        closeOver(cache, nfaStates);
+        addState(cache, std::move(nfaStates));
+    }
+
+    unsigned int LazyDFA::addState(Cache &cache, std::vector<unsigned int> nfaStates) const
+    {
+        unsigned int state = (unsigned int)cache.nfaStates.size();
+        size_t size = nfaStates.size();
+        auto result = cache.stateMap.emplace(std::move(nfaStates), state);
+        if(!result.second) {
+            return result.first->second;
+        }
+
+        unsigned int acceptPattern = UINT_MAX;
+        for(unsigned int nfaState : result.first->first) {
+            acceptPattern = std::min(acceptPattern, mAcceptPatterns[nfaState]);
+        }
+
+        cache.nfaStates.push_back(&result.first->first);
+        cache.acceptPatterns.push_back(acceptPattern);
+        cache.transitions.resize(cache.transitions.size() + mNumCodePoints, kUnknown);
+
+        // A row of transitions, the NFA state set and a rough allowance for the hash table entry.
+        cache.bytes += (mNumCodePoints + size) * sizeof(unsigned int) + 64;
+        return state;
+    }
+
+    unsigned int LazyDFA::computeTransition(Cache &cache, unsigned int state, Encoding::CodePoint codePoint) const
+    {
+        nextGeneration(cache);
+        std::vector<unsigned int> nfaStates;
+        for(unsigned int nfaState : *cache.nfaStates[state]) {
+            for(const NFA::State::Transition &transition : mNFA.states()[nfaState].transitions) {
+                if(transition.first == codePoint && cache.marks[transition.second] != cache.generation) {
+                    cache.marks[transition.second] = cache.generation;
+                    nfaStates.push_back(transition.second);
+                }
+            }
+        }
+
+        unsigned int &entry = cache.transitions[state * mNumCodePoints + codePoint];
+        if(nfaStates.size() == 0) {
+            entry = kReject;
+            return kReject;
+        }
+
+        closeOver(cache, nfaStates);
+        auto it = cache.stateMap.find(nfaStates);
+        if(it != cache.stateMap.end()) {
+            entry = it->second;
+            return entry;
+        }
+
+        // Flushing discards the current state along with everything else, so the transition into the
+        // new state is not recorded; the match carries on from the new state regardless.
+        size_t bytes = (mNumCodePoints + nfaStates.size()) * sizeof(unsigned int) + 64;
+        if(cache.bytes + bytes > mCacheBytes) {
+            flush(cache);
+            return addState(cache, std::move(nfaStates));
+        }
+
+        unsigned int nextState = addState(cache, std::move(nfaStates));
+        cache.transitions[state * mNumCodePoints + codePoint] = nextState;
+        return nextState;
+    }
+
+    void LazyDFA::closeOver(Cache &cache, std::vector<unsigned int> &nfaStates) const
+    {
+        // Every state already in nfaStates is marked with the current generation.
+        cache.stack.assign(nfaStates.begin(), nfaStates.end());
+        while(cache.stack.size() > 0) {
+            unsigned int nfaState = cache.stack.back();
+            cache.stack.pop_back();
+            for(unsigned int target : mNFA.states()[nfaState].epsilonTransitions) {
+                if(cache.marks[target] != cache.generation) {
+                    cache.marks[target] = cache.generation;
+                    nfaStates.push_back(target);
+                    cache.stack.push_back(target);
+                }
+            }
+        }
+
+        std::sort(nfaStates.begin(), nfaStates.end());
+    }
+
+    void LazyDFA::nextGeneration(Cache &cache) const
+    {
+        cache.generation++;
+        if(cache.generation == 0) {
+            std::fill(cache.marks.begin(), cache.marks.end(), 0);
+            cache.generation = 1;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef REGEX_LAZY_DFA_HPP
+#define REGEX_LAZY_DFA_HPP
+
+#include "NFA.hpp"
+#include "Encoding.hpp"
+
+#include <climits>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Regex {
+    // DFA which is built from the NFA as input reaches it rather than up front.  Each state is
+    // determinized the first time a match needs one of its transitions and kept in a cache of bounded
+    // size; a cache which fills up is flushed and starts again from the start state.  Matching from
+    // several threads is safe, as each thread builds a cache of its own and finds it without locking.
+    class LazyDFA {
+    public:
+        static const size_t kCacheBytes = 1 << 20;
+
+        LazyDFA(NFA nfa, const Encoding &encoding, size_t cacheBytes = kCacheBytes);
+
+        unsigned int match(std::string_view string, unsigned int start, unsigned int &pattern) const;
+
+    private:
+        static constexpr unsigned int kUnknown = UINT_MAX;
+        static constexpr unsigned int kReject = UINT_MAX - 1;
+
+        struct StateSetHash {
+            size_t operator()(const std::vector<unsigned int> &nfaStates) const;
+        };
+
+        struct Cache {
+            std::vector<unsigned int> transitions;
+            std::vector<unsigned int> acceptPatterns;
+            std::vector<const std::vector<unsigned int>*> nfaStates;
+            std::unordered_map<std::vector<unsigned int>, unsigned int, StateSetHash> stateMap;
+
+            size_t bytes;
+
+            std::vector<unsigned int> stack;
+            std::vector<unsigned int> marks;
+            unsigned int generation;
+        };
+
+        Cache &threadCache() const;
+
+        void flush(Cache &cache) const;
+        unsigned int addState(Cache &cache, std::vector<unsigned int> nfaStates) const;
+        unsigned int computeTransition(Cache &cache, unsigned int state, Encoding::CodePoint codePoint) const;
+        void closeOver(Cache &cache, std::vector<unsigned int> &nfaStates) const;
+        void nextGeneration(Cache &cache) const;
+
+        NFA mNFA;
+        const Encoding &mEncoding;
+        unsigned int mNumCodePoints;
+        size_t mCacheBytes;
+        std::vector<unsigned int> mAcceptPatterns;
+
+        // Thread caches hold a weak reference to this, so that a cache left behind by a destroyed DFA
+        // is never mistaken for one belonging to a new DFA at the same address.
+        std::shared_ptr<const char> mLifetime;
+    };
+}
+
+#endif
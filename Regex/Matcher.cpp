@@ -2,9 +2,189 @@
 
 #include "NFA.hpp"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
 namespace Regex {
 
-    Matcher::Matcher(const std::vector<std::string> &patterns)
+    static void addSymbols(const Parser::Node &node, ClassScanner::ByteSet &bytes)
+    {
+        if(node.type == Parser::Node::Type::Symbol) {
+            const Parser::SymbolNode &symbolNode = static_cast<const Parser::SymbolNode&>(node);
+            bytes.set((unsigned char)symbolNode.symbol);
+        } else {
+            const Parser::CharacterClassNode &characterClassNode = static_cast<const Parser::CharacterClassNode&>(node);
+            for(const auto &range : characterClassNode.ranges) {
+                for(unsigned int c = (unsigned char)range.first; c <= (unsigned char)range.second; c++) {
+                    bytes.set(c);
+                }
+            }
+        }
+    }
+
+    static bool isSymbolNode(const Parser::Node &node)
+    {
+        return node.type == Parser::Node::Type::Symbol || node.type == Parser::Node::Type::CharacterClass;
+    }
+
+    static bool firstBytes(const Parser::Node &node, ClassScanner::ByteSet &bytes)
+    {
+        switch(node.type) {
+            case Parser::Node::Type::Symbol:
+            case Parser::Node::Type::CharacterClass:
+                addSymbols(node, bytes);
+                return false;
+
+            case Parser::Node::Type::Sequence:
+            {
+                const Parser::SequenceNode &sequenceNode = static_cast<const Parser::SequenceNode&>(node);
+                for(const auto &child : sequenceNode.nodes) {
+                    if(!firstBytes(*child, bytes)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            case Parser::Node::Type::OneOf:
+            {
+                const Parser::OneOfNode &oneOfNode = static_cast<const Parser::OneOfNode&>(node);
+                bool nullable = false;
+                for(const auto &child : oneOfNode.nodes) {
+                    if(firstBytes(*child, bytes)) {
+                        nullable = true;
+                    }
+                }
+                return nullable;
+            }
+
+            case Parser::Node::Type::ZeroOrOne:
+                firstBytes(*static_cast<const Parser::ZeroOrOneNode&>(node).node, bytes);
+                return true;
+
+            case Parser::Node::Type::ZeroOrMore:
+                firstBytes(*static_cast<const Parser::ZeroOrMoreNode&>(node).node, bytes);
+                return true;
+
+            case Parser::Node::Type::OneOrMore:
+                return firstBytes(*static_cast<const Parser::OneOrMoreNode&>(node).node, bytes);
+        }
+
+        return false;
+    }
+
+    static bool runBytes(const Parser::Node &node, ClassScanner::ByteSet &bytes)
+    {
+        if(isSymbolNode(node)) {
+            addSymbols(node, bytes);
+            return true;
+        }
+
+        const Parser::Node *child = nullptr;
+        if(node.type == Parser::Node::Type::OneOrMore) {
+            child = static_cast<const Parser::OneOrMoreNode&>(node).node.get();
+        } else if(node.type == Parser::Node::Type::ZeroOrMore) {
+            child = static_cast<const Parser::ZeroOrMoreNode&>(node).node.get();
+        }
+
+        if(child && isSymbolNode(*child)) {
+            addSymbols(*child, bytes);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Appends the literal text every match of node starts with, returning whether that is all of it.
+    static bool literalPrefix(const Parser::Node &node, std::string &prefix)
+    {
+        switch(node.type) {
+            case Parser::Node::Type::Symbol:
+                prefix.push_back(static_cast<const Parser::SymbolNode&>(node).symbol);
+                return true;
+
+            case Parser::Node::Type::CharacterClass:
+            {
+                const Parser::CharacterClassNode &characterClassNode = static_cast<const Parser::CharacterClassNode&>(node);
+                if(characterClassNode.ranges.size() == 1 && characterClassNode.ranges[0].first == characterClassNode.ranges[0].second) {
+                    prefix.push_back(characterClassNode.ranges[0].first);
+                    return true;
+                }
+                return false;
+            }
+
+            case Parser::Node::Type::Sequence:
+            {
+                const Parser::SequenceNode &sequenceNode = static_cast<const Parser::SequenceNode&>(node);
+                for(const auto &child : sequenceNode.nodes) {
+                    if(!literalPrefix(*child, prefix)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            case Parser::Node::Type::OneOrMore:
+                literalPrefix(*static_cast<const Parser::OneOrMoreNode&>(node).node, prefix);
+                return false;
+
+            default:
+                return false;
+        }
+    }
+
+    // Rough ranking of how often a byte turns up in text and logs, used to pick the byte of a prefix
+    // to search for.
+    static unsigned int byteFrequency(unsigned char c)
+    {
+        if(c == ' ') {
+            return 100;
+        } else if(c >= 'a' && c <= 'z') {
+            return std::string_view("etaoinsrhldcu").find((char)c) != std::string_view::npos ? 90 : 60;
+        } else if(c >= '0' && c <= '9') {
+            return 50;
+        } else if(c == '\n' || c == '\t' || c == '\r') {
+            return 40;
+        } else if((c >= 'A' && c <= 'Z') || std::string_view(".,:;-_/=\"'()[]").find((char)c) != std::string_view::npos) {
+            return 30;
+        } else if(c >= 0x20 && c < 0x7f) {
+            return 10;
+        }
+
+        return 1;
+    }
+
+    static void saveBytes(Util::BinaryWriter &writer, const ClassScanner::ByteSet &bytes)
+    {
+        for(unsigned int i=0; i<bytes.size(); i+=32) {
+            uint32_t word = 0;
+            for(unsigned int j=0; j<32; j++) {
+                if(bytes[i + j]) {
+                    word |= (uint32_t)1 << j;
+                }
+            }
+            writer.write(word);
+        }
+    }
+
+    static void loadBytes(Util::BinaryReader &reader, ClassScanner::ByteSet &bytes)
+    {
+        for(unsigned int i=0; i<bytes.size(); i+=32) {
+            uint32_t word = 0;
+            reader.read(word);
+            for(unsigned int j=0; j<32; j++) {
+                bytes[i + j] = (word >> j) & 1;
+            }
+        }
+    }
+
+    Matcher::Matcher(const std::vector<std::string> &patterns, unsigned int maxDFAStates)
+    {
+        build(patterns, maxDFAStates);
+    }
+
+    void Matcher::build(const std::vector<std::string> &patterns, unsigned int maxDFAStates)
     {
         mNumPatterns = (unsigned int)patterns.size();
 
@@ -25,14 +205,157 @@ namespace Regex {
         mParseError.pattern = 0;
         mParseError.character = 0;
 
+        for(const auto &node : nodes) {
+            PatternBytes patternBytes;
+            firstBytes(*node, patternBytes.first);
+            patternBytes.isRun = runBytes(*node, patternBytes.run);
+            literalPrefix(*node, patternBytes.prefix);
+            mPatternBytes.push_back(patternBytes);
+        }
+        buildPrefilter();
+
         mEncoding = std::make_unique<Encoding>(nodes);
         NFA nfa(nodes, *mEncoding);
-        mDFA = std::make_unique<DFA>(nfa, *mEncoding);
+        std::unique_ptr<DFA> dfa = std::make_unique<DFA>(nfa, *mEncoding, maxDFAStates);
+        if(dfa->numStates() == 0) {
+            // The patterns are kept so that the matcher can be saved and rebuilt just as cheaply.
+            mPatterns = patterns;
+            std::unique_ptr<BitNFA> bitNFA = std::make_unique<BitNFA>(nfa, *mEncoding);
+            if(bitNFA->valid()) {
+                mBitNFA = std::move(bitNFA);
+            } else {
+                mLazyDFA = std::make_unique<LazyDFA>(std::move(nfa), *mEncoding);
+            }
+            return;
+        }
+
+        mDFA = std::move(dfa);
+        if(mDFA->numStates() <= FlatDFA::kMaxStates) {
+            mFlatDFA = std::make_unique<FlatDFA>(*mDFA, *mEncoding);
+        }
+    }
+
+    Matcher::Matcher(Util::BinaryReader &reader)
+    {
+        mParseError.pattern = 0;
+        mParseError.character = 0;
+
+        reader.expect(Util::binaryTag("MTCH"));
+        reader.read(mNumPatterns);
+        for(unsigned int i=0; i<mNumPatterns && reader.valid(); i++) {
+            PatternBytes patternBytes;
+            loadBytes(reader, patternBytes.first);
+            loadBytes(reader, patternBytes.run);
+            reader.read(patternBytes.isRun);
+            reader.read(patternBytes.prefix);
+            mPatternBytes.push_back(patternBytes);
+        }
+
+        bool fromPatterns = false;
+        reader.read(fromPatterns);
+        if(fromPatterns) {
+            std::vector<std::string> patterns(mNumPatterns);
+            for(unsigned int i=0; i<mNumPatterns && reader.valid(); i++) {
+                reader.read(patterns[i]);
+            }
+            if(!reader.valid()) {
+                return;
+            }
+
+            mPatternBytes.clear();
+            build(patterns, 0);
+            if(!valid()) {
+                reader.invalidate();
+            }
+            return;
+        }
+
+        mEncoding = std::make_unique<Encoding>(reader);
+        std::unique_ptr<DFA> dfa = std::make_unique<DFA>(reader);
+        if(!reader.valid() || dfa->numCodePoints() != mEncoding->numCodePoints()) {
+            reader.invalidate();
+            return;
+        }
+
+        for(unsigned int i=0; i<dfa->numStates(); i++) {
+            unsigned int pattern;
+            if(dfa->accept(i, pattern) && pattern >= mNumPatterns) {
+                reader.invalidate();
+                return;
+            }
+        }
+
+        mDFA = std::move(dfa);
+        if(mDFA->numStates() <= FlatDFA::kMaxStates) {
+            mFlatDFA = std::make_unique<FlatDFA>(*mDFA, *mEncoding);
+        }
+        buildPrefilter();
+    }
+
+    void Matcher::buildPrefilter()
+    {
+        mPrefix.clear();
+        mPrefixRareIndex = 0;
+        mFirstScanner.reset();
+        if(mPatternBytes.size() == 0) {
+            return;
+        }
+
+        // A prefix shared by every pattern is searched for by its rarest byte.
+        mPrefix = mPatternBytes[0].prefix;
+        for(const auto &patternBytes : mPatternBytes) {
+            size_t length = 0;
+            while(length < mPrefix.size() && length < patternBytes.prefix.size() && mPrefix[length] == patternBytes.prefix[length]) {
+                length++;
+            }
+            mPrefix.resize(length);
+        }
+
+        if(mPrefix.size() > 0) {
+            for(unsigned int i=1; i<mPrefix.size(); i++) {
+                if(byteFrequency((unsigned char)mPrefix[i]) < byteFrequency((unsigned char)mPrefix[mPrefixRareIndex])) {
+                    mPrefixRareIndex = i;
+                }
+            }
+            return;
+        }
+
+        // Otherwise, offsets whose byte cannot start any pattern are skipped.
+        ClassScanner::ByteSet first;
+        for(const auto &patternBytes : mPatternBytes) {
+            first |= patternBytes.first;
+        }
+        if(!first.all()) {
+            mFirstScanner = std::make_unique<ClassScanner>(~first);
+        }
+    }
+
+    void Matcher::save(Util::BinaryWriter &writer) const
+    {
+        writer.write(Util::binaryTag("MTCH"));
+        writer.write(mNumPatterns);
+        for(const auto &patternBytes : mPatternBytes) {
+            saveBytes(writer, patternBytes.first);
+            saveBytes(writer, patternBytes.run);
+            writer.write(patternBytes.isRun);
+            writer.write(patternBytes.prefix);
+        }
+
+        bool fromPatterns = mBitNFA || mLazyDFA;
+        writer.write(fromPatterns);
+        if(fromPatterns) {
+            for(const auto &pattern : mPatterns) {
+                writer.write(pattern);
+            }
+        } else if(mDFA) {
+            mEncoding->save(writer);
+            mDFA->save(writer);
+        }
     }
 
     bool Matcher::valid() const
     {
-        return (bool)mDFA;
+        return mDFA || mBitNFA || mLazyDFA;
     }
 
     const Matcher::ParseError &Matcher::parseError() const
@@ -40,8 +363,16 @@ namespace Regex {
         return mParseError;
     }
 
-    unsigned int Matcher::match(const std::string &string, unsigned int start, unsigned int &pattern) const
+    unsigned int Matcher::match(std::string_view string, unsigned int start, unsigned int &pattern) const
     {
+        if(mFlatDFA) {
+            return mFlatDFA->match(string, start, pattern);
+        } else if(mBitNFA) {
+            return mBitNFA->match(string, start, pattern);
+        } else if(mLazyDFA) {
+            return mLazyDFA->match(string, start, pattern);
+        }
+
         unsigned int state = mDFA->startState();
         unsigned int matched = 0;
         
@@ -65,8 +396,92 @@ namespace Regex {
         return matched;
     }
 
+    unsigned int Matcher::find(std::string_view string, unsigned int from, unsigned int &length, unsigned int &pattern) const
+    {
+        const char *data = string.data();
+        size_t size = string.size();
+        size_t pos = from;
+
+        while(pos < size) {
+            if(mPrefix.size() > 0) {
+                size_t search = pos + mPrefixRareIndex;
+                if(search + (mPrefix.size() - mPrefixRareIndex) > size) {
+                    break;
+                }
+
+                const void *hit = std::memchr(data + search, mPrefix[mPrefixRareIndex], size - search);
+                if(!hit) {
+                    break;
+                }
+
+                pos = ((const char*)hit - data) - mPrefixRareIndex;
+                if(pos + mPrefix.size() > size) {
+                    break;
+                }
+                if(std::memcmp(data + pos, mPrefix.data(), mPrefix.size()) != 0) {
+                    pos++;
+                    continue;
+                }
+            } else if(mFirstScanner) {
+                pos = mFirstScanner->skip(string, (unsigned int)pos);
+                if(pos >= size) {
+                    break;
+                }
+            }
+
+            length = match(string, (unsigned int)pos, pattern);
+            if(length > 0) {
+                return (unsigned int)pos;
+            }
+            pos++;
+        }
+
+        return UINT_MAX;
+    }
+
     unsigned int Matcher::numPatterns() const
     {
         return mNumPatterns;
     }
+
+    bool Matcher::hasDFA() const
+    {
+        return (bool)mDFA;
+    }
+
+    const DFA &Matcher::dfa() const
+    {
+        return *mDFA;
+    }
+
+    const Encoding &Matcher::encoding() const
+    {
+        return *mEncoding;
+    }
+
+    std::unique_ptr<ClassScanner> Matcher::createSkipScanner(const std::vector<unsigned int> &patterns) const
+    {
+        // Only the patterns which are plain class runs are skipped by the scanner; any others (comments,
+        // for instance) are left to the matcher, and must not start with a byte the scanner would skip.
+        ClassScanner::ByteSet bytes;
+        std::vector<unsigned int> runPatterns;
+        for(unsigned int pattern : patterns) {
+            if(pattern < mPatternBytes.size() && mPatternBytes[pattern].isRun) {
+                bytes |= mPatternBytes[pattern].run;
+                runPatterns.push_back(pattern);
+            }
+        }
+
+        for(unsigned int i=0; i<mPatternBytes.size(); i++) {
+            if(std::find(runPatterns.begin(), runPatterns.end(), i) == runPatterns.end() && (mPatternBytes[i].first & bytes).any()) {
+                return nullptr;
+            }
+        }
+
+        if(bytes.none()) {
+            return nullptr;
+        }
+
+        return std::make_unique<ClassScanner>(bytes);
+    }
 }
\ No newline at end of file
@@ -1,17 +1,30 @@
 #ifndef REGEX_MATCHER_HPP
 #define REGEX_MATCHER_HPP
 
+#include "BitNFA.hpp"
 #include "DFA.hpp"
+#include "FlatDFA.hpp"
+#include "LazyDFA.hpp"
+#include "ClassScanner.hpp"
 #include "Encoding.hpp"
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace Regex {
 
     class Matcher {
     public:
-        Matcher(const std::vector<std::string> &patterns);
+        // Patterns whose DFA passes maxDFAStates states during construction are matched without one:
+        // by simulating the NFA with bitmasks if it is small enough, and otherwise with a DFA built
+        // lazily as input reaches it.  0 never builds the DFA up front.
+        static const unsigned int kMaxDFAStates = 4096;
+
+        Matcher(const std::vector<std::string> &patterns, unsigned int maxDFAStates = kMaxDFAStates);
+        Matcher(Util::BinaryReader &reader);
+
+        void save(Util::BinaryWriter &writer) const;
 
         bool valid() const;
 
@@ -22,14 +35,44 @@ namespace Regex {
         };
         const ParseError &parseError() const;
 
-        unsigned int match(const std::string &string, unsigned int start, unsigned int &pattern) const;
+        unsigned int match(std::string_view string, unsigned int start, unsigned int &pattern) const;
+
+        // Returns the first offset at or after from where some pattern matches, or UINT_MAX if there
+        // is none.  Offsets which cannot begin a match are skipped without running the DFA.
+        unsigned int find(std::string_view string, unsigned int from, unsigned int &length, unsigned int &pattern) const;
         unsigned int numPatterns() const;
 
+        // A matcher which fell back to the NFA or the lazy DFA has no complete DFA to return.
+        bool hasDFA() const;
+        const DFA &dfa() const;
+        const Encoding &encoding() const;
+
+        std::unique_ptr<ClassScanner> createSkipScanner(const std::vector<unsigned int> &patterns) const;
+
     private:
+        struct PatternBytes {
+            ClassScanner::ByteSet first;
+            ClassScanner::ByteSet run;
+            bool isRun;
+            std::string prefix;
+        };
+
+        void build(const std::vector<std::string> &patterns, unsigned int maxDFAStates);
+        void buildPrefilter();
+
         std::unique_ptr<DFA> mDFA;
+        std::unique_ptr<FlatDFA> mFlatDFA;
+        std::unique_ptr<BitNFA> mBitNFA;
+        std::unique_ptr<LazyDFA> mLazyDFA;
+        std::vector<std::string> mPatterns;
         std::unique_ptr<Encoding> mEncoding;
         ParseError mParseError;
         unsigned int mNumPatterns;
+        std::vector<PatternBytes> mPatternBytes;
+
+        std::string mPrefix;
+        unsigned int mPrefixRareIndex;
+        std::unique_ptr<ClassScanner> mFirstScanner;
     };
 }
 
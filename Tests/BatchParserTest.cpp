@@ -0,0 +1,112 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Parser/BatchParser.hpp"
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+
+#include "Tests/Common.hpp"
+
+// Parses a batch of calculator expressions with BatchParser on several threads and checks every
+// result against a single session parsing the same inputs one after another.  Some inputs have
+// syntax errors, so failed parses are interleaved with successful ones on each worker's session.
+//
+// To check the workers for data races, configure a separate build with ThreadSanitizer and run the
+// test there:
+//
+//     cmake -S . -B build-tsan -DPARSER_SANITIZE_THREAD=ON
+//     cmake --build build-tsan
+//     ctest --test-dir build-tsan -R batchparser --output-on-failure
+//
+// Usage: batchparsertest <source dir>
+
+// Builds a random expression, which is truncated to make a syntax error about one time in eight.
+static std::string randomExpression(std::mt19937 &random, unsigned int depth)
+{
+    static const char kOperators[] = {'+', '-', '*', '/'};
+
+    std::string expression;
+    unsigned int terms = 1 + random() % 4;
+    for(unsigned int i=0; i<terms; i++) {
+        if(i > 0) {
+            expression += kOperators[random() % 4];
+        }
+        if(depth > 0 && random() % 4 == 0) {
+            expression += "(" + randomExpression(random, depth - 1) + ")";
+        } else {
+            expression += std::to_string(random() % 100);
+        }
+    }
+
+    if(depth == 2 && random() % 8 == 0) {
+        expression.resize(random() % expression.size());
+    }
+
+    return expression;
+}
+
+template<typename Session, typename ParserType> unsigned int check(const char *name, const ParserType &parser, const Parser::DefReader &reader, const std::vector<std::string_view> &inputs)
+{
+    Session session(parser);
+    Tests::addCalcReducers(session, reader.grammar(), [](int value) { return value; });
+    std::vector<int> expected;
+    for(std::string_view input : inputs) {
+        Parser::Tokenizer::Stream stream(reader.tokenizer(), input);
+        expected.push_back(session.parse(stream));
+    }
+
+    unsigned int failures = 0;
+    Parser::BatchParser<Session> batchParser(parser, reader.tokenizer(), [&](Session &batchSession) {
+        Tests::addCalcReducers(batchSession, reader.grammar(), [](int value) { return value; });
+    });
+    for(unsigned int threads : {1, 2, 4, 8}) {
+        // Run each size twice so that sessions kept from the previous batch are reused.
+        for(unsigned int pass=0; pass<2; pass++) {
+            std::vector<int> results = batchParser.parseBatch(inputs, threads);
+            for(size_t i=0; i<inputs.size(); i++) {
+                if(results[i] != expected[i]) {
+                    std::cout << name << ", " << threads << " threads: \"" << inputs[i] << "\" returned " << results[i] << ", expected " << expected[i] << std::endl;
+                    failures++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::DefReader &reader = *defReader;
+
+    std::mt19937 random(1);
+    std::vector<std::string> expressions;
+    for(unsigned int i=0; i<5000; i++) {
+        expressions.push_back(randomExpression(random, 2));
+    }
+    std::vector<std::string_view> inputs(expressions.begin(), expressions.end());
+
+    unsigned int failures = 0;
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    failures += check<Parser::Impl::LALR::ParseSession<int, int>>("LALR", lalr, reader, inputs);
+
+    Parser::Impl::LL ll(reader.grammar());
+    failures += check<Parser::Impl::LL::ParseSession<int, int>>("LL", ll, reader, inputs);
+
+    if(failures > 0) {
+        std::cout << failures << " batches differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
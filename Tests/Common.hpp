@@ -0,0 +1,191 @@
+#ifndef TESTS_COMMON_HPP
+#define TESTS_COMMON_HPP
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Grammar.hpp"
+#include "Parser/Tokenizer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Fixtures shared by the tests and by parsebench.
+namespace Tests
+{
+    // Checks for the source directory argument most tests take, printing usage if it is missing.
+    inline bool checkUsage(int argc, char *argv[])
+    {
+        if(argc < 2) {
+            std::cout << "Usage: " << argv[0] << " <source dir>" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Reads a def file from the path given relative to the source directory, returning null after
+    // printing usage or the error in the def file if it cannot.
+    inline std::unique_ptr<Parser::DefReader> readDef(int argc, char *argv[], const std::string &path)
+    {
+        if(!checkUsage(argc, argv)) {
+            return nullptr;
+        }
+
+        std::unique_ptr<Parser::DefReader> reader = std::make_unique<Parser::DefReader>(std::string(argv[1]) + "/" + path);
+        if(!reader->valid()) {
+            std::cout << "Error in def file, line " << reader->parseError().line << ": " << reader->parseError().message << std::endl;
+            return nullptr;
+        }
+
+        return reader;
+    }
+
+    inline std::unique_ptr<Parser::DefReader> readCalcDef(int argc, char *argv[])
+    {
+        return readDef(argc, argv, "Bench/calc.def");
+    }
+
+    inline int calcValue(int value)
+    {
+        return value;
+    }
+
+    template<typename DataPointer> int calcValue(const DataPointer &value)
+    {
+        return *value;
+    }
+
+    inline int calcDivide(int dividend, int divisor)
+    {
+        if(divisor == 0) {
+            return 0;
+        }
+        if(divisor == -1) {
+            return (int)(0u - (unsigned int)dividend);
+        }
+        return dividend / divisor;
+    }
+
+    // Adds the calculator's decorator and reducers to a session over calc.def.  Each value is made
+    // from an int with makeValue, so the same reducers serve sessions whose DataPointer is an int, a
+    // raw pointer or a shared_ptr.  Arithmetic wraps around rather than overflowing, and division by
+    // zero gives zero, so that every input has a well-defined result to compare.
+    template<typename Session, typename MakeValue> void addCalcReducers(Session &session, const Parser::Grammar &grammar, MakeValue makeValue)
+    {
+        session.addTerminalDecorator("NUMBER", [=](const Parser::Tokenizer::Token &token) {
+            unsigned int number = 0;
+            for(char c : token.text) {
+                number = number * 10 + (unsigned int)(c - '0');
+            }
+            return makeValue((int)number);
+        });
+
+        session.addReducer("root", [](auto begin, auto) {
+            return begin->data;
+        });
+        unsigned int minus = grammar.terminalIndex("-");
+        session.addReducer("E", [=](auto begin, auto end) {
+            unsigned int result = (unsigned int)calcValue(begin->data);
+            for(auto it = begin + 1; it != end; it += 2) {
+                unsigned int operand = (unsigned int)calcValue((it + 1)->data);
+                result = (it->index == minus) ? result - operand : result + operand;
+            }
+            return makeValue((int)result);
+        });
+        unsigned int divide = grammar.terminalIndex("/");
+        session.addReducer("T", [=](auto begin, auto end) {
+            int result = calcValue(begin->data);
+            for(auto it = begin + 1; it != end; it += 2) {
+                int operand = calcValue((it + 1)->data);
+                result = (it->index == divide) ? calcDivide(result, operand) : (int)((unsigned int)result * (unsigned int)operand);
+            }
+            return makeValue(result);
+        });
+        unsigned int lparen = grammar.terminalIndex("(");
+        session.addReducer("F", [=](auto begin, auto) {
+            return (begin->index == lparen) ? (begin + 1)->data : begin->data;
+        });
+    }
+
+    // Adds reducers which write out each derivation as a string, a nonterminal as its name followed by
+    // its children in parentheses, so that derivations from different parsers can be compared.
+    template<typename Session> void addDerivationReducers(Session &session, const Parser::Grammar &grammar)
+    {
+        for(const std::string &terminal : grammar.terminals()) {
+            session.addTerminalDecorator(terminal, [terminal](const Parser::Tokenizer::Token &) {
+                return std::make_shared<std::string>(terminal);
+            });
+        }
+
+        for(const Parser::Grammar::Rule &rule : grammar.rules()) {
+            std::string lhs = rule.lhs;
+            session.addReducer(lhs, [lhs](auto begin, auto end) {
+                std::string result = lhs + "(";
+                for(auto it = begin; it != end; it++) {
+                    result += (it == begin ? "" : " ") + (it->data ? *it->data : std::string("?"));
+                }
+                return std::make_shared<std::string>(result + ")");
+            });
+        }
+    }
+
+    // Parses input with a session which returns every derivation, such as GLR's or Earley's, and
+    // returns the derivations sorted.
+    template<typename Session> std::vector<std::string> derivations(Session &session, const Parser::Tokenizer &tokenizer, const std::string &input)
+    {
+        Parser::Tokenizer::Stream stream(tokenizer, input);
+        std::vector<std::string> results;
+        for(const auto &result : session.parse(stream)) {
+            results.push_back(result ? *result : std::string("?"));
+        }
+        std::sort(results.begin(), results.end());
+
+        return results;
+    }
+
+    // Builds a grammar of numRules - 1 nonterminals under a root rule, over the terminals a, b and c
+    // and an END terminal.  Each has up to three right-hand sides of up to three symbols, some of them
+    // empty, so many of the grammars are ambiguous or have conflicts.
+    inline Parser::Grammar randomGrammar(std::mt19937 &random, unsigned int numRules)
+    {
+        const unsigned int numTerminals = 3;
+        const unsigned int end = numTerminals;
+
+        std::vector<std::string> terminals{"a", "b", "c", "END"};
+        std::vector<Parser::Grammar::Rule> rules;
+        rules.push_back(Parser::Grammar::Rule{"root", {{{Parser::Grammar::Symbol::Type::Nonterminal, 1}, {Parser::Grammar::Symbol::Type::Terminal, end}}}});
+
+        for(unsigned int i=1; i<numRules; i++) {
+            std::stringstream ss;
+            ss << "N" << i;
+            Parser::Grammar::Rule rule{ss.str(), {}};
+
+            unsigned int numRhs = 1 + random() % 3;
+            for(unsigned int j=0; j<numRhs; j++) {
+                Parser::Grammar::RHS rhs;
+                unsigned int length = random() % 4;
+                for(unsigned int k=0; k<length; k++) {
+                    unsigned int symbol = random() % (numTerminals + numRules - 1);
+                    if(symbol < numTerminals) {
+                        rhs.push_back(Parser::Grammar::Symbol{Parser::Grammar::Symbol::Type::Terminal, symbol});
+                    } else {
+                        rhs.push_back(Parser::Grammar::Symbol{Parser::Grammar::Symbol::Type::Nonterminal, symbol - numTerminals + 1});
+                    }
+                }
+                if(rhs.empty()) {
+                    rhs.push_back(Parser::Grammar::Symbol{Parser::Grammar::Symbol::Type::Epsilon, 0});
+                }
+                rule.rhs.push_back(std::move(rhs));
+            }
+            rules.push_back(std::move(rule));
+        }
+
+        return Parser::Grammar(std::move(terminals), std::move(rules), 0);
+    }
+}
+
+#endif
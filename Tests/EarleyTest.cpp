@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Parser/Impl/Earley.hpp"
+#include "Parser/Impl/GLR.hpp"
+
+#include "Tests/Common.hpp"
+
+// Checks the forests built by Earley against those built by GLR.  Each derivation in a forest is
+// written out as a string by the reducers, and the two parsers must produce the same set of
+// derivations for every input.  The grammars are ambiguous, have nullable nonterminals, and hide left
+// recursion behind a nullable prefix, followed by a set of small random grammars without cycles.
+//
+// Usage: earleytest <source dir>
+
+typedef Parser::Grammar::Symbol Symbol;
+
+static const Symbol a{Symbol::Type::Terminal, 0};
+static const Symbol b{Symbol::Type::Terminal, 1};
+static const Symbol c{Symbol::Type::Terminal, 2};
+static const Symbol endOfInput{Symbol::Type::Terminal, 3};
+static const Symbol epsilon{Symbol::Type::Epsilon, 0};
+
+static Symbol nonterminal(unsigned int index)
+{
+    return Symbol{Symbol::Type::Nonterminal, index};
+}
+
+// Returns true if some nonterminal derives itself, in which case the forest has a cycle and the set
+// of derivations is infinite.
+static bool cyclic(const Parser::Grammar &grammar)
+{
+    Util::BitSet nullableNonterminals = grammar.computeNullable();
+
+    auto nullable = [&](const Symbol &symbol) {
+        return symbol.type == Symbol::Type::Epsilon || (symbol.type == Symbol::Type::Nonterminal && nullableNonterminals.test(symbol.index));
+    };
+
+    // units[i] holds the nonterminals which nonterminal i can derive alone.
+    std::vector<std::set<unsigned int>> units(grammar.rules().size());
+    for(unsigned int i=0; i<grammar.rules().size(); i++) {
+        for(const Parser::Grammar::RHS &rhs : grammar.rules()[i].rhs) {
+            for(unsigned int j=0; j<rhs.size(); j++) {
+                if(rhs[j].type != Symbol::Type::Nonterminal) {
+                    continue;
+                }
+                bool others = true;
+                for(unsigned int k=0; k<rhs.size(); k++) {
+                    others = others && (k == j || nullable(rhs[k]));
+                }
+                if(others) {
+                    units[i].insert(rhs[j].index);
+                }
+            }
+        }
+    }
+
+    for(unsigned int i=0; i<grammar.rules().size(); i++) {
+        std::set<unsigned int> reached;
+        std::vector<unsigned int> pending(units[i].begin(), units[i].end());
+        while(pending.size() > 0) {
+            unsigned int rule = pending.back();
+            pending.pop_back();
+            if(rule == i) {
+                return true;
+            }
+            if(reached.insert(rule).second) {
+                pending.insert(pending.end(), units[rule].begin(), units[rule].end());
+            }
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    if(!Tests::checkUsage(argc, argv)) {
+        return 1;
+    }
+
+    std::vector<Parser::Tokenizer::Configuration> configurations{
+        Parser::Tokenizer::Configuration{std::vector<Parser::Tokenizer::Pattern>{
+            Parser::Tokenizer::Pattern{"a", "a", 0},
+            Parser::Tokenizer::Pattern{"b", "b", 1},
+            Parser::Tokenizer::Pattern{"c", "c", 2},
+            Parser::Tokenizer::Pattern{"\\s", "IGNORE", Parser::Tokenizer::kInvalidTokenValue}
+        }}
+    };
+    Parser::Tokenizer tokenizer(std::move(configurations), 3, Parser::Tokenizer::kInvalidTokenValue);
+
+    unsigned int failures = 0;
+    unsigned int numParsed = 0;
+    // An expected count of UINT_MAX only requires the two parsers to agree.
+    auto check = [&](const std::string &name, const Parser::Grammar &grammar, const std::string &input, unsigned int expectedCount) {
+        Parser::Impl::GLR glr(grammar);
+        Parser::Impl::GLR::ParseSession<std::string> glrSession(glr);
+        Tests::addDerivationReducers(glrSession, grammar);
+
+        Parser::Impl::Earley earley(grammar);
+        Parser::Impl::Earley::ParseSession<std::string> earleySession(earley);
+        Tests::addDerivationReducers(earleySession, grammar);
+
+        std::vector<std::string> expected = Tests::derivations(glrSession, tokenizer, input);
+        std::vector<std::string> actual = Tests::derivations(earleySession, tokenizer, input);
+        numParsed += expected.empty() ? 0 : 1;
+        if(expected != actual || (expectedCount != UINT_MAX && expected.size() != expectedCount)) {
+            std::cout << name << ", \"" << input << "\": GLR found " << expected.size() << " derivations, Earley found " << actual.size() << std::endl;
+            for(const std::string &derivation : expected) {
+                if(!std::binary_search(actual.begin(), actual.end(), derivation)) {
+                    std::cout << "    missing from Earley: " << derivation << std::endl;
+                }
+            }
+            for(const std::string &derivation : actual) {
+                if(!std::binary_search(expected.begin(), expected.end(), derivation)) {
+                    std::cout << "    missing from GLR: " << derivation << std::endl;
+                }
+            }
+            failures++;
+        }
+    };
+
+    // S: S S | 'a'
+    Parser::Grammar ambiguous({"a", "b", "c", "END"}, {
+        Parser::Grammar::Rule{"root", {{nonterminal(1), endOfInput}}},
+        Parser::Grammar::Rule{"S", {{nonterminal(1), nonterminal(1)}, {a}}}
+    }, 0);
+    check("ambiguous", ambiguous, "a", 1);
+    check("ambiguous", ambiguous, "a a a", 2);
+    check("ambiguous", ambiguous, "a a a a a", 14);
+
+    // S: A 'a' B | A A 'c'
+    // A: 'b' | 0
+    // B: A A | 'c'
+    Parser::Grammar nullable({"a", "b", "c", "END"}, {
+        Parser::Grammar::Rule{"root", {{nonterminal(1), endOfInput}}},
+        Parser::Grammar::Rule{"S", {{nonterminal(2), a, nonterminal(3)}, {nonterminal(2), nonterminal(2), c}}},
+        Parser::Grammar::Rule{"A", {{b}, {epsilon}}},
+        Parser::Grammar::Rule{"B", {{nonterminal(2), nonterminal(2)}, {c}}}
+    }, 0);
+    check("nullable", nullable, "a", 1);
+    check("nullable", nullable, "c", 1);
+    check("nullable", nullable, "b c", 2);
+    check("nullable", nullable, "b a b", 2);
+    check("nullable", nullable, "a b b", 1);
+
+    // S: A S 'a' | 'a'
+    // A: 'b' A | 0
+    Parser::Grammar hiddenLeftRecursion({"a", "b", "c", "END"}, {
+        Parser::Grammar::Rule{"root", {{nonterminal(1), endOfInput}}},
+        Parser::Grammar::Rule{"S", {{nonterminal(2), nonterminal(1), a}, {a}}},
+        Parser::Grammar::Rule{"A", {{b, nonterminal(2)}, {epsilon}}}
+    }, 0);
+    check("hidden left recursion", hiddenLeftRecursion, "a a a", 1);
+    check("hidden left recursion", hiddenLeftRecursion, "b a a", 1);
+    check("hidden left recursion", hiddenLeftRecursion, "b b a a a", 3);
+    check("hidden left recursion", hiddenLeftRecursion, "b a a a", 2);
+
+    std::mt19937 random(1);
+    unsigned int numGrammars = 0;
+    while(numGrammars < 300) {
+        Parser::Grammar grammar = Tests::randomGrammar(random, 4);
+        if(cyclic(grammar)) {
+            continue;
+        }
+
+        std::stringstream ss;
+        ss << "random grammar " << numGrammars;
+        for(unsigned int i=0; i<20; i++) {
+            std::string input;
+            unsigned int length = random() % 6;
+            for(unsigned int j=0; j<length; j++) {
+                input += (j == 0 ? "" : " ") + std::string(1, (char)('a' + random() % 3));
+            }
+            check(ss.str(), grammar, input, UINT_MAX);
+        }
+        numGrammars++;
+    }
+
+    std::cout << numGrammars << " random grammars, " << numParsed << " inputs parsed" << std::endl;
+    if(failures > 0) {
+        std::cout << failures << " inputs differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
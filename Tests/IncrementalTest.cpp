@@ -0,0 +1,144 @@
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LRIncremental.hpp"
+
+#include "Tests/Common.hpp"
+
+// Edits a calculator document through an incremental session and checks the result of each reparse
+// against a full parse of the same text.  Most edits keep the document valid, changing a number or
+// adding or removing a term.  The rest insert or delete arbitrary characters and are then undone, so
+// that reparses also start from the subtrees left by a failed parse.
+//
+// Usage: incrementaltest <source dir>
+
+struct Edit {
+    size_t start;
+    size_t length;
+    std::string text;
+};
+
+// Picks an edit which keeps the document valid.  Numbers are found by scanning from a random position,
+// so that most edits land inside the expression lists rather than at their ends.
+static Edit randomEdit(std::mt19937 &random, const std::string &document)
+{
+    size_t position = document.empty() ? 0 : random() % document.size();
+    switch(random() % 3) {
+        case 0:
+        {
+            // Replace one digit with another.
+            while(position < document.size() && (document[position] < '0' || document[position] > '9')) {
+                position++;
+            }
+            return Edit{position, (position < document.size()) ? 1u : 0u, std::string(1, (char)('0' + random() % 10))};
+        }
+
+        case 1:
+        {
+            // Add a term after a number, sometimes on a line of its own.
+            while(position < document.size() && (document[position] < '0' || document[position] > '9')) {
+                position++;
+            }
+            while(position < document.size() && document[position] >= '0' && document[position] <= '9') {
+                position++;
+            }
+            return Edit{position, 0, (random() % 2 == 0 ? "+" : "\n*") + std::to_string(random() % 100)};
+        }
+
+        default:
+        {
+            // Remove an operator and the number after it.
+            while(position < document.size() && document[position] != '+' && document[position] != '*') {
+                position++;
+            }
+            size_t length = 1;
+            while(position + length < document.size() && document[position + length] >= '0' && document[position + length] <= '9') {
+                length++;
+            }
+            return Edit{position, (length > 1) ? length : 0, ""};
+        }
+    }
+}
+
+// Picks an edit which inserts or deletes arbitrary characters.
+static Edit randomDamage(std::mt19937 &random, const std::string &document)
+{
+    static const char *const kFragments[] = {"", "+", "-", "*", "(", ")", "7", "\n", " ", "(1+", ")*2"};
+
+    size_t position = document.empty() ? 0 : random() % document.size();
+    return Edit{position, random() % 3, kFragments[random() % 11]};
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::DefReader &reader = *defReader;
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    Parser::Impl::LALR::ParseSession<int, std::shared_ptr<int>> session(lalr);
+    Tests::addCalcReducers(session, reader.grammar(), [](int value) { return std::make_shared<int>(value); });
+    Parser::Impl::LALR::IncrementalSession<int> incrementalSession(lalr, reader.tokenizer());
+    Tests::addCalcReducers(incrementalSession, reader.grammar(), [](int value) { return std::make_shared<int>(value); });
+
+    std::mt19937 random(1);
+    std::string document;
+    for(unsigned int i=0; i<500; i++) {
+        document += (i == 0 ? "" : (i % 10 == 0) ? "\n+" : "+") + std::to_string(random() % 100);
+        if(i % 50 == 25) {
+            document += "*(3-1)";
+        }
+    }
+
+    unsigned int failures = 0;
+    unsigned int numValid = 0;
+    auto check = [&](const std::shared_ptr<int> &result, unsigned int edit) {
+        Parser::Tokenizer::Stream stream(reader.tokenizer(), incrementalSession.document());
+        std::shared_ptr<int> expected = session.parse(stream);
+        numValid += expected ? 1 : 0;
+        if(!expected != !result || (expected && *expected != *result)) {
+            std::cout << "edit " << edit << ": returned ";
+            if(result) {
+                std::cout << *result;
+            } else {
+                std::cout << "null";
+            }
+            std::cout << ", full parse returned ";
+            if(expected) {
+                std::cout << *expected;
+            } else {
+                std::cout << "null";
+            }
+            std::cout << std::endl;
+            failures++;
+        }
+    };
+
+    // Every eighth edit damages the document and is undone by the edit after it.
+    check(incrementalSession.parse(document), 0);
+    for(unsigned int i=1; i<=2000 && failures < 10; i++) {
+        if(i % 8 == 0) {
+            Edit edit = randomDamage(random, incrementalSession.document());
+            std::string removed = incrementalSession.document().substr(std::min(edit.start, incrementalSession.document().size()), edit.length);
+            check(incrementalSession.edit(edit.start, edit.length, edit.text), i);
+            i++;
+            check(incrementalSession.edit(edit.start, edit.text.size(), removed), i);
+        } else {
+            Edit edit = randomEdit(random, incrementalSession.document());
+            check(incrementalSession.edit(edit.start, edit.length, edit.text), i);
+        }
+    }
+
+    std::cout << "2000 edits, " << numValid << " valid documents" << std::endl;
+    if(failures > 0) {
+        std::cout << failures << " reparses differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+
+#include "Tests/Common.hpp"
+
+// Checks the DeRemer-Pennello lookahead computation in LALR against the construction it replaced,
+// which expands the grammar with a nonterminal for every (state, rule) pair at which a rule is
+// predicted and takes the lookaheads of each reduction from the FOLLOW sets of that grammar.  Both
+// must produce identical tables, or fail with the identical conflict, for the def files in the
+// source tree and for a set of small random grammars.
+//
+// Usage: lalrtest <source dir>
+
+// The expanded-grammar LALR construction, kept here as the reference.
+class ExpandedLALR : public Parser::Impl::LRSingle
+{
+public:
+    ExpandedLALR(const Parser::Grammar &grammar)
+    : LRSingle(grammar)
+    {
+        std::vector<State> states = computeStates();
+
+        std::vector<std::pair<unsigned int, unsigned int>> newNonterminals;
+        auto findNonterminal = [&](unsigned int state, unsigned int rule) {
+            for(unsigned int i=0; i<newNonterminals.size(); i++) {
+                if(newNonterminals[i] == std::make_pair(state, rule)) { return i;}
+            }
+            return UINT_MAX;
+        };
+
+        std::vector<Parser::Grammar::Rule> newRules;
+        for(unsigned int i=0; i<states.size(); i++) {
+            for(const auto &item : states[i].items) {
+                if(item.pos == 0 && findNonterminal(i, item.rule) == UINT_MAX) {
+                    newNonterminals.push_back(std::make_pair(i, item.rule));
+                    std::stringstream ss;
+                    ss << grammar.rules()[item.rule].lhs << "@" << i;
+                    newRules.push_back(Parser::Grammar::Rule{ss.str(), {}});
+                }
+            }
+        }
+
+        std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> reductionStarts;
+        for(unsigned int i=0; i<states.size(); i++) {
+            for(const auto &item : states[i].items) {
+                if(item.pos == 0) {
+                    const Parser::Grammar::RHS &rhs = grammar.rules()[item.rule].rhs[item.rhs];
+
+                    Parser::Grammar::RHS newRhs;
+                    unsigned int stateNum = i;
+                    for(const Parser::Grammar::Symbol &symbol : rhs) {
+                        switch(symbol.type) {
+                            case Parser::Grammar::Symbol::Type::Nonterminal:
+                                newRhs.push_back(Parser::Grammar::Symbol{Parser::Grammar::Symbol::Type::Nonterminal, findNonterminal(stateNum, symbol.index)});
+                                stateNum = states[stateNum].transitions.at(symbolIndex(symbol));
+                                break;
+
+                            case Parser::Grammar::Symbol::Type::Terminal:
+                                newRhs.push_back(symbol);
+                                stateNum = states[stateNum].transitions.at(symbolIndex(symbol));
+                                break;
+
+                            case Parser::Grammar::Symbol::Type::Epsilon:
+                                newRhs.push_back(symbol);
+                                break;
+                        }
+                    }
+
+                    newRules[findNonterminal(i, item.rule)].rhs.push_back(std::move(newRhs));
+                    reductionStarts[std::make_pair(stateNum, item.rule)].insert(i);
+                }
+            }
+        }
+
+        Parser::Grammar newGrammar(grammar.terminals(), std::move(newRules), findNonterminal(0, grammar.startRule()));
+
+        std::vector<std::set<unsigned int>> firstSets;
+        std::vector<std::set<unsigned int>> followSets;
+        std::set<unsigned int> nullableNonterminals;
+        newGrammar.computeSets(firstSets, followSets, nullableNonterminals);
+
+        std::map<std::pair<unsigned int, unsigned int>, std::set<unsigned int>> followPerStateSets;
+        for(const auto &it : reductionStarts) {
+            for(unsigned int startState : it.second) {
+                const std::set<unsigned int> &followSet = followSets[findNonterminal(startState, it.first.second)];
+                followPerStateSets[it.first].insert(followSet.begin(), followSet.end());
+            }
+        }
+
+        auto getReduceLookahead = [&](unsigned int state, unsigned int rule) {
+            return followPerStateSets[std::make_pair(state, rule)];
+        };
+
+        if(computeParseTable(states, getReduceLookahead)) {
+            mValid = true;
+        }
+    }
+};
+
+static bool sameEntry(const Parser::Impl::LRSingle::ParseTableEntry &a, const Parser::Impl::LRSingle::ParseTableEntry &b)
+{
+    return a.type == b.type && (a.type == Parser::Impl::LRSingle::ParseTableEntry::Type::Error || a.index == b.index);
+}
+
+// Returns an empty string if both parsers built the same tables, and otherwise the first difference.
+static std::string compare(const Parser::Impl::LRSingle &expected, const Parser::Impl::LRSingle &actual, const Parser::Grammar &grammar)
+{
+    std::stringstream ss;
+    if(expected.valid() != actual.valid()) {
+        ss << "valid " << expected.valid() << " != " << actual.valid();
+        return ss.str();
+    }
+
+    if(!expected.valid()) {
+        const Parser::Impl::LRSingle::Conflict &a = expected.conflict();
+        const Parser::Impl::LRSingle::Conflict &b = actual.conflict();
+        bool reduceReduce = a.type == Parser::Impl::LRSingle::Conflict::Type::ReduceReduce;
+        if(a.type != b.type || a.symbol != b.symbol || a.item1 != b.item1 || (reduceReduce && a.item2 != b.item2)) {
+            ss << "conflict on symbol " << a.symbol << " != conflict on symbol " << b.symbol;
+            return ss.str();
+        }
+    }
+
+    if(expected.numStates() != actual.numStates()) {
+        ss << "numStates " << expected.numStates() << " != " << actual.numStates();
+        return ss.str();
+    }
+
+    if(expected.numReductions() != actual.numReductions()) {
+        ss << "numReductions " << expected.numReductions() << " != " << actual.numReductions();
+        return ss.str();
+    }
+
+    for(unsigned int i=0; i<expected.numReductions(); i++) {
+        if(expected.reduction(i).rule != actual.reduction(i).rule || expected.reduction(i).rhs != actual.reduction(i).rhs) {
+            ss << "reduction " << i;
+            return ss.str();
+        }
+    }
+
+    for(unsigned int state=0; state<expected.numStates(); state++) {
+        if(expected.acceptState(state) != actual.acceptState(state)) {
+            ss << "acceptState " << state;
+            return ss.str();
+        }
+
+        for(unsigned int terminal=0; terminal<grammar.terminals().size(); terminal++) {
+            if(!sameEntry(expected.action(state, terminal), actual.action(state, terminal))) {
+                ss << "action " << state << ", " << grammar.terminals()[terminal];
+                return ss.str();
+            }
+        }
+
+        for(unsigned int rule=0; rule<grammar.rules().size(); rule++) {
+            if(!sameEntry(expected.transition(state, rule), actual.transition(state, rule))) {
+                ss << "goto " << state << ", " << grammar.rules()[rule].lhs;
+                return ss.str();
+            }
+        }
+    }
+
+    return "";
+}
+
+int main(int argc, char *argv[])
+{
+    if(!Tests::checkUsage(argc, argv)) {
+        return 1;
+    }
+
+    unsigned int failures = 0;
+    auto check = [&](const std::string &name, const Parser::Grammar &grammar) {
+        ExpandedLALR expected(grammar);
+        Parser::Impl::LALR actual(grammar);
+        std::string difference = compare(expected, actual, grammar);
+        if(!difference.empty()) {
+            std::cout << name << ": " << difference << std::endl;
+            failures++;
+        }
+    };
+
+    for(const char *filename : {"grammar.def", "Bench/calc.def"}) {
+        Parser::DefReader reader(std::string(argv[1]) + "/" + filename);
+        if(!reader.valid()) {
+            std::cout << filename << ": error in def file, line " << reader.parseError().line << ": " << reader.parseError().message << std::endl;
+            failures++;
+            continue;
+        }
+        check(filename, reader.grammar());
+    }
+
+    std::mt19937 random(1);
+    unsigned int numValid = 0;
+    for(unsigned int i=0; i<500; i++) {
+        Parser::Grammar grammar = Tests::randomGrammar(random, 5);
+        std::stringstream ss;
+        ss << "random grammar " << i;
+        check(ss.str(), grammar);
+        numValid += Parser::Impl::LALR(grammar).valid() ? 1 : 0;
+    }
+
+    std::cout << "500 random grammars, " << numValid << " LALR(1)" << std::endl;
+    if(failures > 0) {
+        std::cout << failures << " grammars differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
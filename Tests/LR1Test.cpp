@@ -0,0 +1,144 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Parser/Impl/GLR.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LR1.hpp"
+
+#include "Tests/Common.hpp"
+
+// Checks the LR(1) tables built with Pager's merging.  Every grammar LALR accepts must be accepted by
+// LR1 too, and wherever LR1 accepts a grammar, its parse of each input must be the single derivation
+// GLR finds, or fail where GLR finds none.  A grammar which is LR(1) but not LALR(1), where merging
+// states by core alone would give a reduce/reduce conflict, must be rejected by LALR and accepted by
+// LR1.
+//
+// Usage: lr1test <source dir>
+
+typedef Parser::Grammar::Symbol Symbol;
+
+static Symbol terminal(unsigned int index)
+{
+    return Symbol{Symbol::Type::Terminal, index};
+}
+
+static Symbol nonterminal(unsigned int index)
+{
+    return Symbol{Symbol::Type::Nonterminal, index};
+}
+
+// Builds a tokenizer whose patterns are the terminals, apart from the END terminal last.
+static Parser::Tokenizer createTokenizer(const std::vector<std::string> &terminals)
+{
+    std::vector<Parser::Tokenizer::Pattern> patterns;
+    unsigned int end = (unsigned int)terminals.size() - 1;
+    for(unsigned int i=0; i<end; i++) {
+        patterns.push_back(Parser::Tokenizer::Pattern{terminals[i], terminals[i], i});
+    }
+    patterns.push_back(Parser::Tokenizer::Pattern{"\\s", "IGNORE", Parser::Tokenizer::kInvalidTokenValue});
+
+    return Parser::Tokenizer({Parser::Tokenizer::Configuration{std::move(patterns)}}, end, Parser::Tokenizer::kInvalidTokenValue);
+}
+
+int main(int argc, char *argv[])
+{
+    if(!Tests::checkUsage(argc, argv)) {
+        return 1;
+    }
+
+    unsigned int failures = 0;
+    unsigned int numParsed = 0;
+    // Returns false if LR1 rejected the grammar.
+    auto check = [&](const std::string &name, const Parser::Grammar &grammar, const Parser::Tokenizer &tokenizer, const std::vector<std::string> &inputs) {
+        Parser::Impl::LR1 lr1(grammar);
+        if(!lr1.valid()) {
+            return false;
+        }
+        Parser::Impl::LR1::ParseSession<std::string, std::shared_ptr<std::string>> lr1Session(lr1);
+        Tests::addDerivationReducers(lr1Session, grammar);
+
+        Parser::Impl::GLR glr(grammar);
+        Parser::Impl::GLR::ParseSession<std::string> glrSession(glr);
+        Tests::addDerivationReducers(glrSession, grammar);
+
+        for(const std::string &input : inputs) {
+            std::vector<std::string> expected = Tests::derivations(glrSession, tokenizer, input);
+            Parser::Tokenizer::Stream stream(tokenizer, input);
+            std::shared_ptr<std::string> actual = lr1Session.parse(stream);
+            numParsed += actual ? 1 : 0;
+            if(expected.size() > 1 || expected.empty() != !actual || (actual && *actual != expected[0])) {
+                std::cout << name << ", \"" << input << "\": LR1 returned " << (actual ? *actual : std::string("null")) << ", GLR found " << expected.size() << " derivations";
+                if(!expected.empty()) {
+                    std::cout << ", the first " << expected[0];
+                }
+                std::cout << std::endl;
+                failures++;
+            }
+        }
+
+        return true;
+    };
+
+    // S: 'a' E 'c' | 'a' F 'd' | 'b' F 'c' | 'b' E 'd'
+    // E: 'e'
+    // F: 'e'
+    Parser::Grammar lr1Only({"a", "b", "c", "d", "e", "END"}, {
+        Parser::Grammar::Rule{"root", {{nonterminal(1), terminal(5)}}},
+        Parser::Grammar::Rule{"S", {
+            {terminal(0), nonterminal(2), terminal(2)},
+            {terminal(0), nonterminal(3), terminal(3)},
+            {terminal(1), nonterminal(3), terminal(2)},
+            {terminal(1), nonterminal(2), terminal(3)}
+        }},
+        Parser::Grammar::Rule{"E", {{terminal(4)}}},
+        Parser::Grammar::Rule{"F", {{terminal(4)}}}
+    }, 0);
+    if(Parser::Impl::LALR(lr1Only).valid()) {
+        std::cout << "LR(1) grammar: accepted by LALR" << std::endl;
+        failures++;
+    }
+    if(!check("LR(1) grammar", lr1Only, createTokenizer(lr1Only.terminals()), {"a e c", "a e d", "b e c", "b e d", "a e", "b c", "a e c d"})) {
+        std::cout << "LR(1) grammar: rejected by LR1" << std::endl;
+        failures++;
+    }
+
+    std::mt19937 random(1);
+    Parser::Tokenizer tokenizer = createTokenizer({"a", "b", "c", "END"});
+    unsigned int numLALR = 0;
+    unsigned int numLR1 = 0;
+    for(unsigned int i=0; i<500; i++) {
+        Parser::Grammar grammar = Tests::randomGrammar(random, 5);
+        std::stringstream ss;
+        ss << "random grammar " << i;
+
+        std::vector<std::string> inputs;
+        for(unsigned int j=0; j<20; j++) {
+            std::string input;
+            unsigned int length = random() % 6;
+            for(unsigned int k=0; k<length; k++) {
+                input += (k == 0 ? "" : " ") + std::string(1, (char)('a' + random() % 3));
+            }
+            inputs.push_back(input);
+        }
+
+        bool lalr = Parser::Impl::LALR(grammar).valid();
+        bool lr1 = check(ss.str(), grammar, tokenizer, inputs);
+        if(lalr && !lr1) {
+            std::cout << ss.str() << ": accepted by LALR, rejected by LR1" << std::endl;
+            failures++;
+        }
+        numLALR += lalr ? 1 : 0;
+        numLR1 += lr1 ? 1 : 0;
+    }
+
+    std::cout << "500 random grammars, " << numLALR << " LALR(1), " << numLR1 << " LR(1), " << numParsed << " inputs parsed" << std::endl;
+    if(failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
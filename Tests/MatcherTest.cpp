@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Regex/BitNFA.hpp"
+#include "Regex/ClassScanner.hpp"
+#include "Regex/DFA.hpp"
+#include "Regex/FlatDFA.hpp"
+#include "Regex/LazyDFA.hpp"
+#include "Regex/Matcher.hpp"
+
+// Checks the regex engines against a plain walk of the eager DFA.  Each check runs over a set of
+// random patterns, matched against short random inputs from a random starting offset.
+//
+// Usage: matchertest
+
+struct PatternSet {
+    PatternSet(std::vector<std::string> p)
+    : patterns(std::move(p))
+    {
+        for(const std::string &pattern : patterns) {
+            nodes.push_back(Regex::Parser::parse(pattern));
+        }
+        encoding = std::make_unique<Regex::Encoding>(nodes);
+        nfa = std::make_unique<Regex::NFA>(nodes, *encoding);
+        dfa = std::make_unique<Regex::DFA>(*nfa, *encoding);
+    }
+
+    // The reference, which walks the eager DFA one character at a time.
+    unsigned int match(std::string_view string, unsigned int start, unsigned int &pattern) const
+    {
+        unsigned int state = dfa->startState();
+        unsigned int matched = 0;
+        for(unsigned int i=start; i<string.size(); i++) {
+            Regex::Encoding::CodePoint codePoint = encoding->codePoint(string[i]);
+            if(codePoint == Regex::Encoding::kInvalidCodePoint) {
+                break;
+            }
+            state = dfa->transition(state, codePoint);
+            if(state == dfa->rejectState()) {
+                break;
+            }
+            if(dfa->accept(state, pattern)) {
+                matched = (i - start) + 1;
+            }
+        }
+
+        return matched;
+    }
+
+    std::string describe() const
+    {
+        std::stringstream ss;
+        for(const std::string &pattern : patterns) {
+            ss << "/" << pattern << "/ ";
+        }
+        return ss.str();
+    }
+
+    std::vector<std::string> patterns;
+    std::vector<std::unique_ptr<Regex::Parser::Node>> nodes;
+    std::unique_ptr<Regex::Encoding> encoding;
+    std::unique_ptr<Regex::NFA> nfa;
+    std::unique_ptr<Regex::DFA> dfa;
+};
+
+// Builds a pattern from a few characters, classes, alternations and repetitions.  Some are plain
+// literals, so that Matcher also builds its literal-prefix prefilter.
+static std::string randomPattern(std::mt19937 &random, unsigned int depth)
+{
+    static const char *const kAtoms[] = {"a", "b", "c", "d", "[a-c]", "[bd]", "[^a]", "\\s"};
+
+    if(depth == 2 && random() % 4 == 0) {
+        std::string literal;
+        unsigned int length = 1 + random() % 4;
+        for(unsigned int i=0; i<length; i++) {
+            literal += (char)('a' + random() % 4);
+        }
+        return literal;
+    }
+
+    std::string pattern;
+    unsigned int length = 1 + random() % 3;
+    for(unsigned int i=0; i<length; i++) {
+        std::string element;
+        if(depth > 0 && random() % 4 == 0) {
+            element = "(" + randomPattern(random, depth - 1) + "|" + randomPattern(random, depth - 1) + ")";
+        } else {
+            element = kAtoms[random() % 8];
+        }
+
+        switch(random() % 6) {
+            case 0: element += "*"; break;
+            case 1: element += "+"; break;
+            case 2: element += "?"; break;
+            default: break;
+        }
+        pattern += element;
+    }
+
+    return pattern;
+}
+
+static std::string randomInput(std::mt19937 &random, unsigned int maxLength)
+{
+    static const char kCharacters[] = {'a', 'b', 'c', 'd', 'e', ' '};
+
+    std::string input;
+    unsigned int length = random() % (maxLength + 1);
+    for(unsigned int i=0; i<length; i++) {
+        input += kCharacters[random() % 6];
+    }
+
+    return input;
+}
+
+// Compares an engine's match with the reference on random inputs, reporting the first difference.
+template<typename Match> unsigned int compareMatches(const char *name, const PatternSet &set, std::mt19937 &random, Match match)
+{
+    for(unsigned int i=0; i<50; i++) {
+        std::string input = randomInput(random, 12);
+        unsigned int start = input.empty() ? 0 : random() % input.size();
+
+        unsigned int expectedPattern = UINT_MAX;
+        unsigned int expected = set.match(input, start, expectedPattern);
+        unsigned int pattern = UINT_MAX;
+        unsigned int matched = match(input, start, pattern);
+        if(matched != expected || (expected > 0 && pattern != expectedPattern)) {
+            std::cout << name << ": " << set.describe() << "on \"" << input << "\" from " << start << " matched " << matched << " of pattern " << pattern << ", expected " << expected << " of pattern " << expectedPattern << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// LazyDFA is checked once with the default cache and once with a cache small enough to be flushed
+// in the middle of a match.
+static unsigned int checkLazyDFA(const PatternSet &set, std::mt19937 &random)
+{
+    unsigned int failures = 0;
+
+    Regex::LazyDFA lazyDFA(*set.nfa, *set.encoding);
+    failures += compareMatches("LazyDFA", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+        return lazyDFA.match(string, start, pattern);
+    });
+
+    Regex::LazyDFA flushedLazyDFA(*set.nfa, *set.encoding, 256);
+    failures += compareMatches("LazyDFA with a small cache", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+        return flushedLazyDFA.match(string, start, pattern);
+    });
+
+    return failures;
+}
+
+// The minimized DFA must have no two equivalent states.  Moore's refinement, starting from the
+// accepted pattern of each state, must end with as many blocks as the DFA has states.
+static unsigned int checkMinimal(const PatternSet &set)
+{
+    const Regex::DFA &dfa = *set.dfa;
+    std::vector<unsigned int> blocks(dfa.numStates());
+    for(unsigned int i=0; i<dfa.numStates(); i++) {
+        unsigned int pattern = UINT_MAX;
+        dfa.accept(i, pattern);
+        blocks[i] = pattern;
+    }
+
+    unsigned int numBlocks = 0;
+    while(true) {
+        std::map<std::vector<unsigned int>, unsigned int> signatures;
+        std::vector<unsigned int> newBlocks(dfa.numStates());
+        for(unsigned int i=0; i<dfa.numStates(); i++) {
+            std::vector<unsigned int> signature{blocks[i]};
+            for(unsigned int j=0; j<dfa.numCodePoints(); j++) {
+                signature.push_back(blocks[dfa.transition(i, j)]);
+            }
+            newBlocks[i] = signatures.emplace(std::move(signature), (unsigned int)signatures.size()).first->second;
+        }
+
+        blocks = std::move(newBlocks);
+        if(signatures.size() == numBlocks) {
+            break;
+        }
+        numBlocks = (unsigned int)signatures.size();
+    }
+
+    if(numBlocks != dfa.numStates()) {
+        std::cout << "DFA::minimize: " << set.describe() << "left " << dfa.numStates() << " states, minimal is " << numBlocks << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static void collectRanges(const Regex::Parser::Node &node, std::vector<std::pair<int, int>> &ranges)
+{
+    switch(node.type) {
+        case Regex::Parser::Node::Type::Symbol:
+        {
+            const auto &symbolNode = static_cast<const Regex::Parser::SymbolNode&>(node);
+            ranges.push_back(std::make_pair((int)symbolNode.symbol, (int)symbolNode.symbol));
+            break;
+        }
+
+        case Regex::Parser::Node::Type::CharacterClass:
+            for(const auto &range : static_cast<const Regex::Parser::CharacterClassNode&>(node).ranges) {
+                ranges.push_back(std::make_pair((int)range.first, (int)range.second));
+            }
+            break;
+
+        case Regex::Parser::Node::Type::OneOf:
+            for(const auto &child : static_cast<const Regex::Parser::OneOfNode&>(node).nodes) {
+                collectRanges(*child, ranges);
+            }
+            break;
+
+        case Regex::Parser::Node::Type::Sequence:
+            for(const auto &child : static_cast<const Regex::Parser::SequenceNode&>(node).nodes) {
+                collectRanges(*child, ranges);
+            }
+            break;
+
+        case Regex::Parser::Node::Type::ZeroOrOne:
+            collectRanges(*static_cast<const Regex::Parser::ZeroOrOneNode&>(node).node, ranges);
+            break;
+
+        case Regex::Parser::Node::Type::ZeroOrMore:
+            collectRanges(*static_cast<const Regex::Parser::ZeroOrMoreNode&>(node).node, ranges);
+            break;
+
+        case Regex::Parser::Node::Type::OneOrMore:
+            collectRanges(*static_cast<const Regex::Parser::OneOrMoreNode&>(node).node, ranges);
+            break;
+    }
+}
+
+// Every character in some range of the patterns must have a code point, and two neighbouring
+// characters must share one exactly when no range starts or ends between them.
+static unsigned int checkEncoding(const PatternSet &set)
+{
+    std::vector<std::pair<int, int>> ranges;
+    for(const auto &node : set.nodes) {
+        collectRanges(*node, ranges);
+    }
+
+    std::vector<bool> covered(128, false);
+    std::vector<bool> boundary(129, false);
+    for(const auto &range : ranges) {
+        for(int c=range.first; c<=range.second; c++) {
+            covered[c] = true;
+        }
+        boundary[range.first] = true;
+        boundary[range.second + 1] = true;
+    }
+
+    const Regex::Encoding &encoding = *set.encoding;
+    unsigned int numCodePoints = 0;
+    for(int c=0; c<128; c++) {
+        Regex::Encoding::CodePoint codePoint = encoding.codePoint((char)c);
+        bool valid = codePoint != Regex::Encoding::kInvalidCodePoint;
+        bool expectNew = covered[c] && (c == 0 || !covered[c - 1] || boundary[c]);
+        bool same = c > 0 && covered[c] && covered[c - 1] && codePoint == encoding.codePoint((char)(c - 1));
+        if(valid != covered[c] || (covered[c] && same == expectNew)) {
+            std::cout << "Encoding: " << set.describe() << "gave character " << c << " the wrong code point" << std::endl;
+            return 1;
+        }
+        numCodePoints += expectNew ? 1 : 0;
+    }
+
+    if(numCodePoints != encoding.numCodePoints()) {
+        std::cout << "Encoding: " << set.describe() << "has " << encoding.numCodePoints() << " code points, expected " << numCodePoints << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// BitNFA is checked directly, and Matcher with maxDFAStates 0 falls back to it, or to LazyDFA for
+// sets with too many positions.
+static unsigned int checkBitNFA(const PatternSet &set, std::mt19937 &random)
+{
+    unsigned int failures = 0;
+
+    Regex::BitNFA bitNFA(*set.nfa, *set.encoding);
+    if(bitNFA.valid()) {
+        failures += compareMatches("BitNFA", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+            return bitNFA.match(string, start, pattern);
+        });
+    }
+
+    Regex::Matcher matcher(set.patterns, 0);
+    failures += compareMatches("Matcher without a DFA", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+        return matcher.match(string, start, pattern);
+    });
+
+    return failures;
+}
+
+// Matcher::find must return the first offset at which the reference matches, with the same match,
+// both with and without a DFA behind it.
+static unsigned int checkFind(const PatternSet &set, std::mt19937 &random)
+{
+    Regex::Matcher matcher(set.patterns);
+    Regex::Matcher fallbackMatcher(set.patterns, 0);
+
+    for(unsigned int i=0; i<20; i++) {
+        std::string input = randomInput(random, 40);
+        unsigned int from = input.empty() ? 0 : random() % input.size();
+
+        unsigned int expected = UINT_MAX;
+        unsigned int expectedLength = 0;
+        unsigned int expectedPattern = UINT_MAX;
+        for(unsigned int pos=from; pos<input.size(); pos++) {
+            expectedLength = set.match(input, pos, expectedPattern);
+            if(expectedLength > 0) {
+                expected = pos;
+                break;
+            }
+        }
+
+        for(const Regex::Matcher *m : {&matcher, &fallbackMatcher}) {
+            unsigned int length = 0;
+            unsigned int pattern = UINT_MAX;
+            unsigned int found = m->find(input, from, length, pattern);
+            if(found != expected || (expected != UINT_MAX && (length != expectedLength || pattern != expectedPattern))) {
+                std::cout << "Matcher::find: " << set.describe() << "on \"" << input << "\" from " << from << " found " << found << ", expected " << expected << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static unsigned int checkFlatDFA(const PatternSet &set, std::mt19937 &random)
+{
+    unsigned int failures = 0;
+
+    if(set.dfa->numStates() <= Regex::FlatDFA::kMaxStates) {
+        Regex::FlatDFA flatDFA(*set.dfa, *set.encoding);
+        failures += compareMatches("FlatDFA", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+            return flatDFA.match(string, start, pattern);
+        });
+    }
+
+    Regex::Matcher matcher(set.patterns);
+    failures += compareMatches("Matcher", set, random, [&](std::string_view string, unsigned int start, unsigned int &pattern) {
+        return matcher.match(string, start, pattern);
+    });
+
+    return failures;
+}
+
+// Scans runs of bytes from random sets of one to six ranges, some above 127, against skipping one
+// byte at a time.  Sets of more than four ranges are scanned without SIMD.
+static unsigned int checkScanner(std::mt19937 &random)
+{
+    Regex::ClassScanner::ByteSet bytes;
+    unsigned int numRanges = 1 + random() % 6;
+    for(unsigned int i=0; i<numRanges; i++) {
+        unsigned int first = random() % 256;
+        unsigned int last = std::min(255u, first + (unsigned int)(random() % 8));
+        for(unsigned int b=first; b<=last; b++) {
+            bytes.set(b);
+        }
+    }
+
+    std::vector<unsigned char> members;
+    for(unsigned int b=0; b<256; b++) {
+        if(bytes[b]) {
+            members.push_back((unsigned char)b);
+        }
+    }
+
+    Regex::ClassScanner scanner(bytes);
+    for(unsigned int i=0; i<20; i++) {
+        std::string input;
+        unsigned int length = random() % 100;
+        for(unsigned int j=0; j<length; j++) {
+            input += (random() % 16 == 0) ? (char)(random() % 256) : (char)members[random() % members.size()];
+        }
+
+        unsigned int start = input.empty() ? 0 : random() % input.size();
+        unsigned int expected = start;
+        while(expected < input.size() && bytes[(unsigned char)input[expected]]) {
+            expected++;
+        }
+
+        unsigned int skipped = scanner.skip(input, start);
+        if(skipped != expected) {
+            std::cout << "ClassScanner: " << numRanges << " ranges, skipped to " << skipped << " of " << input.size() << " from " << start << ", expected " << expected << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// A skip scanner is built from the ignored patterns which are class runs, alongside a comment, but
+// not when another ignored pattern can start with a byte it would skip.
+static unsigned int checkSkipScanner()
+{
+    Regex::Matcher matcher({"\\s+", "#[a-z]*", "[a-z]+"});
+    std::unique_ptr<Regex::ClassScanner> scanner = matcher.createSkipScanner({0, 1});
+    if(!scanner || scanner->skip("  \t #x", 0) != 4) {
+        std::cout << "Matcher::createSkipScanner: whitespace was not skipped beside a comment" << std::endl;
+        return 1;
+    }
+
+    Regex::Matcher overlapping({"\\s+", "[ #][a-z]*", "[a-z]+"});
+    if(overlapping.createSkipScanner({0, 1})) {
+        std::cout << "Matcher::createSkipScanner: built a scanner over the start of another pattern" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int, char *[])
+{
+    std::mt19937 random(1);
+    unsigned int failures = 0;
+
+    for(unsigned int i=0; i<500; i++) {
+        std::vector<std::string> patterns;
+        unsigned int numPatterns = 1 + random() % 4;
+        for(unsigned int j=0; j<numPatterns; j++) {
+            patterns.push_back(randomPattern(random, 2));
+        }
+
+        PatternSet set(std::move(patterns));
+        failures += checkLazyDFA(set, random);
+        failures += checkMinimal(set);
+        failures += checkEncoding(set);
+        failures += checkBitNFA(set, random);
+        failures += checkFind(set, random);
+        failures += checkFlatDFA(set, random);
+    }
+
+    for(unsigned int i=0; i<500; i++) {
+        failures += checkScanner(random);
+    }
+    failures += checkSkipScanner();
+
+    if(failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
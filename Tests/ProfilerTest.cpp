@@ -0,0 +1,210 @@
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+#include "Parser/Profiler.hpp"
+
+#include "Tests/Common.hpp"
+
+// Parses a fixed calculator input with profiled LALR and LL sessions and checks the counters: the
+// exact numbers of tokens, shifts and reductions of each rule, times which nest within the parse
+// time, and JSON output which parses and holds the same counts.  Both sessions see the same
+// derivation, so LL's matched terminals and expansions agree with LALR's shifts and reductions.
+//
+// Usage: profilertest <source dir>
+
+// Reads the JSON that ProfileCounters::writeJson produces, which is objects, strings and numbers,
+// recording each number under its path of keys separated by '/'.  Returns false if the text is not
+// valid JSON of that kind.
+class JsonReader
+{
+public:
+    JsonReader(const std::string &text) : mText(text), mPos(0) {}
+
+    bool read(std::map<std::string, unsigned long long> &numbers)
+    {
+        if(!readValue("", numbers)) {
+            return false;
+        }
+        skipSpace();
+        return mPos == mText.size();
+    }
+
+private:
+    void skipSpace()
+    {
+        while(mPos < mText.size() && std::isspace((unsigned char)mText[mPos])) {
+            mPos++;
+        }
+    }
+
+    bool readString(std::string &string)
+    {
+        if(mPos >= mText.size() || mText[mPos] != '"') {
+            return false;
+        }
+        for(mPos++; mPos < mText.size() && mText[mPos] != '"'; mPos++) {
+            if(mText[mPos] == '\\') {
+                mPos++;
+                if(mPos >= mText.size() || (mText[mPos] != '"' && mText[mPos] != '\\')) {
+                    return false;
+                }
+            }
+            string.push_back(mText[mPos]);
+        }
+        if(mPos >= mText.size()) {
+            return false;
+        }
+        mPos++;
+        return true;
+    }
+
+    bool readValue(const std::string &path, std::map<std::string, unsigned long long> &numbers)
+    {
+        skipSpace();
+        if(mPos >= mText.size()) {
+            return false;
+        }
+
+        if(std::isdigit((unsigned char)mText[mPos])) {
+            size_t start = mPos;
+            while(mPos < mText.size() && std::isdigit((unsigned char)mText[mPos])) {
+                mPos++;
+            }
+            numbers[path] = std::stoull(mText.substr(start, mPos - start));
+            return true;
+        }
+
+        if(mText[mPos] != '{') {
+            return false;
+        }
+        mPos++;
+        skipSpace();
+        if(mPos < mText.size() && mText[mPos] == '}') {
+            mPos++;
+            return true;
+        }
+        while(true) {
+            std::string key;
+            skipSpace();
+            if(!readString(key)) {
+                return false;
+            }
+            skipSpace();
+            if(mPos >= mText.size() || mText[mPos] != ':') {
+                return false;
+            }
+            mPos++;
+            if(!readValue(path.empty() ? key : path + "/" + key, numbers)) {
+                return false;
+            }
+            skipSpace();
+            if(mPos < mText.size() && mText[mPos] == ',') {
+                mPos++;
+            } else if(mPos < mText.size() && mText[mPos] == '}') {
+                mPos++;
+                return true;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    const std::string &mText;
+    size_t mPos;
+};
+
+// "(1+2)*3" shifts its seven tokens and END.  F is reduced for each number and for the parenthesized
+// expression, and the loop rules E.1 and T.1 once for each repetition and once more where they end.
+static const std::map<std::string, unsigned long long> kExpectedRules = {
+    {"root", 1},
+    {"E", 2},
+    {"T", 3},
+    {"F", 4},
+    {"E.1", 3},
+    {"E.1.1", 1},
+    {"T.1", 4},
+    {"T.1.1", 1}
+};
+
+template<typename Session> unsigned int check(const char *name, Session &session, const Parser::DefReader &reader)
+{
+    unsigned int failures = 0;
+    auto fail = [&](const std::string &message) {
+        std::cout << name << ": " << message << std::endl;
+        failures++;
+    };
+
+    Tests::addCalcReducers(session, reader.grammar(), [](int value) { return value; });
+    Parser::Tokenizer::Stream stream(reader.tokenizer(), "(1+2)*3");
+    if(session.parse(stream) != 9) {
+        fail("wrong result");
+    }
+
+    const Parser::ProfileCounters &counters = session.profiler().counters();
+    if(counters.tokens != 8 || counters.shifts != 8 || counters.reductions != 19) {
+        std::stringstream ss;
+        ss << counters.tokens << " tokens, " << counters.shifts << " shifts, " << counters.reductions << " reductions";
+        fail(ss.str());
+    }
+    for(const auto &it : kExpectedRules) {
+        unsigned int rule = reader.grammar().ruleIndex(it.first);
+        unsigned long long count = (rule < counters.ruleReductions.size()) ? counters.ruleReductions[rule] : 0;
+        if(count != it.second) {
+            fail(it.first + " reduced " + std::to_string(count) + " times");
+        }
+    }
+
+    if(counters.parseTime == 0 || counters.tokenizerTime + counters.reducerTime > counters.parseTime || counters.tableTime() > counters.parseTime) {
+        fail("tokenizer and reducer times are not within the parse time");
+    }
+
+    std::stringstream json;
+    counters.writeJson(json, reader.grammar());
+    std::map<std::string, unsigned long long> numbers;
+    if(!JsonReader(json.str()).read(numbers)) {
+        fail("invalid JSON:\n" + json.str());
+    } else {
+        bool matches = numbers["tokens"] == counters.tokens && numbers["shifts"] == counters.shifts && numbers["reductions"] == counters.reductions;
+        matches = matches && numbers["timeNs/parse"] == counters.parseTime && numbers["timeNs/tables"] == counters.tableTime();
+        for(const auto &it : kExpectedRules) {
+            matches = matches && numbers["rules/" + it.first] == it.second;
+        }
+        if(!matches) {
+            fail("JSON differs from the counters:\n" + json.str());
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::DefReader &reader = *defReader;
+
+    unsigned int failures = 0;
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    Parser::Impl::LALR::ParseSession<int, int, Parser::Profiler> lalrSession(lalr);
+    failures += check("LALR", lalrSession, reader);
+
+    Parser::Impl::LL ll(reader.grammar());
+    Parser::Impl::LL::ParseSession<int, int, Parser::Profiler> llSession(ll);
+    failures += check("LL", llSession, reader);
+
+    if(failures > 0) {
+        std::cout << failures << " checks failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+
+#include "Tests/Common.hpp"
+
+// Feeds calculator documents to push-mode sessions in chunks of one to five bytes and checks each
+// result against a full parse of the same text.  Documents span several lines, some end without a
+// newline, and a quarter of them are damaged so that the push parse must also fail where the full
+// parse does.
+//
+// Usage: pushparsetest <source dir>
+
+// Builds a random expression, breaking lines between tokens now and then.
+static void randomExpression(std::mt19937 &random, std::string &document, unsigned int depth)
+{
+    unsigned int numTerms = 1 + random() % 4;
+    for(unsigned int i=0; i<numTerms; i++) {
+        if(i > 0) {
+            document += "+-*/"[random() % 4];
+        }
+        if(random() % 4 == 0) {
+            document += (random() % 2 == 0) ? "\n" : " ";
+        }
+        if(depth < 3 && random() % 5 == 0) {
+            document += "(";
+            randomExpression(random, document, depth + 1);
+            document += ")";
+        } else {
+            document += std::to_string(random() % 1000);
+        }
+    }
+}
+
+static std::string randomDocument(std::mt19937 &random)
+{
+    static const char *const kDamage[] = {"+", "(", ")", "x", "\n)", "1 2", "*\n"};
+
+    std::string document;
+    randomExpression(random, document, 0);
+    if(random() % 4 == 0) {
+        size_t position = random() % (document.size() + 1);
+        document.insert(position, kDamage[random() % 7]);
+    }
+    if(random() % 2 == 0) {
+        document += "\n";
+    }
+
+    return document;
+}
+
+template<typename Session> unsigned int check(const char *name, Session &session, const Parser::Tokenizer &tokenizer, const std::string &document, std::mt19937 &random)
+{
+    Parser::Tokenizer::Stream stream(tokenizer, document);
+    std::shared_ptr<int> expected = session.parse(stream);
+
+    // Once feed() reports an error the document can no longer parse, so the rest is not fed.
+    session.start(tokenizer);
+    bool fedValid = true;
+    for(size_t position = 0; position < document.size() && fedValid;) {
+        size_t length = std::min<size_t>(1 + random() % 5, document.size() - position);
+        fedValid = session.feed(std::string_view(document).substr(position, length));
+        position += length;
+    }
+    std::shared_ptr<int> result = session.finish();
+
+    if(!expected != !result || (expected && *expected != *result) || (!fedValid && expected)) {
+        std::cout << name << ": \"" << document << "\" returned ";
+        if(result) {
+            std::cout << *result;
+        } else {
+            std::cout << "null";
+        }
+        std::cout << ", full parse returned ";
+        if(expected) {
+            std::cout << *expected;
+        } else {
+            std::cout << "null";
+        }
+        std::cout << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::DefReader &reader = *defReader;
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    Parser::Impl::LALR::ParseSession<int, std::shared_ptr<int>> lalrSession(lalr);
+    Tests::addCalcReducers(lalrSession, reader.grammar(), [](int value) { return std::make_shared<int>(value); });
+
+    Parser::Impl::LL ll(reader.grammar());
+    Parser::Impl::LL::ParseSession<int, std::shared_ptr<int>> llSession(ll);
+    Tests::addCalcReducers(llSession, reader.grammar(), [](int value) { return std::make_shared<int>(value); });
+
+    std::mt19937 random(1);
+    unsigned int failures = 0;
+    unsigned int numValid = 0;
+    for(unsigned int i=0; i<3000 && failures < 10; i++) {
+        std::string document = randomDocument(random);
+        Parser::Tokenizer::Stream stream(reader.tokenizer(), document);
+        numValid += lalrSession.parse(stream) ? 1 : 0;
+
+        failures += check("LALR", lalrSession, reader.tokenizer(), document, random);
+        failures += check("LL", llSession, reader.tokenizer(), document, random);
+    }
+
+    std::cout << "3000 documents, " << numValid << " valid" << std::endl;
+    if(failures > 0) {
+        std::cout << failures << " push parses differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/GLR.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+
+#include "Tests/Common.hpp"
+
+// Parses calculator input with sessions whose DataPointer is a raw pointer into the session's arena,
+// so that a result the session never assigned would be garbage rather than null.  Inputs with a
+// syntax error must return null, and the session must still parse valid input afterwards.
+//
+// Usage: rawpointertest <source dir>
+
+struct Case {
+    std::string_view input;
+    bool valid;
+    int result;
+};
+
+static const Case kCases[] = {
+    {"1+", false, 0},
+    {"1+2*3", true, 7},
+    {"(4-", false, 0},
+    {"1+x", false, 0},
+    {"", false, 0},
+    {"12*(3+4)-5", true, 79},
+    {"1 2", false, 0}
+};
+
+template<typename Session, typename Parse> unsigned int check(const char *name, Session &session, const Parser::Tokenizer &tokenizer, Parse parse)
+{
+    unsigned int failures = 0;
+    for(const Case &c : kCases) {
+        Parser::Tokenizer::Stream stream(tokenizer, c.input);
+        int *result = parse(session, stream);
+        if(c.valid ? (!result || *result != c.result) : result != nullptr) {
+            std::cout << name << ": \"" << c.input << "\" returned ";
+            if(result) {
+                std::cout << *result;
+            } else {
+                std::cout << "null";
+            }
+            std::cout << std::endl;
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::DefReader &reader = *defReader;
+
+    unsigned int failures = 0;
+
+    Parser::Impl::LL ll(reader.grammar());
+    Parser::Impl::LL::ParseSession<int, int*> llSession(ll);
+    Tests::addCalcReducers(llSession, reader.grammar(), [&](int value) { return llSession.arena().make<int>(value); });
+    failures += check("LL", llSession, reader.tokenizer(), [](auto &session, Parser::Tokenizer::Stream &stream) {
+        return session.parse(stream);
+    });
+
+    Parser::Impl::LALR lalr(reader.grammar());
+    Parser::Impl::LALR::ParseSession<int, int*> lalrSession(lalr);
+    Tests::addCalcReducers(lalrSession, reader.grammar(), [&](int value) { return lalrSession.arena().make<int>(value); });
+    failures += check("LALR", lalrSession, reader.tokenizer(), [](auto &session, Parser::Tokenizer::Stream &stream) {
+        return session.parse(stream);
+    });
+
+    Parser::Impl::GLR glr(reader.grammar());
+    Parser::Impl::GLR::ParseSession<int, int*> glrSession(glr);
+    Tests::addCalcReducers(glrSession, reader.grammar(), [&](int value) { return glrSession.arena().make<int>(value); });
+    failures += check("GLR", glrSession, reader.tokenizer(), [](auto &session, Parser::Tokenizer::Stream &stream) {
+        return session.evaluate(session.parseForest(stream));
+    });
+
+    if(failures > 0) {
+        std::cout << failures << " parses failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
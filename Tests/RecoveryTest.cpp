@@ -0,0 +1,158 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Impl/LALR.hpp"
+#include "Parser/Impl/LL.hpp"
+
+#include "Tests/Common.hpp"
+
+// Parses broken input with recovery enabled and checks the diagnostics reported and the values the
+// reducers produce after resynchronizing.  Tests/recovery.def is the calculator with statements and
+// an error production, so a broken statement is replaced by error and the rest are still evaluated;
+// calc.def has no error terminal, so recovery there discards tokens until the parse can go on.
+//
+// Usage: recoverytest <source dir>
+
+struct Case {
+    std::string_view input;
+    bool valid;
+    std::vector<int> values;
+    std::vector<Parser::Diagnostic> diagnostics;
+};
+
+// Statements are separated by ';', and one replaced by error has the value -1.  A diagnostic's
+// start is the column of the token in its line.
+static const std::vector<Case> kStatementCases = {
+    {"1+2;\n3*4;\n", true, {3, 12}, {}},
+    {"1+2;\n3*;\n4;\n", true, {3, -1, 4}, {{2, 2, "Unexpected symbol ;"}}},
+    {"1+2;\n(3 4);\n5*6;", true, {3, -1, 30}, {{2, 3, "Unexpected symbol 4"}}},
+    {"1 2 3;4;\n", true, {-1, 4}, {{1, 2, "Unexpected symbol 2"}}},
+    {"1+;2+;3;\n", true, {-1, -1, 3}, {{1, 2, "Unexpected symbol ;"}, {1, 5, "Unexpected symbol ;"}}},
+    {"1+;2;3;4+;\n", true, {-1, 2, 3, -1}, {{1, 2, "Unexpected symbol ;"}, {1, 9, "Unexpected symbol ;"}}},
+    {"1+2;\n3*", false, {}, {{2, 2, "Unexpected symbol <end>"}}}
+};
+
+// calc.def has a single expression, whose value is the only one.  Tokens no state can use are
+// discarded; a stray ')' is only found once the expression before it has been reduced, so the
+// tokens after it are discarded as well.
+static const std::vector<Case> kPanicCases = {
+    {"1+*2\n", true, {3}, {{1, 2, "Unexpected symbol *"}}},
+    {"1+2+*3\n", true, {6}, {{1, 4, "Unexpected symbol *"}}},
+    {"(1+2))*3\n", true, {3}, {{1, 5, "Unexpected symbol )"}}},
+    {"1+2\n)", true, {3}, {{2, 0, "Unexpected symbol )"}}},
+    {"(1+2\n", false, {}, {{2, 0, "Unexpected symbol <end>"}}}
+};
+
+template<typename Session> unsigned int check(const char *name, Session &session, const Parser::Tokenizer &tokenizer, const std::vector<Case> &cases, std::vector<int> &values)
+{
+    unsigned int failures = 0;
+    for(const Case &c : cases) {
+        values.clear();
+        Parser::Tokenizer::Stream stream(tokenizer, c.input);
+        std::shared_ptr<int> result = session.parse(stream);
+        const std::vector<Parser::Diagnostic> &diagnostics = session.diagnostics();
+
+        bool matches = (!result == !c.valid) && (!result || values == c.values) && diagnostics.size() == c.diagnostics.size();
+        for(size_t i=0; matches && i<diagnostics.size(); i++) {
+            const Parser::Diagnostic &expected = c.diagnostics[i];
+            matches = diagnostics[i].line == expected.line && diagnostics[i].start == expected.start && diagnostics[i].message == expected.message;
+        }
+
+        if(!matches) {
+            std::cout << name << ": \"" << c.input << "\" returned ";
+            if(result) {
+                std::cout << "values";
+                for(int value : values) {
+                    std::cout << " " << value;
+                }
+            } else {
+                std::cout << "null";
+            }
+            std::cout << ", diagnostics";
+            for(const Parser::Diagnostic &diagnostic : diagnostics) {
+                std::cout << " (" << diagnostic.line << ", " << diagnostic.start << ", \"" << diagnostic.message << "\")";
+            }
+            std::cout << std::endl;
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+// The root reducer collects the value of each statement, skipping the END terminal after them,
+// and a statement which is error ';' has the value -1.
+template<typename Session> void addStatementReducers(Session &session, const Parser::Grammar &grammar, std::vector<int> &values)
+{
+    Tests::addCalcReducers(session, grammar, [](int value) { return std::make_shared<int>(value); });
+
+    session.addReducer("S", [](auto begin, auto end) {
+        return (end - begin == 2 && !begin->data) ? std::make_shared<int>(-1) : begin->data;
+    });
+    session.addReducer("root", [&values](auto begin, auto end) {
+        for(auto it = begin; it != end; it++) {
+            if(it->data) {
+                values.push_back(*it->data);
+            }
+        }
+        return std::make_shared<int>((int)values.size());
+    });
+}
+
+// Records the value of the whole expression, as the only one.
+template<typename Session> void addPanicReducers(Session &session, const Parser::Grammar &grammar, std::vector<int> &values)
+{
+    Tests::addCalcReducers(session, grammar, [](int value) { return std::make_shared<int>(value); });
+
+    session.addReducer("root", [&values](auto begin, auto) {
+        values.push_back(*begin->data);
+        return begin->data;
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> statementReader = Tests::readDef(argc, argv, "Tests/recovery.def");
+    if(!statementReader) {
+        return 1;
+    }
+    std::unique_ptr<Parser::DefReader> calcReader = Tests::readCalcDef(argc, argv);
+    if(!calcReader) {
+        return 1;
+    }
+
+    unsigned int failures = 0;
+    std::vector<int> values;
+
+    for(const Parser::DefReader *reader : {statementReader.get(), calcReader.get()}) {
+        const std::vector<Case> &cases = (reader == statementReader.get()) ? kStatementCases : kPanicCases;
+        auto addReducers = [&](auto &session) {
+            if(reader == statementReader.get()) {
+                addStatementReducers(session, reader->grammar(), values);
+            } else {
+                addPanicReducers(session, reader->grammar(), values);
+            }
+            session.setRecovery(true);
+        };
+
+        Parser::Impl::LALR lalr(reader->grammar());
+        Parser::Impl::LALR::ParseSession<int, std::shared_ptr<int>> lalrSession(lalr);
+        addReducers(lalrSession);
+        failures += check("LALR", lalrSession, reader->tokenizer(), cases, values);
+
+        Parser::Impl::LL ll(reader->grammar());
+        Parser::Impl::LL::ParseSession<int, std::shared_ptr<int>> llSession(ll);
+        addReducers(llSession);
+        failures += check("LL", llSession, reader->tokenizer(), cases, values);
+    }
+
+    if(failures > 0) {
+        std::cout << failures << " recoveries differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
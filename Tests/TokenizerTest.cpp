@@ -0,0 +1,99 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Parser/DefReader.hpp"
+#include "Parser/Tokenizer.hpp"
+
+#include "Tests/Common.hpp"
+
+// Checks Tokenizer::tokenizeParallel against a sequential Stream over the same calculator input, for
+// one to eight threads.  Each token's value, line, start and text must match, up to and including the
+// END token, or the error token where the sequential stream stops.  The inputs have blank lines, one
+// ends without a newline, and one has an error token in a chunk after the first.
+//
+// Usage: tokenizertest <source dir>
+
+static std::vector<Parser::Tokenizer::Token> tokenize(const Parser::Tokenizer &tokenizer, std::string_view input)
+{
+    std::vector<Parser::Tokenizer::Token> tokens;
+    Parser::Tokenizer::Stream stream(tokenizer, input);
+    while(true) {
+        tokens.push_back(stream.nextToken());
+        if(stream.nextToken().value == tokenizer.endValue() || stream.nextToken().value == Parser::Tokenizer::kErrorTokenValue) {
+            break;
+        }
+        stream.consumeToken();
+    }
+
+    return tokens;
+}
+
+static std::string randomDocument(std::mt19937 &random)
+{
+    static const char *const kOperators[] = {"+", "-", "*", "/", " + ", "\n*", "\n\n-"};
+
+    std::string document = "(";
+    for(unsigned int i=0; i<2000; i++) {
+        document += (i == 0 ? "" : kOperators[random() % 7]) + std::to_string(random() % 1000);
+    }
+
+    return document + ")";
+}
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<Parser::DefReader> defReader = Tests::readCalcDef(argc, argv);
+    if(!defReader) {
+        return 1;
+    }
+    const Parser::Tokenizer &tokenizer = defReader->tokenizer();
+
+    std::mt19937 random(1);
+    std::string document = randomDocument(random);
+    std::string broken = document;
+    broken.insert(broken.rfind('\n', broken.size() * 3 / 4), "1 # 2");
+
+    struct Input {
+        const char *name;
+        std::string text;
+    };
+    const Input inputs[] = {
+        {"trailing newline", document + "\n"},
+        {"no trailing newline", document},
+        {"error token", broken + "\n"},
+        {"single line", "1+2*3"}
+    };
+
+    unsigned int failures = 0;
+    for(const Input &input : inputs) {
+        std::vector<Parser::Tokenizer::Token> expected = tokenize(tokenizer, input.text);
+        for(unsigned int threads=1; threads<=8; threads++) {
+            std::vector<Parser::Tokenizer::Token> actual = tokenizer.tokenizeParallel(input.text, threads);
+            size_t i = 0;
+            while(i < expected.size() && i < actual.size() && expected[i].value == actual[i].value && expected[i].line == actual[i].line && expected[i].start == actual[i].start && expected[i].text == actual[i].text) {
+                i++;
+            }
+
+            if(i < expected.size() || i < actual.size()) {
+                std::cout << input.name << ", " << threads << " threads: ";
+                if(i < expected.size() && i < actual.size()) {
+                    std::cout << "token " << i << " is \"" << actual[i].text << "\" on line " << actual[i].line << " at " << actual[i].start << ", expected \"" << expected[i].text << "\" on line " << expected[i].line << " at " << expected[i].start;
+                } else {
+                    std::cout << actual.size() << " tokens, expected " << expected.size();
+                }
+                std::cout << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    if(failures > 0) {
+        std::cout << failures << " tokenizations differ" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
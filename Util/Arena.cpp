@@ -0,0 +1,59 @@
+#include "Util/Arena.hpp"
+
+#include <algorithm>
+
+namespace Util
+{
+    Arena::Arena(size_t blockSize)
+    : mBlockSize(blockSize), mBlock(0), mOffset(0), mBytesAllocated(0), mDestructors(nullptr)
+    {
+    }
+
+    Arena::~Arena()
+    {
+        reset();
+    }
+
+    void *Arena::allocate(size_t size, size_t alignment)
+    {
+        while(true) {
+            if(mBlock < mBlocks.size()) {
+                Block &block = mBlocks[mBlock];
+                size_t offset = (mOffset + alignment - 1) & ~(alignment - 1);
+                if(offset + size <= block.size) {
+                    mOffset = offset + size;
+                    mBytesAllocated += size;
+                    return block.data.get() + offset;
+                }
+
+                if(mBlock + 1 < mBlocks.size()) {
+                    mBlock++;
+                    mOffset = 0;
+                    continue;
+                }
+            }
+
+            size_t blockSize = std::max(mBlockSize, size + alignment);
+            mBlocks.push_back(Block{std::make_unique<char[]>(blockSize), blockSize});
+            mBlock = mBlocks.size() - 1;
+            mOffset = 0;
+        }
+    }
+
+    void Arena::reset()
+    {
+        for(Destructor *destructor = mDestructors; destructor; destructor = destructor->next) {
+            destructor->destroy(destructor->object);
+        }
+        mDestructors = nullptr;
+
+        mBlock = 0;
+        mOffset = 0;
+        mBytesAllocated = 0;
+    }
+
+    size_t Arena::bytesAllocated() const
+    {
+        return mBytesAllocated;
+    }
+}
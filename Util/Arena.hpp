@@ -0,0 +1,66 @@
+#ifndef UTIL_ARENA_HPP
+#define UTIL_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Util
+{
+    // Monotonic allocator.  Memory is carved out of large blocks and only released in bulk by reset()
+    // or destruction; blocks are kept across resets so a reused arena stops allocating once it has
+    // grown to the size of a typical parse.  Objects which are not trivially destructible have their
+    // destructors recorded in the arena itself and run at reset.
+    class Arena
+    {
+    public:
+        Arena(size_t blockSize = 64 * 1024);
+        ~Arena();
+
+        Arena(const Arena &other) = delete;
+        Arena &operator=(const Arena &other) = delete;
+
+        void *allocate(size_t size, size_t alignment);
+        template<typename T, typename ...Args> T *make(Args&&... args);
+
+        void reset();
+        size_t bytesAllocated() const;
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        struct Destructor {
+            void (*destroy)(void *object);
+            void *object;
+            Destructor *next;
+        };
+
+        size_t mBlockSize;
+        std::vector<Block> mBlocks;
+        size_t mBlock;
+        size_t mOffset;
+        size_t mBytesAllocated;
+        Destructor *mDestructors;
+    };
+
+    template<typename T, typename ...Args> T *Arena::make(Args&&... args)
+    {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if(!std::is_trivially_destructible<T>::value) {
+            Destructor *destructor = new (allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+            destructor->destroy = [](void *object) { static_cast<T*>(object)->~T(); };
+            destructor->object = object;
+            destructor->next = mDestructors;
+            mDestructors = destructor;
+        }
+
+        return object;
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,145 @@
+#ifndef UTIL_BINARY_HPP
+#define UTIL_BINARY_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace Util
+{
+    constexpr uint32_t binaryTag(const char (&name)[5])
+    {
+        return (uint32_t)(unsigned char)name[0] | ((uint32_t)(unsigned char)name[1] << 8) | ((uint32_t)(unsigned char)name[2] << 16) | ((uint32_t)(unsigned char)name[3] << 24);
+    }
+
+    class BinaryWriter
+    {
+    public:
+        static const size_t kAlignment = 4;
+
+        template<typename T> void write(const T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "value must be trivially copyable");
+            append(&value, sizeof(T));
+        }
+
+        template<typename T> void write(const std::vector<T> &values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "values must be trivially copyable");
+            write((uint32_t)values.size());
+            append(values.data(), values.size() * sizeof(T));
+        }
+
+        void write(const std::string &string)
+        {
+            write((uint32_t)string.size());
+            append(string.data(), string.size());
+        }
+
+        const std::string &data() const
+        {
+            return mData;
+        }
+
+    private:
+        void append(const void *data, size_t size)
+        {
+            mData.append((const char*)data, size);
+            while(mData.size() % kAlignment != 0) {
+                mData.push_back(0);
+            }
+        }
+
+        std::string mData;
+    };
+
+    class BinaryReader
+    {
+    public:
+        BinaryReader(std::string_view data)
+        : mData(data), mPos(0), mValid(true)
+        {
+        }
+
+        bool valid() const
+        {
+            return mValid;
+        }
+
+        void invalidate()
+        {
+            mValid = false;
+        }
+
+        bool expect(uint32_t tag)
+        {
+            uint32_t value = 0;
+            read(value);
+            if(value != tag) {
+                mValid = false;
+            }
+            return mValid;
+        }
+
+        template<typename T> void read(T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "value must be trivially copyable");
+            extract(&value, sizeof(T));
+        }
+
+        template<typename T> void read(std::vector<T> &values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "values must be trivially copyable");
+            uint32_t size = 0;
+            read(size);
+            if(!mValid || size > (mData.size() - mPos) / sizeof(T)) {
+                mValid = false;
+                values.clear();
+                return;
+            }
+            values.resize(size);
+            extract(values.data(), size * sizeof(T));
+        }
+
+        void read(std::string &string)
+        {
+            uint32_t size = 0;
+            read(size);
+            if(!mValid || size > mData.size() - mPos) {
+                mValid = false;
+                string.clear();
+                return;
+            }
+            string.assign(mData.data() + mPos, size);
+            skip(size);
+        }
+
+    private:
+        void extract(void *data, size_t size)
+        {
+            if(!mValid || size > mData.size() - mPos) {
+                mValid = false;
+                std::memset(data, 0, size);
+                return;
+            }
+            std::memcpy(data, mData.data() + mPos, size);
+            skip(size);
+        }
+
+        void skip(size_t size)
+        {
+            mPos += (size + BinaryWriter::kAlignment - 1) / BinaryWriter::kAlignment * BinaryWriter::kAlignment;
+            if(mPos > mData.size()) {
+                mPos = mData.size();
+            }
+        }
+
+        std::string_view mData;
+        size_t mPos;
+        bool mValid;
+    };
+}
+#endif
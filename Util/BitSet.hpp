@@ -0,0 +1,114 @@
+#ifndef UTIL_BIT_SET_HPP
+#define UTIL_BIT_SET_HPP
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Util {
+
+    class BitSet
+    {
+    public:
+        BitSet()
+        : mSize(0)
+        {
+        }
+
+        BitSet(size_t size)
+        : mSize(size), mWords((size + 63) / 64, 0)
+        {
+        }
+
+        void resize(size_t size)
+        {
+            mSize = size;
+            mWords.resize((size + 63) / 64, 0);
+        }
+
+        size_t size() const
+        {
+            return mSize;
+        }
+
+        bool test(unsigned int bit) const
+        {
+            return (mWords[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        bool set(unsigned int bit)
+        {
+            uint64_t mask = (uint64_t)1 << (bit % 64);
+            if(mWords[bit / 64] & mask) {
+                return false;
+            }
+            mWords[bit / 64] |= mask;
+            return true;
+        }
+
+        bool add(const BitSet &other)
+        {
+            uint64_t changed = 0;
+            for(size_t i=0; i<mWords.size() && i<other.mWords.size(); i++) {
+                changed |= other.mWords[i] & ~mWords[i];
+                mWords[i] |= other.mWords[i];
+            }
+            return changed != 0;
+        }
+
+        bool intersects(const BitSet &other) const
+        {
+            for(size_t i=0; i<mWords.size() && i<other.mWords.size(); i++) {
+                if(mWords[i] & other.mWords[i]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool empty() const
+        {
+            for(uint64_t word : mWords) {
+                if(word != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool operator==(const BitSet &other) const
+        {
+            return mSize == other.mSize && mWords == other.mWords;
+        }
+
+        template<typename F> void forEach(F f) const
+        {
+            for(size_t i=0; i<mWords.size(); i++) {
+                uint64_t word = mWords[i];
+                while(word != 0) {
+                    f((unsigned int)(i * 64 + lowestBit(word)));
+                    word &= word - 1;
+                }
+            }
+        }
+
+    private:
+        static unsigned int lowestBit(uint64_t word)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, word);
+            return (unsigned int)index;
+#else
+            return (unsigned int)__builtin_ctzll(word);
+#endif
+        }
+
+        size_t mSize;
+        std::vector<uint64_t> mWords;
+    };
+}
+#endif
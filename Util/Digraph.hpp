@@ -0,0 +1,72 @@
+#ifndef UTIL_DIGRAPH_HPP
+#define UTIL_DIGRAPH_HPP
+
+#include "Util/BitSet.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace Util {
+
+    inline void propagateSets(const std::vector<std::vector<unsigned int>> &edges, std::vector<BitSet> &sets)
+    {
+        struct Frame {
+            unsigned int node;
+            unsigned int edge;
+            unsigned int depth;
+        };
+
+        std::vector<unsigned int> depths(sets.size(), 0);
+        std::vector<unsigned int> stack;
+        std::vector<Frame> frames;
+
+        auto visit = [&](unsigned int node) {
+            stack.push_back(node);
+            depths[node] = (unsigned int)stack.size();
+            frames.push_back(Frame{node, 0, depths[node]});
+        };
+
+        for(unsigned int root=0; root<sets.size(); root++) {
+            if(depths[root] != 0) {
+                continue;
+            }
+
+            visit(root);
+            while(frames.size() > 0) {
+                Frame &frame = frames.back();
+                unsigned int node = frame.node;
+                if(frame.edge < edges[node].size()) {
+                    unsigned int next = edges[node][frame.edge++];
+                    if(depths[next] == 0) {
+                        visit(next);
+                    } else {
+                        depths[node] = std::min(depths[node], depths[next]);
+                        sets[node].add(sets[next]);
+                    }
+                    continue;
+                }
+
+                if(depths[node] == frame.depth) {
+                    while(true) {
+                        unsigned int member = stack.back();
+                        stack.pop_back();
+                        depths[member] = UINT_MAX;
+                        if(member == node) {
+                            break;
+                        }
+                        sets[member] = sets[node];
+                    }
+                }
+
+                frames.pop_back();
+                if(frames.size() > 0) {
+                    unsigned int parent = frames.back().node;
+                    depths[parent] = std::min(depths[parent], depths[node]);
+                    sets[parent].add(sets[node]);
+                }
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,222 @@
+#ifndef UTIL_GRAPH_STACK_HPP
+#define UTIL_GRAPH_STACK_HPP
+
+#include <climits>
+#include <unordered_map>
+#include <vector>
+
+namespace Util
+{
+    // Graph-structured stack in the style of Tomita.  Nodes carry a parser state and the input level at
+    // which they were created; edges point from a node to the node beneath it and carry the data for
+    // the symbol between them.  Nodes and edges live in flat arrays and are addressed by index, so
+    // nothing is freed until clear().  Edge indices increase monotonically, which lets callers restrict
+    // path enumeration to edges that existed at a given point in time.
+    template<typename T> class GraphStack
+    {
+    public:
+        static constexpr unsigned int kNone = UINT_MAX;
+
+        GraphStack();
+
+        void clear();
+
+        unsigned int addNode(unsigned int state, unsigned int level);
+        unsigned int addEdge(unsigned int from, unsigned int to, T data);
+
+        unsigned int numNodes() const;
+        unsigned int numEdges() const;
+
+        unsigned int state(unsigned int node) const;
+        unsigned int level(unsigned int node) const;
+
+        unsigned int findEdge(unsigned int from, unsigned int to) const;
+        unsigned int edgeTarget(unsigned int edge) const;
+        T &edgeData(unsigned int edge);
+        const T &edgeData(unsigned int edge) const;
+
+        // Calls f(end, edges) for every path of the given length starting at node and using only edges
+        // with index below edgeLimit.  edges points at the path's edges ordered from node downward and is
+        // only valid until f adds to the stack.
+        template<typename F> void forEachPath(unsigned int node, size_t length, unsigned int edgeLimit, F f);
+
+        // As forEachPath, but only enumerates paths which pass through the given edge, with every other
+        // edge on the path older than it.
+        template<typename F> void forEachPathThrough(unsigned int node, size_t length, unsigned int edge, F f);
+
+    private:
+        struct Node {
+            unsigned int state;
+            unsigned int level;
+            unsigned int firstEdge;
+        };
+
+        struct Edge {
+            unsigned int source;
+            unsigned int target;
+            unsigned int next;
+            T data;
+        };
+
+        template<typename F> void enumeratePaths(unsigned int node, size_t length, unsigned int edgeLimit, unsigned int requiredEdge, F f);
+
+        std::vector<Node> mNodes;
+        std::vector<Edge> mEdges;
+        std::unordered_map<unsigned long long, unsigned int> mEdgeIndices;
+        std::vector<unsigned int> mPath;
+    };
+
+    template<typename T> GraphStack<T>::GraphStack()
+    {
+    }
+
+    template<typename T> void GraphStack<T>::clear()
+    {
+        mNodes.clear();
+        mEdges.clear();
+        mEdgeIndices.clear();
+        mPath.clear();
+    }
+
+    template<typename T> unsigned int GraphStack<T>::addNode(unsigned int state, unsigned int level)
+    {
+        mNodes.push_back(Node{state, level, kNone});
+        return (unsigned int)(mNodes.size() - 1);
+    }
+
+    template<typename T> unsigned int GraphStack<T>::addEdge(unsigned int from, unsigned int to, T data)
+    {
+        unsigned int edge = (unsigned int)mEdges.size();
+        mEdges.push_back(Edge{from, to, mNodes[from].firstEdge, std::move(data)});
+        mNodes[from].firstEdge = edge;
+        mEdgeIndices.emplace(((unsigned long long)from << 32) | to, edge);
+        return edge;
+    }
+
+    template<typename T> unsigned int GraphStack<T>::numNodes() const
+    {
+        return (unsigned int)mNodes.size();
+    }
+
+    template<typename T> unsigned int GraphStack<T>::numEdges() const
+    {
+        return (unsigned int)mEdges.size();
+    }
+
+    template<typename T> unsigned int GraphStack<T>::state(unsigned int node) const
+    {
+        return mNodes[node].state;
+    }
+
+    template<typename T> unsigned int GraphStack<T>::level(unsigned int node) const
+    {
+        return mNodes[node].level;
+    }
+
+    template<typename T> unsigned int GraphStack<T>::findEdge(unsigned int from, unsigned int to) const
+    {
+        // A node can have an edge to every node below it, so edges are found by hash rather than by
+        // walking the node's list.
+        auto it = mEdgeIndices.find(((unsigned long long)from << 32) | to);
+        if(it != mEdgeIndices.end()) {
+            return it->second;
+        }
+
+        return kNone;
+    }
+
+    template<typename T> unsigned int GraphStack<T>::edgeTarget(unsigned int edge) const
+    {
+        return mEdges[edge].target;
+    }
+
+    template<typename T> T &GraphStack<T>::edgeData(unsigned int edge)
+    {
+        return mEdges[edge].data;
+    }
+
+    template<typename T> const T &GraphStack<T>::edgeData(unsigned int edge) const
+    {
+        return mEdges[edge].data;
+    }
+
+    template<typename T> template<typename F> void GraphStack<T>::forEachPath(unsigned int node, size_t length, unsigned int edgeLimit, F f)
+    {
+        enumeratePaths(node, length, edgeLimit, kNone, f);
+    }
+
+    template<typename T> template<typename F> void GraphStack<T>::forEachPathThrough(unsigned int node, size_t length, unsigned int edge, F f)
+    {
+        if(length == 0) {
+            return;
+        }
+
+        enumeratePaths(node, length, edge + 1, edge, f);
+    }
+
+    template<typename T> template<typename F> void GraphStack<T>::enumeratePaths(unsigned int node, size_t length, unsigned int edgeLimit, unsigned int requiredEdge, F f)
+    {
+        if(length == 0) {
+            f(node, (const unsigned int*)nullptr);
+            return;
+        }
+
+        // The path is kept on mPath above base, so that enumerations started from within f nest
+        // without disturbing this one.  Edges only ever point to the same or an earlier level, so once
+        // the path drops below the required edge's level without having used it, it never will.
+        unsigned int requiredLevel = (requiredEdge == kNone) ? 0 : mNodes[mEdges[requiredEdge].source].level;
+        unsigned int requiredCount = 0;
+        size_t base = mPath.size();
+
+        auto advance = [&](unsigned int edge) {
+            edge = mEdges[edge].next;
+            while(edge != kNone && edge >= edgeLimit) {
+                edge = mEdges[edge].next;
+            }
+            return edge;
+        };
+
+        auto first = [&](unsigned int from) {
+            unsigned int edge = mNodes[from].firstEdge;
+            while(edge != kNone && edge >= edgeLimit) {
+                edge = mEdges[edge].next;
+            }
+            return edge;
+        };
+
+        mPath.push_back(first(node));
+        while(mPath.size() > base) {
+            unsigned int edge = mPath.back();
+            if(edge == kNone) {
+                mPath.pop_back();
+                if(mPath.size() > base) {
+                    if(mPath.back() == requiredEdge) {
+                        requiredCount--;
+                    }
+                    mPath.back() = advance(mPath.back());
+                }
+                continue;
+            }
+
+            if(edge == requiredEdge) {
+                requiredCount++;
+            }
+
+            size_t depth = mPath.size() - base;
+            unsigned int target = mEdges[edge].target;
+            bool viable = (requiredEdge == kNone || requiredCount > 0 || mNodes[target].level >= requiredLevel);
+            if(depth == length || !viable) {
+                if(depth == length && (requiredEdge == kNone || requiredCount > 0)) {
+                    f(target, &mPath[base]);
+                }
+                if(mPath.back() == requiredEdge) {
+                    requiredCount--;
+                }
+                mPath.back() = advance(mPath.back());
+            } else {
+                mPath.push_back(first(target));
+            }
+        }
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "Util/MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Util
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &filename)
+    {
+        mData = nullptr;
+        mSize = 0;
+        mValid = false;
+        mMapping = nullptr;
+
+        mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(mFile == INVALID_HANDLE_VALUE) {
+            mFile = nullptr;
+            return;
+        }
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(mFile, &size)) {
+            return;
+        }
+        mSize = (size_t)size.QuadPart;
+        mValid = true;
+
+        if(mSize == 0) {
+            return;
+        }
+
+        mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(!mMapping) {
+            mSize = 0;
+            mValid = false;
+            return;
+        }
+
+        mData = (const char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+        if(!mData) {
+            mSize = 0;
+            mValid = false;
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if(mData) {
+            UnmapViewOfFile(mData);
+        }
+        if(mMapping) {
+            CloseHandle(mMapping);
+        }
+        if(mFile) {
+            CloseHandle(mFile);
+        }
+    }
+#else
+    MappedFile::MappedFile(const std::string &filename)
+    {
+        mData = nullptr;
+        mSize = 0;
+        mValid = false;
+
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) == 0) {
+            mSize = (size_t)st.st_size;
+            mValid = true;
+
+            if(mSize > 0) {
+                void *data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(data == MAP_FAILED) {
+                    mSize = 0;
+                    mValid = false;
+                } else {
+                    mData = (const char*)data;
+                }
+            }
+        }
+
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if(mData) {
+            munmap((void*)mData, mSize);
+        }
+    }
+#endif
+
+    bool MappedFile::valid() const
+    {
+        return mValid;
+    }
+
+    std::string_view MappedFile::data() const
+    {
+        return std::string_view(mData ? mData : "", mSize);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef UTIL_MAPPED_FILE_HPP
+#define UTIL_MAPPED_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace Util
+{
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string &filename);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile &operator=(const MappedFile &other) = delete;
+
+        bool valid() const;
+        std::string_view data() const;
+
+    private:
+        const char *mData;
+        size_t mSize;
+        bool mValid;
+#ifdef _WIN32
+        void *mFile;
+        void *mMapping;
+#endif
+    };
+}
+#endif
@@ -1,6 +1,8 @@
 #ifndef UTIL_TABLE_HPP
 #define UTIL_TABLE_HPP
 
+#include "Util/Binary.hpp"
+
 #include <vector>
 
 namespace Util {
@@ -25,6 +27,16 @@ namespace Util {
             mData.resize(width * height, defaultValue);
         }
 
+        size_t width() const
+        {
+            return mWidth;
+        }
+
+        size_t height() const
+        {
+            return mHeight;
+        }
+
         const T &at(unsigned int x, unsigned int y) const
         {
             return mData[y*mWidth + x];
@@ -34,6 +46,29 @@ namespace Util {
         {
             return mData[y*mWidth + x];
         }
+
+        void save(BinaryWriter &writer) const
+        {
+            writer.write((uint64_t)mWidth);
+            writer.write((uint64_t)mHeight);
+            writer.write(mData);
+        }
+
+        void load(BinaryReader &reader)
+        {
+            uint64_t width = 0;
+            uint64_t height = 0;
+            reader.read(width);
+            reader.read(height);
+            reader.read(mData);
+            if(mData.size() != width * height) {
+                reader.invalidate();
+                width = height = 0;
+                mData.clear();
+            }
+            mWidth = (size_t)width;
+            mHeight = (size_t)height;
+        }
     
     private:
         size_t mWidth;